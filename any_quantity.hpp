@@ -0,0 +1,353 @@
+#pragma once
+
+#include "conversion_factor.hpp"
+#include "derived_dimensions_impl.hpp"
+#include "quantity.hpp"
+#include "quantity_cast.hpp"
+
+#include <cstdint>
+#include <ratio>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+// ************************************************************************* /
+//    A Quantity whose units are only known at runtime, e.g. read from a     /
+//    configuration file. It is 16 bytes: a double and the dimensions packed /
+//    into a 64-bit code, so checking the dimensions of an addition is one   /
+//    integer compare and multiplying two is one (SWAR) integer add.         /
+// ************************************************************************* /
+
+namespace units {
+  namespace Impl {
+    /** The packed code has one signed byte per base dimension, holding the
+     * exponent in twelfths (so halves, thirds and quarters are exact, and
+     * exponents range from -10 to 10), in the order of DimensionCode, and
+     * a final byte holding the decimal exponent of the prefix, so km is
+     * length 12 and prefix 3. */
+    constexpr int exponent_scale = 12;
+    constexpr auto high_bits = std::uint64_t{0x8080808080808080};
+    constexpr auto low_bits = ~high_bits;
+    constexpr auto prefix_shift = 56;
+    constexpr auto dimension_bits = (std::uint64_t{1} << prefix_shift) - 1;
+
+    /// The sum of each of the signed bytes of a and b, sets overflow if any
+    /// of them over or underflow. Bytes don't carry into their neighbours.
+    constexpr std::uint64_t packed_add(std::uint64_t a, std::uint64_t b,
+                                       bool& overflow) {
+      const auto r = ((a & low_bits) + (b & low_bits)) ^ ((a ^ b) & high_bits);
+      overflow = overflow || (~(a ^ b) & (a ^ r) & high_bits) != 0;
+      return r;
+    }
+
+    constexpr std::uint64_t packed_subtract(std::uint64_t a, std::uint64_t b,
+                                            bool& overflow) {
+      const auto r =
+          ((a | high_bits) - (b & low_bits)) ^ ((a ^ ~b) & high_bits);
+      overflow = overflow || ((a ^ b) & (a ^ r) & high_bits) != 0;
+      return r;
+    }
+
+    constexpr int packed_byte(std::uint64_t code, int i) {
+      return static_cast<std::int8_t>((code >> (8 * i)) & 0xFF);
+    }
+
+    constexpr bool pack_byte(std::intmax_t v, int i, std::uint64_t& code) {
+      if (v < -127 || v > 127) {
+        return false;
+      }
+      code |= (static_cast<std::uint64_t>(v) & 0xFF) << (8 * i);
+      return true;
+    }
+
+    /// k if r is 10^k, otherwise false
+    constexpr bool decimal_exponent(const PrefixValue& r, std::intmax_t& k) {
+      if (r.num <= 0) {
+        return false;
+      }
+      auto n = r.num;
+      auto d = r.den;
+      k = r.exponent;
+      for (; n % 10 == 0; n /= 10) {
+        ++k;
+      }
+      for (; d % 10 == 0; d /= 10) {
+        --k;
+      }
+      return n == 1 && d == 1;
+    }
+
+    /** Pack the exponents of code, and its prefix if it's a power of ten
+     * (otherwise the packed prefix is 0 and the caller has to scale the
+     * value). False if an exponent isn't a multiple of 1/12 or is too big. */
+    constexpr bool pack(const DimensionCode& code, std::uint64_t& packed,
+                        bool& decimal_prefix) {
+      const Rational exponents[] = {
+          code.length,      code.mass,   code.time,      code.current,
+          code.temperature, code.amount, code.luminosity};
+      packed = 0;
+      for (auto i = 0; i < 7; ++i) {
+        const auto& e = exponents[i];
+        if (exponent_scale % e.den != 0 ||
+            !pack_byte(e.num * (exponent_scale / e.den), i, packed)) {
+          return false;
+        }
+      }
+      auto k = std::intmax_t{};
+      decimal_prefix =
+          decimal_exponent(code.prefix, k) && pack_byte(k, 7, packed);
+      return true;
+    }
+
+    constexpr DimensionCode unpack(std::uint64_t packed) {
+      const auto e = [packed](int i) {
+        return Rational{packed_byte(packed, i), exponent_scale};
+      };
+      const auto prefix = PrefixValue{1, 1, packed_byte(packed, 7)};
+      return {e(0), e(1), e(2), e(3), e(4), e(5), e(6), prefix};
+    }
+
+    /// The packed code of the compile time Units, which must be
+    /// representable.
+    template <class Units>
+    constexpr std::uint64_t packed_code() {
+      constexpr auto result = [] {
+        auto packed = std::uint64_t{};
+        auto decimal = false;
+        const auto ok = pack(Units::code, packed, decimal);
+        return std::pair{ok, packed};
+      }();
+      static_assert(result.first, "AnyQuantity can only hold exponents that "
+                                  "are multiples of 1/12, from -10 to 10");
+      return result.second;
+    }
+
+    /// v * 10^k, exact for |k| <= 22 (before rounding the result)
+    constexpr double times_power_of_ten(double v, int k) {
+      constexpr double powers[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,
+                                   1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+                                   1e12, 1e13, 1e14, 1e15, 1e16, 1e17,
+                                   1e18, 1e19, 1e20, 1e21, 1e22};
+      for (; k > 22; k -= 22) {
+        v *= powers[22];
+      }
+      for (; k < -22; k += 22) {
+        v /= powers[22];
+      }
+      return k >= 0 ? v * powers[k] : v / powers[-k];
+    }
+  } // namespace Impl
+
+  /** A double with units that are only known at runtime. Converts
+   * implicitly from any double Quantity and back with as<Quantity>(), which
+   * leaves the value unchanged if the prefixes are the same power of ten.
+   * Quantities with other prefixes (e.g. minutes) are converted to SI.
+   * Operations on AnyQuantities with the wrong dimensions throw
+   * std::invalid_argument, as there is no compile time check to fall back
+   * on. */
+  class AnyQuantity {
+  public:
+    constexpr AnyQuantity() = default;
+
+    template <class Units, class Tag>
+    constexpr AnyQuantity(const Quantity<Units, double, Tag>& q) noexcept
+        : _val{q.underlying_value()}, _code{Impl::packed_code<Units>()} {
+      if constexpr (!decimal_prefix<Units>()) {
+        _val = units::scale_by<typename Units::prefix>(_val);
+      }
+    }
+
+    /** From a value and a runtime DimensionCode, e.g. from parse_unit.
+     * Throws std::invalid_argument if an exponent can't be packed. */
+    AnyQuantity(double value, const DimensionCode& code) : _val{value} {
+      auto decimal = false;
+      if (!Impl::pack(code, _code, decimal)) {
+        throw std::invalid_argument("AnyQuantity can only hold exponents "
+                                    "that are multiples of 1/12, from -10 "
+                                    "to 10");
+      }
+      if (!decimal) {
+        _val *= Impl::rounded_prefix<double>(code.prefix);
+      }
+    }
+
+    constexpr double underlying_value() const noexcept { return _val; }
+
+    /// The packed dimensions and prefix
+    constexpr std::uint64_t code() const noexcept { return _code; }
+
+    /// The unpacked dimensions and prefix, e.g. to compare with parse_unit
+    constexpr DimensionCode dimension_code() const {
+      return Impl::unpack(_code);
+    }
+
+    /// The decimal exponent of the prefix, e.g. 3 for km
+    constexpr int prefix_exponent() const noexcept {
+      return Impl::packed_byte(_code, 7);
+    }
+
+    constexpr bool same_dimension(const AnyQuantity& o) const noexcept {
+      return ((_code ^ o._code) & Impl::dimension_bits) == 0;
+    }
+
+    /// The value in the SI units, i.e. without the prefix
+    constexpr double underlying_value_no_prefix() const noexcept {
+      return Impl::times_power_of_ten(_val, prefix_exponent());
+    }
+
+    /** Convert to the static Quantity Q, throws std::invalid_argument if the
+     * dimensions are different. */
+    template <class Q>
+    constexpr Q as() const {
+      using Units = typename Impl::quantity_traits<Q>::Units;
+      static_assert(
+          std::is_same_v<typename Impl::quantity_traits<Q>::BaseType, double>);
+      constexpr auto packed = Impl::packed_code<Units>();
+      if (((_code ^ packed) & Impl::dimension_bits) != 0) {
+        throw std::invalid_argument("AnyQuantity has different dimensions");
+      }
+      if constexpr (!decimal_prefix<Units>()) {
+        using Inverse =
+            Impl::prefix_type_t<PrefixValue{1} / Units::code.prefix>;
+        return Q{units::scale_by<Inverse>(underlying_value_no_prefix())};
+      } else {
+        return Q{Impl::times_power_of_ten(_val, prefix_exponent() -
+                                                    Impl::packed_byte(
+                                                        packed, 7))};
+      }
+    }
+
+    AnyQuantity& operator+=(const AnyQuantity& o) {
+      _val += o.rescaled_to(*this);
+      return *this;
+    }
+
+    AnyQuantity& operator-=(const AnyQuantity& o) {
+      _val -= o.rescaled_to(*this);
+      return *this;
+    }
+
+    AnyQuantity& operator*=(const AnyQuantity& o) {
+      _code = combine(_code, o._code, false);
+      _val *= o._val;
+      return *this;
+    }
+
+    AnyQuantity& operator/=(const AnyQuantity& o) {
+      _code = combine(_code, o._code, true);
+      _val /= o._val;
+      return *this;
+    }
+
+    constexpr AnyQuantity& operator*=(double d) noexcept {
+      _val *= d;
+      return *this;
+    }
+
+    constexpr AnyQuantity& operator/=(double d) noexcept {
+      _val /= d;
+      return *this;
+    }
+
+    constexpr AnyQuantity operator-() const noexcept {
+      auto q = *this;
+      q._val = -q._val;
+      return q;
+    }
+
+    /// The inverse, 1 / q
+    AnyQuantity inverse() const {
+      auto q = AnyQuantity{};
+      q._code = combine(0, _code, true);
+      q._val = 1 / _val;
+      return q;
+    }
+
+    /** The value of o in the prefix of to, throws std::invalid_argument if
+     * they have different dimensions. */
+    constexpr double rescaled_to(const AnyQuantity& to) const {
+      if (_code == to._code) {
+        return _val;
+      }
+      if (!same_dimension(to)) {
+        throw std::invalid_argument("adding or comparing AnyQuantities with "
+                                    "different dimensions");
+      }
+      return Impl::times_power_of_ten(_val, prefix_exponent() -
+                                                to.prefix_exponent());
+    }
+
+  private:
+    double _val = 0;
+    std::uint64_t _code = 0;
+
+    /// True if the prefix of Units is packed, rather than scaled to SI
+    template <class Units>
+    static constexpr bool decimal_prefix() {
+      auto packed = std::uint64_t{};
+      auto decimal = false;
+      Impl::pack(Units::code, packed, decimal);
+      return decimal;
+    }
+
+    static std::uint64_t combine(std::uint64_t a, std::uint64_t b,
+                                 bool divide) {
+      auto overflow = false;
+      const auto code = divide ? Impl::packed_subtract(a, b, overflow)
+                               : Impl::packed_add(a, b, overflow);
+      if (overflow) {
+        throw std::invalid_argument("AnyQuantity exponent or prefix out of "
+                                    "range");
+      }
+      return code;
+    }
+  };
+
+  static_assert(sizeof(AnyQuantity) == 16);
+
+  inline AnyQuantity operator+(AnyQuantity a, const AnyQuantity& b) {
+    return a += b;
+  }
+
+  inline AnyQuantity operator-(AnyQuantity a, const AnyQuantity& b) {
+    return a -= b;
+  }
+
+  inline AnyQuantity operator*(AnyQuantity a, const AnyQuantity& b) {
+    return a *= b;
+  }
+
+  inline AnyQuantity operator/(AnyQuantity a, const AnyQuantity& b) {
+    return a /= b;
+  }
+
+  inline AnyQuantity operator*(AnyQuantity a, double b) { return a *= b; }
+
+  inline AnyQuantity operator*(double b, AnyQuantity a) { return a *= b; }
+
+  inline AnyQuantity operator/(AnyQuantity a, double b) { return a /= b; }
+
+  inline bool operator==(const AnyQuantity& a, const AnyQuantity& b) {
+    return b.rescaled_to(a) == a.underlying_value();
+  }
+
+  inline bool operator!=(const AnyQuantity& a, const AnyQuantity& b) {
+    return !(a == b);
+  }
+
+  inline bool operator<(const AnyQuantity& a, const AnyQuantity& b) {
+    return a.underlying_value() < b.rescaled_to(a);
+  }
+
+  inline bool operator<=(const AnyQuantity& a, const AnyQuantity& b) {
+    return a.underlying_value() <= b.rescaled_to(a);
+  }
+
+  inline bool operator>(const AnyQuantity& a, const AnyQuantity& b) {
+    return a.underlying_value() > b.rescaled_to(a);
+  }
+
+  inline bool operator>=(const AnyQuantity& a, const AnyQuantity& b) {
+    return a.underlying_value() >= b.rescaled_to(a);
+  }
+} // namespace units
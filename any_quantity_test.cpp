@@ -0,0 +1,134 @@
+#include "any_quantity.hpp"
+#include "common_quantities.hpp"
+#include "unit_parser.hpp"
+#include <catch.hpp>
+
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+SCENARIO("AnyQuantity holds a Quantity whose units are known at runtime") {
+  using namespace units;
+  GIVEN("static Quantities") {
+    THEN("they convert to AnyQuantity and back without changing the value") {
+      const auto a = AnyQuantity{km{0.1}};
+      REQUIRE(a.underlying_value() == 0.1);
+      REQUIRE(a.prefix_exponent() == 3);
+      REQUIRE(a.as<km>().underlying_value() == 0.1);
+      REQUIRE(AnyQuantity{MPam05{1.0 / 3}}.as<MPam05>() == MPam05{1.0 / 3});
+      REQUIRE(AnyQuantity{nanoseconds{7}}.as<nanoseconds>() ==
+              nanoseconds{7});
+    }
+    THEN("they convert to other prefixes of the same dimension") {
+      REQUIRE(AnyQuantity{km{1.5}}.as<metres>().underlying_value() == 1500);
+      REQUIRE(AnyQuantity{mm{1500}}.as<metres>().underlying_value() == 1.5);
+      REQUIRE(AnyQuantity{hours{1}}.as<minutes>().underlying_value() == 60);
+      REQUIRE(AnyQuantity{minutes{2}}.underlying_value() == 120);
+      REQUIRE(AnyQuantity{minutes{2}}.prefix_exponent() == 0);
+    }
+    THEN("converting to different dimensions throws") {
+      REQUIRE_THROWS_AS(AnyQuantity{km{1}}.as<seconds>(),
+                        std::invalid_argument);
+    }
+  }
+
+  GIVEN("the packed code") {
+    THEN("it matches the DimensionCode it was made from") {
+      REQUIRE(AnyQuantity{km{1}}.dimension_code() == km_t::code);
+      REQUIRE(AnyQuantity{Joules{1}}.dimension_code() == Joules_t::code);
+      REQUIRE(AnyQuantity{MPam05{1}}.dimension_code() == MPam05_t::code);
+      REQUIRE(AnyQuantity{}.code() == 0);
+      REQUIRE(sizeof(AnyQuantity) == 16);
+    }
+    THEN("it can be made from a parsed unit string") {
+      const auto a = AnyQuantity{36, parse_unit("km/h").code};
+      REQUIRE(a.as<metres_per_sec>().underlying_value() == 10);
+      REQUIRE(AnyQuantity{2, parse_unit("mm").code}.as<mm>() == mm{2});
+      REQUIRE_THROWS_AS((AnyQuantity{1, parse_unit("m^(1/5)").code}),
+                        std::invalid_argument);
+      REQUIRE_THROWS_AS((AnyQuantity{1, parse_unit("m^11").code}),
+                        std::invalid_argument);
+    }
+  }
+
+  GIVEN("arithmetic on AnyQuantities") {
+    const auto length = AnyQuantity{km{2}};
+    const auto time = AnyQuantity{seconds{4}};
+    THEN("multiplying and dividing combine the dimensions") {
+      const auto speed = length / time;
+      REQUIRE(speed.dimension_code() == parse_unit("km/s").code);
+      REQUIRE(speed.as<metres_per_sec>().underlying_value() == 500);
+      REQUIRE((speed * time).as<km>() == km{2});
+      REQUIRE((length * length).as<metres2>().underlying_value() == 4e6);
+      REQUIRE(time.inverse().as<per_second>().underlying_value() == 0.25);
+      REQUIRE((length * 3).as<km>() == km{6});
+      REQUIRE((length / 2).as<km>() == km{1});
+      REQUIRE((length / length).code() == 0);
+    }
+    THEN("adding rescales to the prefix of the left hand side") {
+      const auto sum = length + AnyQuantity{metres{500}};
+      REQUIRE(sum.prefix_exponent() == 3);
+      REQUIRE(sum.underlying_value() == 2.5);
+      REQUIRE((AnyQuantity{metres{500}} + length).underlying_value() == 2500);
+      REQUIRE((length - AnyQuantity{metres{500}}).as<km>() == km{1.5});
+      REQUIRE((-length).as<km>() == km{-2});
+    }
+    THEN("comparisons rescale too") {
+      REQUIRE(length == AnyQuantity{metres{2000}});
+      REQUIRE(length != AnyQuantity{metres{2001}});
+      REQUIRE(length < AnyQuantity{metres{2001}});
+      REQUIRE(length <= AnyQuantity{metres{2000}});
+      REQUIRE(length > AnyQuantity{mm{1}});
+      REQUIRE(length >= AnyQuantity{km{2}});
+    }
+    THEN("different dimensions throw") {
+      REQUIRE_THROWS_AS(length + time, std::invalid_argument);
+      REQUIRE_THROWS_AS(length < time, std::invalid_argument);
+      REQUIRE(!length.same_dimension(time));
+    }
+    THEN("exponents that overflow throw") {
+      auto q = AnyQuantity{metres{2}};
+      for (auto i = 0; i < 9; ++i) {
+        q *= AnyQuantity{metres{2}};
+      }
+      REQUIRE(q.dimension_code().length == Rational{10});
+      REQUIRE_THROWS_AS(q * length, std::invalid_argument);
+      REQUIRE_THROWS_AS(q.inverse() / length, std::invalid_argument);
+    }
+  }
+
+  GIVEN("the packed arithmetic") {
+    THEN("bytes add and subtract without carrying into each other") {
+      auto overflow = false;
+      const auto minus_one = std::uint64_t{0xFF};
+      const auto one = std::uint64_t{0x0101};
+      REQUIRE(Impl::packed_add(minus_one, one, overflow) == 0x0100);
+      REQUIRE(Impl::packed_subtract(0, one, overflow) == 0xFFFF);
+      REQUIRE(Impl::packed_subtract(0x0100, one, overflow) == minus_one);
+      REQUIRE(!overflow);
+      Impl::packed_add(0x7F, 1, overflow);
+      REQUIRE(overflow);
+      overflow = false;
+      Impl::packed_subtract(0x80, 1, overflow);
+      REQUIRE(overflow);
+    }
+  }
+}
+
+SCENARIO("Profiling AnyQuantity", "[Profile]") {
+  GIVEN("a column of lengths and a column of times") {
+    auto lengths = std::vector<units::AnyQuantity>{};
+    auto times = std::vector<units::AnyQuantity>{};
+    for (auto i = 0; i < 100'000; ++i) {
+      lengths.push_back(km{i * 0.5});
+      times.push_back(seconds{i + 1.0});
+    }
+    auto total = units::AnyQuantity{metres_per_sec{0}};
+    BENCHMARK("divide and add") {
+      for (auto i = 0u; i < lengths.size(); ++i) {
+        total += lengths[i] / times[i];
+      }
+    }
+    std::cout << total.underlying_value() << "\n";
+  }
+}
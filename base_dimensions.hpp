@@ -1,7 +1,6 @@
 #pragma once
 
 #include "prefixes.hpp"
-#include <boost/hana.hpp>
 #include <ratio>
 #include <type_traits>
 
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// ************************************************************************* /
+//    A minimal timing harness for the runtime benchmarks, so they build     /
+//    without fetching a benchmark library.                                  /
+// ************************************************************************* /
+
+namespace units::bench {
+  /// Stop the optimiser assuming it knows value, or that value is unused.
+  /// Forces value through memory, a register alternative ("+m,r") is
+  /// miscompiled by GCC 12 for doubles at -O1 and above.
+  template <class T>
+  inline void do_not_optimise(T& value) {
+#if defined(__GNUC__)
+    asm volatile("" : "+m"(value) : : "memory");
+#else
+    auto volatile sink = value;
+    static_cast<void>(sink);
+#endif
+  }
+
+  template <class T>
+  inline void do_not_optimise(const T& value) {
+#if defined(__GNUC__)
+    asm volatile("" : : "m"(value) : "memory");
+#else
+    auto volatile sink = value;
+    static_cast<void>(sink);
+#endif
+  }
+
+  struct Result {
+    std::string name;
+    double ns_per_op;
+    double gb_per_s;
+  };
+
+  struct Options {
+    /// Minimum time for each sample, the iteration count is doubled until a
+    /// sample takes at least this long.
+    std::chrono::nanoseconds min_sample_time = std::chrono::milliseconds{10};
+    /// Number of samples, the fastest is reported.
+    int samples = 5;
+  };
+
+  /** Time f, which does ops_per_call operations and touches bytes_per_call
+   * bytes of memory on each call, and return the fastest of the samples in
+   * nanoseconds per operation and GB/s. */
+  template <class F>
+  Result run(std::string name, std::size_t ops_per_call,
+             std::size_t bytes_per_call, F&& f, const Options& options = {}) {
+    using clock = std::chrono::steady_clock;
+    auto time = [&f](std::size_t iterations) {
+      const auto start = clock::now();
+      for (std::size_t i = 0; i < iterations; ++i) {
+        f();
+      }
+      return clock::now() - start;
+    };
+
+    auto iterations = std::size_t{1};
+    while (time(iterations) < options.min_sample_time) {
+      iterations *= 2;
+    }
+    auto best = std::numeric_limits<double>::infinity();
+    for (auto s = 0; s < options.samples; ++s) {
+      const auto ns =
+          std::chrono::duration<double, std::nano>(time(iterations));
+      best = std::min(best, ns.count() / static_cast<double>(iterations));
+    }
+    const auto ns_per_op = best / static_cast<double>(ops_per_call);
+    // bytes per nanosecond is GB/s
+    const auto gb_per_s = static_cast<double>(bytes_per_call) / best;
+    return {std::move(name), ns_per_op, gb_per_s};
+  }
+
+  /// Prints pairs of results side by side, with the ratio of their times.
+  class Reporter {
+  public:
+    explicit Reporter(std::string_view filter = {}) : _filter{filter} {}
+
+    bool enabled(std::string_view name) const {
+      return _filter.empty() || name.find(_filter) != std::string_view::npos;
+    }
+
+    void header() const {
+      std::printf("%-40s %12s %10s %12s %10s %8s\n", "benchmark",
+                  "Quantity ns", "GB/s", "double ns", "GB/s", "ratio");
+    }
+
+    void compare(const Result& quantity, const Result& raw) {
+      std::printf("%-40s %12.3f %10.2f %12.3f %10.2f %8.2f\n",
+                  quantity.name.c_str(), quantity.ns_per_op, quantity.gb_per_s,
+                  raw.ns_per_op, raw.gb_per_s,
+                  quantity.ns_per_op / raw.ns_per_op);
+      _results.push_back(quantity);
+      _results.push_back(raw);
+    }
+
+    const std::vector<Result>& results() const { return _results; }
+
+  private:
+    std::string _filter;
+    std::vector<Result> _results;
+  };
+} // namespace units::bench
@@ -0,0 +1,119 @@
+// Pairs of kernels, one written with Quantities and one with doubles, that
+// codegen_test.py compiles and disassembles to check that the Quantity
+// versions generate the same instructions. The kernels are extern "C" so
+// their symbols are easy to find, and each pair must be the same calculation
+// in the same order, e.g. pow<3>(a) is a * (a * a).
+//
+// Loops after a "// loop: <function>" comment are checked for vectorisation,
+// the Quantity loop must be vectorised whenever the double one is.
+
+#include "common_quantities.hpp"
+#include "numeric_functions.hpp"
+
+#include <cmath>
+#include <cstddef>
+
+extern "C" {
+// Kinetic energy, 0.5 m v^2
+Joules quantity_kinetic_energy(kg m, metres_per_sec v) {
+  return 0.5 * m * v * v;
+}
+double double_kinetic_energy(double m, double v) { return 0.5 * m * v * v; }
+
+// Adding Quantities with different prefixes
+metres quantity_mixed_add(km a, metres b) { return a + b; }
+double double_mixed_add(double a, double b) { return a * 1000. + b; }
+
+// pow
+metres3 quantity_pow3(metres a) { return pow<3>(a); }
+double double_pow3(double a) { return a * (a * a); }
+auto quantity_pow4(metres a) { return pow<4>(a); }
+double double_pow4(double a) {
+  const auto a2 = a * a;
+  return a2 * a2;
+}
+auto quantity_pow_minus2(metres a) { return pow<-2>(a); }
+double double_pow_minus2(double a) { return 1 / (a * a); }
+auto quantity_pow3_2(metres a) { return pow<3, 2>(a); }
+double double_pow3_2(double a) { return a * std::sqrt(a); }
+
+// sqrt
+metres quantity_sqrt(metres2 a) { return std::sqrt(a); }
+double double_sqrt(double a) { return std::sqrt(a); }
+
+// Comparing Quantities with different prefixes
+bool quantity_km_less_metres(km a, metres b) { return a < b; }
+bool double_km_less_metres(double a, double b) { return a * 1000. < b; }
+
+// The same over arrays
+void quantity_kinetic_energy_array(Joules* out, const kg* m,
+                                   const metres_per_sec* v, std::size_t n) {
+  // loop: quantity_kinetic_energy_array
+  for (std::size_t i = 0; i < n; ++i) {
+    out[i] = 0.5 * m[i] * v[i] * v[i];
+  }
+}
+void double_kinetic_energy_array(double* out, const double* m,
+                                 const double* v, std::size_t n) {
+  // loop: double_kinetic_energy_array
+  for (std::size_t i = 0; i < n; ++i) {
+    out[i] = 0.5 * m[i] * v[i] * v[i];
+  }
+}
+
+void quantity_mixed_add_array(metres* out, const km* a, const metres* b,
+                              std::size_t n) {
+  // loop: quantity_mixed_add_array
+  for (std::size_t i = 0; i < n; ++i) {
+    out[i] = a[i] + b[i];
+  }
+}
+void double_mixed_add_array(double* out, const double* a, const double* b,
+                            std::size_t n) {
+  // loop: double_mixed_add_array
+  for (std::size_t i = 0; i < n; ++i) {
+    out[i] = a[i] * 1000. + b[i];
+  }
+}
+
+void quantity_pow3_array(metres3* out, const metres* a, std::size_t n) {
+  // loop: quantity_pow3_array
+  for (std::size_t i = 0; i < n; ++i) {
+    out[i] = pow<3>(a[i]);
+  }
+}
+void double_pow3_array(double* out, const double* a, std::size_t n) {
+  // loop: double_pow3_array
+  for (std::size_t i = 0; i < n; ++i) {
+    out[i] = a[i] * (a[i] * a[i]);
+  }
+}
+
+void quantity_sqrt_array(metres* out, const metres2* a, std::size_t n) {
+  // loop: quantity_sqrt_array
+  for (std::size_t i = 0; i < n; ++i) {
+    out[i] = std::sqrt(a[i]);
+  }
+}
+void double_sqrt_array(double* out, const double* a, std::size_t n) {
+  // loop: double_sqrt_array
+  for (std::size_t i = 0; i < n; ++i) {
+    out[i] = std::sqrt(a[i]);
+  }
+}
+
+void quantity_km_less_metres_array(bool* out, const km* a, const metres* b,
+                                   std::size_t n) {
+  // loop: quantity_km_less_metres_array
+  for (std::size_t i = 0; i < n; ++i) {
+    out[i] = a[i] < b[i];
+  }
+}
+void double_km_less_metres_array(bool* out, const double* a, const double* b,
+                                 std::size_t n) {
+  // loop: double_km_less_metres_array
+  for (std::size_t i = 0; i < n; ++i) {
+    out[i] = a[i] * 1000. < b[i];
+  }
+}
+}
@@ -0,0 +1,176 @@
+#!/usr/bin/env python3
+"""Check that Quantity code compiles to the same instructions as doubles.
+
+Compiles codegen_kernels.cpp at each optimisation level and disassembles it
+with objdump. Each quantity_<name> kernel must have the same sequence of
+instructions as double_<name>, ignoring register to register moves (which
+vary with register allocation) and padding. Each quantity_ loop after a
+"// loop: <function>" comment must be vectorised whenever the matching
+double_ loop is, going by the compiler's report (-fopt-info-vec for gcc,
+-Rpass=loop-vectorize for clang).
+
+Kernels in ALLOWED_DIVERGENCES are reported but do not fail the test.
+
+    codegen_test.py --cxx g++ --include <repo> [--opt -O2 -O3]
+"""
+
+import argparse
+import os
+import re
+import subprocess as sp
+import sys
+import tempfile
+
+KERNELS_SOURCE = "codegen_kernels.cpp"
+
+# kernel name -> why its Quantity version may differ from the double one
+ALLOWED_DIVERGENCES = {
+    "sqrt": "negative values call libm's sqrt to set errno, which GCC won't "
+            "tail call when the result is returned as a Quantity",
+}
+REGISTER_MOVE = re.compile(r"^mov[a-z]*\s+%\w+,\s*%\w+$")
+PADDING = ("nop", "data16", "cs nop", "xchg %ax")
+
+SYMBOL = re.compile(r"^[0-9a-f]+ <(?P<name>[^>]+)>:$")
+INSTRUCTION = re.compile(r"^\s*[0-9a-f]+:\s*(?P<asm>.*)$")
+VECTORISED = re.compile(
+    r"{0}:(?P<line>\d+):\d+: (optimized: loop vectorized|"
+    r"remark: vectorized loop)".format(re.escape(KERNELS_SOURCE)))
+LOOP_TAG = re.compile(r"^\s*// loop: (?P<name>\w+)$")
+
+
+def is_clang(cxx):
+    out = sp.run([cxx, "--version"], stdout=sp.PIPE, stderr=sp.STDOUT,
+                 universal_newlines=True)
+    return "clang" in out.stdout.lower()
+
+
+def compile_kernels(cxx, include, opt, obj):
+    """Compile the kernels, returning the vectoriser's report."""
+    cmd = [cxx, "-std=gnu++2a", opt, "-I", include, "-c",
+           os.path.join(include, KERNELS_SOURCE), "-o", obj]
+    if is_clang(cxx):
+        cmd += ["-Rpass=loop-vectorize", "-Wno-return-type-c-linkage"]
+    else:
+        # identical functions would otherwise be folded into one symbol
+        cmd += ["-fopt-info-vec-optimized", "-fno-ipa-icf"]
+    out = sp.run(cmd, stdout=sp.PIPE, stderr=sp.STDOUT,
+                 universal_newlines=True)
+    if out.returncode != 0:
+        sys.exit("compiling the kernels failed:\n" + out.stdout)
+    return out.stdout
+
+
+def normalise(asm):
+    """Remove what differs between two copies of the same code: comments,
+    symbol names and rip relative displacements (the constant pool)."""
+    asm = asm.split("#")[0]
+    asm = re.sub(r"<[^>]*>", "", asm)
+    asm = re.sub(r"rip\s*\+\s*0x[0-9a-f]+", "rip+X", asm)
+    asm = re.sub(r"0x[0-9a-f]+\(%rip\)", "X(%rip)", asm)
+    asm = re.sub(r"\b(call|jmp|j[a-z]+)\s+[0-9a-f]+\b", r"\1 X", asm)
+    return " ".join(asm.split())
+
+
+def disassemble(obj):
+    """Map each function in obj to its list of normalised instructions."""
+    out = sp.run(["objdump", "-d", "--no-show-raw-insn", obj],
+                 stdout=sp.PIPE, universal_newlines=True, check=True)
+    functions = {}
+    current = None
+    for line in out.stdout.splitlines():
+        m = SYMBOL.match(line)
+        if m:
+            current = functions.setdefault(m.group("name"), [])
+            continue
+        m = INSTRUCTION.match(line)
+        if m and current is not None:
+            asm = normalise(m.group("asm"))
+            if asm:
+                current.append(asm)
+    return functions
+
+
+def significant(instructions):
+    """The mnemonics of the instructions that do work."""
+    return [i.split()[0] for i in instructions
+            if not REGISTER_MOVE.match(i) and not i.startswith(PADDING)]
+
+
+def compare_kernels(functions, opt):
+    failures = []
+    names = sorted(f[len("quantity_"):] for f in functions
+                   if f.startswith("quantity_"))
+    for name in names:
+        q = functions["quantity_" + name]
+        d = functions.get("double_" + name)
+        if d is None:
+            failures.append("{0}: no double_{1} to compare".format(opt, name))
+            continue
+        same = significant(q) == significant(d)
+        status = "same" if q == d else "same apart from register moves"
+        status = status if same else "DIFFERENT"
+        if not same and name in ALLOWED_DIVERGENCES:
+            status = "different (allowed: {0})".format(
+                ALLOWED_DIVERGENCES[name])
+        print("{0} {1:<28} {2:>4} vs {3:>4} instructions: {4}".format(
+            opt, name, len(q), len(d), status))
+        if not same and name not in ALLOWED_DIVERGENCES:
+            failures.append("{0}: {1} differs".format(opt, name))
+            for a, b in zip(q + [""] * len(d), d + [""] * len(q)):
+                if not a and not b:
+                    break
+                print("    {0:<40} | {1}".format(a, b))
+    return failures
+
+
+def check_vectorised(report, include, opt):
+    """Each tagged quantity_ loop must be vectorised if its double_ loop is."""
+    vectorised = {int(m.group("line")) for m in VECTORISED.finditer(report)}
+    loops = {}
+    with open(os.path.join(include, KERNELS_SOURCE)) as f:
+        for number, line in enumerate(f, start=1):
+            m = LOOP_TAG.search(line)
+            if m:
+                loops[m.group("name")] = number + 1 in vectorised
+    failures = []
+    for function, ok in sorted(loops.items()):
+        if not function.startswith("quantity_"):
+            continue
+        name = function[len("quantity_"):]
+        expected = loops.get("double_" + name, True)
+        if ok:
+            status = "vectorised"
+        elif not expected:
+            status = "not vectorised, nor is the double loop"
+        elif name in ALLOWED_DIVERGENCES:
+            status = "NOT vectorised (allowed)"
+        else:
+            status = "NOT vectorised"
+            failures.append("{0}: {1} loop not vectorised".format(opt, name))
+        print("{0} {1:<28} {2}".format(opt, name, status))
+    return failures
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--cxx", default="c++")
+    parser.add_argument("--include", default=os.path.dirname(
+        os.path.abspath(__file__)))
+    parser.add_argument("--opt", nargs="+", default=["-O2", "-O3"])
+    args = parser.parse_args()
+
+    failures = []
+    with tempfile.TemporaryDirectory() as tmp:
+        for opt in args.opt:
+            obj = os.path.join(tmp, "kernels{0}.o".format(opt))
+            report = compile_kernels(args.cxx, args.include, opt, obj)
+            failures += compare_kernels(disassemble(obj), opt)
+            failures += check_vectorised(report, args.include, opt)
+    for f in failures:
+        print("FAILED: " + f)
+    return 1 if failures else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,403 @@
+#pragma once
+
+#include "derived_dimensions_impl.hpp"
+#include "quantity.hpp"
+#include "quantity_cast.hpp"
+#include "quantity_span.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <new>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define UNITS_HAS_MMAP 1
+#else
+#define UNITS_HAS_MMAP 0
+#endif
+
+// ************************************************************************* /
+//    A binary file of Quantity columns that records the dimensions, prefix, /
+//    BaseType and Tag of each column next to its data, so reloading it is   /
+//    checked against the Quantity types. The columns are raw, aligned       /
+//    arrays, so a mapped file is used in place without parsing:             /
+//                                                                           /
+//      "UNITSCOL", version, column count                                    /
+//      a ColumnHeader per column                                            /
+//      the columns, each aligned to 64 bytes                                /
+// ************************************************************************* /
+
+namespace units {
+  namespace Impl {
+    constexpr char column_file_magic[8] = {'U', 'N', 'I', 'T',
+                                           'S', 'C', 'O', 'L'};
+    // also tells if the file was written with the other endianness
+    constexpr std::uint32_t column_file_version = 1;
+    constexpr std::uint64_t column_alignment = 64;
+
+    struct ColumnFilePreamble {
+      char magic[8];
+      std::uint32_t version;
+      std::uint32_t column_count;
+    };
+
+    /// Fixed size so the headers are an array that can be read in place
+    struct ColumnHeader {
+      char name[64];
+      // length, mass, time, current, temperature, amount, luminosity,
+      // prefix, as numerator and denominator
+      std::int64_t code[8][2];
+      // 'f'loating point, 's'igned or 'u'nsigned integer, and its size
+      char base_kind;
+      std::uint8_t base_size;
+      std::uint8_t padding[6];
+      std::uint64_t tag_hash;
+      std::uint64_t offset;
+      std::uint64_t count;
+    };
+
+    static_assert(sizeof(ColumnFilePreamble) == 16);
+    static_assert(sizeof(ColumnHeader) == 224);
+    static_assert(std::is_trivially_copyable_v<ColumnHeader>);
+
+    /// The name of T from the compiler, e.g. "MyTag"
+    template <class T>
+    constexpr std::string_view type_name() {
+#if defined(__GNUC__) || defined(__clang__)
+      return __PRETTY_FUNCTION__;
+#elif defined(_MSC_VER)
+      return __FUNCSIG__;
+#else
+      return "";
+#endif
+    }
+
+    /** A hash of the name of Tag, 0 for untagged Quantities. Only the same
+     * compiler is guaranteed to give the same hash. */
+    template <class Tag>
+    constexpr std::uint64_t tag_hash() {
+      if constexpr (std::is_same_v<Tag, std::false_type>) {
+        return 0;
+      } else {
+        auto h = std::uint64_t{0xCBF29CE484222325};
+        for (auto c : type_name<Tag>()) {
+          h = (h ^ static_cast<unsigned char>(c)) * 0x100000001B3;
+        }
+        return h;
+      }
+    }
+
+    template <class BaseType>
+    constexpr char base_kind() {
+      static_assert(std::is_arithmetic_v<BaseType>,
+                    "only arithmetic BaseTypes can be stored");
+      return std::is_floating_point_v<BaseType> ? 'f'
+             : std::is_signed_v<BaseType>       ? 's'
+                                                : 'u';
+    }
+
+    template <class Q>
+    ColumnHeader make_column_header(std::string_view name, std::size_t count,
+                                    std::uint64_t offset) {
+      using Units = typename quantity_traits<Q>::Units;
+      using BaseType = typename quantity_traits<Q>::BaseType;
+      using Tag = typename quantity_traits<Q>::Tag;
+      if (name.size() >= sizeof(ColumnHeader::name)) {
+        throw std::invalid_argument("column name \"" + std::string{name} +
+                                    "\" is too long");
+      }
+      auto h = ColumnHeader{};
+      std::copy(name.begin(), name.end(), h.name);
+      const auto& c = Units::code;
+      static_assert(c.prefix.is_ratio(),
+                    "column files store the prefix as a ratio");
+      const Rational values[] = {c.length,
+                                 c.mass,
+                                 c.time,
+                                 c.current,
+                                 c.temperature,
+                                 c.amount,
+                                 c.luminosity,
+                                 {c.prefix.num, c.prefix.den}};
+      for (auto i = 0; i < 8; ++i) {
+        h.code[i][0] = values[i].num;
+        h.code[i][1] = values[i].den;
+      }
+      h.base_kind = base_kind<BaseType>();
+      h.base_size = sizeof(BaseType);
+      h.tag_hash = tag_hash<Tag>();
+      h.offset = offset;
+      h.count = count;
+      return h;
+    }
+
+    /// Why the column h can't be read as a Q, or empty if it can.
+    template <class Q>
+    std::string column_mismatch(const ColumnHeader& h) {
+      const auto expected = make_column_header<Q>("", 0, 0);
+      if (std::memcmp(h.code, expected.code, sizeof(h.code)) != 0) {
+        return "has different dimensions or prefix";
+      }
+      if (h.base_kind != expected.base_kind ||
+          h.base_size != expected.base_size) {
+        return "has a different BaseType";
+      }
+      if (h.tag_hash != expected.tag_hash) {
+        return "has a different Tag";
+      }
+      return {};
+    }
+
+    inline std::uint64_t align_up(std::uint64_t n) {
+      return (n + column_alignment - 1) / column_alignment * column_alignment;
+    }
+  } // namespace Impl
+
+  /// A column to write, see write_column_file.
+  template <class Q>
+  struct NamedColumn {
+    std::string_view name;
+    std::span<const Q> data;
+  };
+
+  template <class C>
+  NamedColumn(std::string_view, const C&)
+      -> NamedColumn<typename C::value_type>;
+
+  /** Write the columns to path, replacing it. Each column is a
+   * NamedColumn{name, data}, where data is a contiguous range of Quantities,
+   * e.g.
+   *
+   *   units::write_column_file("state.bin", units::NamedColumn{"x", xs},
+   *                            units::NamedColumn{"p", pressures});
+   *
+   * Throws std::system_error if the file can't be written. */
+  template <class... Qs>
+  void write_column_file(const std::filesystem::path& path,
+                         const NamedColumn<Qs>&... columns) {
+    constexpr auto n = sizeof...(Qs);
+    auto preamble = Impl::ColumnFilePreamble{};
+    std::copy(std::begin(Impl::column_file_magic),
+              std::end(Impl::column_file_magic), preamble.magic);
+    preamble.version = Impl::column_file_version;
+    preamble.column_count = n;
+
+    auto offset = Impl::align_up(sizeof(preamble) +
+                                 n * sizeof(Impl::ColumnHeader));
+    auto headers = std::vector<Impl::ColumnHeader>{};
+    (
+        [&] {
+          headers.push_back(Impl::make_column_header<Qs>(
+              columns.name, columns.data.size(), offset));
+          offset = Impl::align_up(offset + columns.data.size_bytes());
+        }(),
+        ...);
+
+    auto out = std::ofstream{path, std::ios::binary | std::ios::trunc};
+    const auto write = [&](const void* p, std::size_t size) {
+      out.write(static_cast<const char*>(p),
+                static_cast<std::streamsize>(size));
+    };
+    const auto pad_to = [&](std::uint64_t to) {
+      static constexpr char zeros[Impl::column_alignment] = {};
+      write(zeros, to - static_cast<std::uint64_t>(out.tellp()));
+    };
+    write(&preamble, sizeof(preamble));
+    write(headers.data(), headers.size() * sizeof(Impl::ColumnHeader));
+    auto i = std::size_t{};
+    (
+        [&] {
+          pad_to(headers[i++].offset);
+          write(columns.data.data(), columns.data.size_bytes());
+        }(),
+        ...);
+    if (!out.flush()) {
+      throw std::system_error(errno, std::generic_category(),
+                              "writing " + path.string());
+    }
+  }
+
+  /** A column file mapped into memory (read in, where there is no mmap).
+   * The columns are spans of Quantities over the mapped data, checked
+   * against the header, with no copying or parsing. The mapping is
+   * private, so changes to the spans aren't written back to the file. */
+  class ColumnFile {
+  public:
+    /// Throws std::system_error if path can't be read, and
+    /// std::invalid_argument if it isn't a valid column file.
+    explicit ColumnFile(const std::filesystem::path& path) {
+      map(path);
+      validate();
+    }
+
+    ColumnFile(ColumnFile&& o) noexcept
+        : _data{std::exchange(o._data, nullptr)},
+          _size{std::exchange(o._size, 0)}, _buffer{std::move(o._buffer)} {}
+
+    ColumnFile& operator=(ColumnFile&& o) noexcept {
+      std::swap(_data, o._data);
+      std::swap(_size, o._size);
+      std::swap(_buffer, o._buffer);
+      return *this;
+    }
+
+    ~ColumnFile() { unmap(); }
+
+    std::size_t column_count() const { return preamble().column_count; }
+
+    std::string_view name(std::size_t i) const {
+      const auto& n = headers()[i].name;
+      return {n, static_cast<std::size_t>(std::find(n, std::end(n), '\0') - n)};
+    }
+
+    /// The dimensions and prefix of column i
+    DimensionCode code(std::size_t i) const {
+      const auto& c = headers()[i].code;
+      const auto r = [&c](int j) { return Rational{c[j][0], c[j][1]}; };
+      return {r(0), r(1), r(2), r(3), r(4), r(5), r(6), r(7)};
+    }
+
+    /** The column called name as Quantities of type Q. Throws
+     * std::invalid_argument if there isn't one, or if its dimensions,
+     * prefix, BaseType or Tag are different from those of Q. */
+    template <class Q>
+    std::span<Q> column(std::string_view name) const {
+      for (auto i = std::size_t{}; i < column_count(); ++i) {
+        if (this->name(i) == name) {
+          return column<Q>(i);
+        }
+      }
+      throw std::invalid_argument("no column \"" + std::string{name} + "\"");
+    }
+
+    /// As above, by index
+    template <class Q>
+    std::span<Q> column(std::size_t i) const {
+      static_assert(is_quantity(Q{}), "columns are Quantities");
+      static_assert(has_underlying_layout<Q>);
+      const auto& h = headers()[i];
+      if (const auto why = Impl::column_mismatch<Q>(h); !why.empty()) {
+        throw std::invalid_argument("column \"" + std::string{name(i)} +
+                                    "\" " + why);
+      }
+      auto* p = std::launder(reinterpret_cast<Q*>(_data + h.offset));
+      return {p, static_cast<std::size_t>(h.count)};
+    }
+
+  private:
+    std::byte* _data = nullptr;
+    std::size_t _size = 0;
+    // the file's contents when there is no mmap
+    std::vector<std::max_align_t> _buffer;
+
+    const Impl::ColumnFilePreamble& preamble() const {
+      return *reinterpret_cast<const Impl::ColumnFilePreamble*>(_data);
+    }
+
+    const Impl::ColumnHeader* headers() const {
+      return reinterpret_cast<const Impl::ColumnHeader*>(
+          _data + sizeof(Impl::ColumnFilePreamble));
+    }
+
+    void map(const std::filesystem::path& path) {
+      const auto fail = [&path] {
+        throw std::system_error(errno, std::generic_category(),
+                                "reading " + path.string());
+      };
+#if UNITS_HAS_MMAP
+      const auto fd = ::open(path.c_str(), O_RDONLY);
+      if (fd < 0) {
+        fail();
+      }
+      struct stat st {};
+      if (::fstat(fd, &st) != 0) {
+        ::close(fd);
+        fail();
+      }
+      _size = static_cast<std::size_t>(st.st_size);
+      if (_size != 0) {
+        auto* p = ::mmap(nullptr, _size, PROT_READ | PROT_WRITE, MAP_PRIVATE,
+                         fd, 0);
+        if (p == MAP_FAILED) {
+          ::close(fd);
+          fail();
+        }
+        _data = static_cast<std::byte*>(p);
+      }
+      ::close(fd);
+#else
+      auto in = std::ifstream{path, std::ios::binary | std::ios::ate};
+      if (!in) {
+        fail();
+      }
+      _size = static_cast<std::size_t>(in.tellg());
+      _buffer.resize(_size / sizeof(std::max_align_t) + 1);
+      _data = reinterpret_cast<std::byte*>(_buffer.data());
+      in.seekg(0);
+      if (!in.read(reinterpret_cast<char*>(_data),
+                   static_cast<std::streamsize>(_size))) {
+        fail();
+      }
+#endif
+    }
+
+    void unmap() {
+#if UNITS_HAS_MMAP
+      if (_data != nullptr) {
+        ::munmap(_data, _size);
+      }
+#endif
+      _data = nullptr;
+    }
+
+    void validate() {
+      const auto invalid = [this](const char* why) {
+        unmap();
+        throw std::invalid_argument(std::string{"not a column file: "} + why);
+      };
+      if (_size < sizeof(Impl::ColumnFilePreamble) ||
+          !std::equal(std::begin(Impl::column_file_magic),
+                      std::end(Impl::column_file_magic), preamble().magic)) {
+        invalid("no header");
+      }
+      if (preamble().version != Impl::column_file_version) {
+        invalid("unknown version, or the other endianness");
+      }
+      const auto headers_end = sizeof(Impl::ColumnFilePreamble) +
+                               std::uint64_t{preamble().column_count} *
+                                   sizeof(Impl::ColumnHeader);
+      if (headers_end > _size) {
+        invalid("truncated header");
+      }
+      for (auto i = std::size_t{}; i < column_count(); ++i) {
+        const auto& h = headers()[i];
+        if (h.offset % Impl::column_alignment != 0 || h.offset > _size ||
+            h.base_size == 0 || h.count > (_size - h.offset) / h.base_size) {
+          invalid("column outside the file");
+        }
+        for (const auto& r : h.code) {
+          if (r[1] == 0) {
+            invalid("zero denominator");
+          }
+        }
+      }
+    }
+  };
+} // namespace units
@@ -0,0 +1,117 @@
+#include "column_file.hpp"
+#include "common_quantities.hpp"
+#include <catch.hpp>
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <system_error>
+#include <vector>
+
+namespace {
+  struct Inflow {};
+  struct Outflow {};
+  using kg_per_sec_t = decltype(kg_t{} / seconds_t{});
+
+  std::filesystem::path temp_file(const char* name) {
+    return std::filesystem::temp_directory_path() / name;
+  }
+} // namespace
+
+SCENARIO("Checkpointing Quantity columns to a mapped binary file") {
+  using namespace units;
+  const auto path = temp_file("units_column_file_test.bin");
+  GIVEN("columns of different Quantities") {
+    auto xs = std::vector<metres>{};
+    auto flows = std::vector<Quantity<kg_per_sec_t, double, Inflow>>{};
+    auto pressures = std::vector<Quantity<Pascals_t, float>>{};
+    auto counts = std::vector<Quantity<nanoseconds_t, std::int64_t>>{};
+    for (auto i = 0; i < 1000; ++i) {
+      xs.push_back(metres{i * 0.5});
+      flows.emplace_back(i / 3.0);
+      pressures.emplace_back(static_cast<float>(i) * 100);
+      counts.emplace_back(i * 1'000'000'000LL);
+    }
+    write_column_file(path, NamedColumn{"x", xs}, NamedColumn{"flow", flows},
+                      NamedColumn{"p", pressures},
+                      NamedColumn{"t", counts});
+
+    THEN("they read back as the same Quantities, aligned") {
+      const auto file = ColumnFile{path};
+      REQUIRE(file.column_count() == 4);
+      REQUIRE(file.name(1) == "flow");
+      REQUIRE(file.code(3) == nanoseconds_t::code);
+      const auto x = file.column<metres>("x");
+      REQUIRE(std::equal(x.begin(), x.end(), xs.begin(), xs.end()));
+      const auto f = file.column<decltype(flows)::value_type>("flow");
+      REQUIRE(std::equal(f.begin(), f.end(), flows.begin(), flows.end()));
+      const auto p = file.column<Quantity<Pascals_t, float>>(2);
+      REQUIRE(std::equal(p.begin(), p.end(), pressures.begin(),
+                         pressures.end()));
+      const auto t = file.column<decltype(counts)::value_type>("t");
+      REQUIRE(t[999].underlying_value() == 999'000'000'000LL);
+      for (const auto* data : {static_cast<const void*>(x.data()),
+                               static_cast<const void*>(f.data()),
+                               static_cast<const void*>(p.data()),
+                               static_cast<const void*>(t.data())}) {
+        REQUIRE(reinterpret_cast<std::uintptr_t>(data) % 64 == 0);
+      }
+    }
+    THEN("changes to the spans aren't written to the file") {
+      {
+        const auto file = ColumnFile{path};
+        file.column<metres>("x")[0] = metres{42};
+        REQUIRE(file.column<metres>("x")[0] == metres{42});
+      }
+      REQUIRE(ColumnFile{path}.column<metres>("x")[0] == metres{0});
+    }
+    THEN("reading a column as another type throws") {
+      const auto file = ColumnFile{path};
+      REQUIRE_THROWS_WITH(file.column<km>("x"),
+                          "column \"x\" has different dimensions or prefix");
+      REQUIRE_THROWS_WITH(file.column<seconds>("x"),
+                          "column \"x\" has different dimensions or prefix");
+      REQUIRE_THROWS_WITH((file.column<Quantity<metres_t, float>>("x")),
+                          "column \"x\" has a different BaseType");
+      REQUIRE_THROWS_WITH(
+          (file.column<Quantity<kg_per_sec_t, double, Outflow>>("flow")),
+          "column \"flow\" has a different Tag");
+      REQUIRE_THROWS_WITH(file.column<metres>("y"), "no column \"y\"");
+    }
+    THEN("truncated files are rejected") {
+      std::filesystem::resize_file(path, 2000);
+      REQUIRE_THROWS_AS(ColumnFile{path}, std::invalid_argument);
+      std::filesystem::resize_file(path, 10);
+      REQUIRE_THROWS_AS(ColumnFile{path}, std::invalid_argument);
+    }
+  }
+  GIVEN("a file that doesn't exist") {
+    THEN("it throws a system_error") {
+      std::filesystem::remove(path);
+      REQUIRE_THROWS_AS(ColumnFile{path}, std::system_error);
+    }
+  }
+  std::filesystem::remove(path);
+}
+
+SCENARIO("Profiling ColumnFile", "[Profile]") {
+  GIVEN("a large checkpoint") {
+    const auto path = temp_file("units_column_file_profile.bin");
+    auto xs = std::vector<metres>{};
+    for (auto i = 0; i < 10'000'000; ++i) {
+      xs.push_back(metres{i * 1.0});
+    }
+    units::write_column_file(path, units::NamedColumn{"x", xs});
+    auto total = 0.0;
+    BENCHMARK("map and sum 80 MB") {
+      const auto file = units::ColumnFile{path};
+      for (const auto& x : file.column<metres>("x")) {
+        total += x.underlying_value();
+      }
+    }
+    std::cout << total << "\n";
+    std::filesystem::remove(path);
+  }
+}
@@ -14,6 +14,7 @@ using kg = Quantity<kg_t>;
 
 // Lengths
 using metres = Quantity<metres_t>;
+using mm = Quantity<mm_t>;
 using cm = Quantity<cm_t>;
 using km = Quantity<km_t>;
 
@@ -33,6 +34,7 @@ using metres05 = Quantity<metres05_t>;
 
 // Times
 using seconds = Quantity<seconds_t>;
+using nanoseconds = Quantity<nanoseconds_t>;
 using minutes = Quantity<minutes_t>;
 using hours = Quantity<hours_t>;
 using days = Quantity<days_t>;
@@ -9,6 +9,9 @@ using kg_t = units::derived_t<units::Mass<1, 1>>;
 
 // Lengths
 using metres_t = units::derived_t<units::Length<1, 1>>;
+using mm_t =
+    units::derived_t<units::Length<1, 1>,
+                     std::ratio_multiply<metres_t::prefix, units::milli>>;
 using cm_t =
     units::derived_t<units::Length<1, 1>,
                      std::ratio_multiply<metres_t::prefix, units::centi>>;
@@ -20,7 +23,8 @@ using km_t =
 using metres2_t = units::derived_t<units::Length<2, 1>, units::unity>;
 using acre_t = units::derived_t<
     metres2_t,
-    std::ratio_multiply<metres2_t::prefix, std::ratio<404'685'642, 1>>>;
+    std::ratio_multiply<metres2_t::prefix,
+                        std::ratio<40'468'564'224, 10'000'000>>>;
 using hectare_t = units::derived_t<
     metres2_t, std::ratio_multiply<metres2_t::prefix, std::ratio<10'000, 1>>>;
 
@@ -36,6 +40,9 @@ using metres05_t = units::derived_t<units::Length<1, 2>>;
 
 // Times
 using seconds_t = units::derived_t<units::Time<1, 1>, units::unity>;
+using nanoseconds_t =
+    units::derived_t<units::Time<1, 1>,
+                     std::ratio_multiply<seconds_t::prefix, units::nano>>;
 using minutes_t =
     units::derived_t<units::Time<1, 1>,
                      std::ratio_multiply<seconds_t::prefix, std::ratio<60, 1>>>;
@@ -48,15 +55,15 @@ using days_t =
 
 // Rates
 using per_second_t = units::derived_t<units::Time<-1, 1>, units::unity>;
-using per_min_t =
-    units::derived_t<units::Time<-1, 1>,
-                     std::ratio_multiply<seconds_t::prefix, std::ratio<60, 1>>>;
-using per_hour_t = units::derived_t<
+using per_min_t = units::derived_t<
     units::Time<-1, 1>,
-    std::ratio_multiply<seconds_t::prefix, std::ratio<3600, 1>>>;
+    std::ratio_divide<per_second_t::prefix, minutes_t::prefix>>;
+using per_hour_t =
+    units::derived_t<units::Time<-1, 1>,
+                     std::ratio_divide<per_second_t::prefix, hours_t::prefix>>;
 using per_days_t =
     units::derived_t<units::Time<-1, 1>,
-                     std::ratio_multiply<hours_t::prefix, std::ratio<24, 1>>>;
+                     std::ratio_divide<per_second_t::prefix, days_t::prefix>>;
 
 // Time Extras
 using seconds2_t = units::derived_t<units::Time<2, 1>, units::unity>;
@@ -78,3 +85,40 @@ using kg_metres_per_sec2_t = decltype(kg_t{} * metres_per_sec2_t{});
 using Newtons_t = units::derived_t<kg_t, metres_per_sec2_t>;
 using Pascals_t = units::derived_t<decltype(Newtons_t{} / metres2_t{})>;
 using MPam05_t = units::derived_t<units::mega, Pascals_t, units::Length<1, 2>>;
+
+// The aliases above as X(name, symbol), where name_t is the alias, for the
+// runtime registry in unit_registry.hpp. Add new aliases here too.
+#define UNITS_COMMON_UNITS(X)                                                  \
+  X(kg, "kg")                                                                  \
+  X(metres, "m")                                                               \
+  X(mm, "mm")                                                                  \
+  X(cm, "cm")                                                                  \
+  X(km, "km")                                                                  \
+  X(metres2, "m^2")                                                            \
+  X(acre, "ac")                                                                \
+  X(hectare, "ha")                                                             \
+  X(metres3, "m^3")                                                            \
+  X(litres, "L")                                                               \
+  X(us_gallon, "US gal")                                                       \
+  X(imp_gallon, "imp gal")                                                     \
+  X(metres05, "m^0.5")                                                         \
+  X(seconds, "s")                                                              \
+  X(nanoseconds, "ns")                                                         \
+  X(minutes, "min")                                                            \
+  X(hours, "h")                                                                \
+  X(days, "d")                                                                 \
+  X(per_second, "1/s")                                                         \
+  X(per_min, "1/min")                                                          \
+  X(per_hour, "1/h")                                                           \
+  X(per_days, "1/d")                                                           \
+  X(seconds2, "s^2")                                                           \
+  X(metres_per_sec, "m/s")                                                     \
+  X(metres_per_sec2, "m/s^2")                                                  \
+  X(metres2_per_sec2, "m^2/s^2")                                               \
+  X(Joules, "J")                                                               \
+  X(Watts, "W")                                                                \
+  X(kg_metres_per_sec, "kg m/s")                                               \
+  X(kg_metres_per_sec2, "kg m/s^2")                                            \
+  X(Newtons, "N")                                                              \
+  X(Pascals, "Pa")                                                             \
+  X(MPam05, "MPa m^0.5")
@@ -0,0 +1,223 @@
+#!/usr/bin/env python3
+"""Compile time benchmark.
+
+Generates translation units with an increasing number of distinct derived
+types and chains of Quantity operators, compiles each with every compiler
+given, and writes a JSON report of the wall time, peak RSS and the hotspots
+reported by the compiler (-ftime-trace for clang, -ftime-report for gcc).
+
+    compile_bench.py --include <repo> --out report.json [--cxx g++ clang++]
+    compile_bench.py ... --baseline old_report.json
+
+With --baseline the results are compared against an earlier report and the
+script exits with 1 if any wall time or peak RSS grew by more than
+--threshold (default 10%).
+"""
+
+import argparse
+import datetime
+import json
+import os
+import re
+import shutil
+import subprocess as sp
+import tempfile
+import time
+
+DEFAULT_SIZES = [10, 100, 1000, 10000]
+BASE_DIMENSIONS = ["Length", "Mass", "Time", "Current", "Temperature",
+                   "Amount", "Luminosity"]
+
+
+def unit_args(i):
+    """The derived_t arguments for the i'th distinct unit: three of the base
+    dimensions with exponents in [-3, 3] (some fractional) and a prefix."""
+    args = []
+    for k in range(3):
+        dim = BASE_DIMENSIONS[(i + 2 * k) % len(BASE_DIMENSIONS)]
+        n = (i // (k + 1)) % 7 - 3
+        d = 2 if (i + k) % 5 == 0 else 1
+        args.append("units::{0}<{1}, {2}>".format(dim, n, d))
+    args.append("std::ratio<{0}, {1}>".format(i % 997 + 1, i % 13 + 1))
+    return args
+
+
+def generate_source(n):
+    """A translation unit with n distinct derived types, each used in a
+    chain of multiplications, divisions and a mixed prefix addition."""
+    lines = ['#include "common_quantities.hpp"', "", "namespace bench {"]
+    for i in range(n):
+        lines.append("using u{0}_t = units::derived_t<{1}>;".format(
+            i, ", ".join(unit_args(i))))
+    lines.append("")
+    lines.append("double run(double x) {")
+    lines.append("  auto total = 0.0;")
+    for i in range(n):
+        prev = max(i - 1, 0)
+        lines.append(
+            "  {{ auto q = Quantity<u{0}_t>{{x}} * Quantity<u{1}_t>{{x}} / "
+            "(metres{{x}} * seconds{{x}});\n"
+            "    auto r = q / Quantity<u{1}_t>{{x}} * seconds{{x}};\n"
+            "    total += (km{{x}} + metres{{x}} * (r / r))"
+            ".underlying_value() + q.underlying_value(); }}".format(i, prev))
+    lines.append("  return total;")
+    lines.append("}")
+    lines.append("} // namespace bench")
+    return "\n".join(lines) + "\n"
+
+
+def compiler_version(cxx):
+    out = sp.run([cxx, "--version"], stdout=sp.PIPE, stderr=sp.STDOUT,
+                 universal_newlines=True)
+    return out.stdout.splitlines()[0] if out.stdout else "unknown"
+
+
+def is_clang(cxx):
+    return "clang" in compiler_version(cxx).lower()
+
+
+def run_with_rusage(cmd, cwd):
+    """Run cmd, returning (wall seconds, peak RSS in KB, stderr) where the
+    peak RSS is that of cmd alone (from wait4)."""
+    start = time.perf_counter()
+    err_path = os.path.join(cwd, "stderr.txt")
+    with open(err_path, "w") as err:
+        proc = sp.Popen(cmd, cwd=cwd, stdout=sp.DEVNULL, stderr=err)
+        _, status, usage = os.wait4(proc.pid, 0)
+    wall = time.perf_counter() - start
+    proc.returncode = os.waitstatus_to_exitcode(status)
+    with open(err_path) as err:
+        stderr = err.read()
+    if proc.returncode != 0:
+        raise RuntimeError("{0} failed:\n{1}".format(" ".join(cmd), stderr))
+    return wall, usage.ru_maxrss, stderr
+
+
+GCC_PHASE = re.compile(
+    r"^\s*(?P<name>[^:]+?)\s*:\s*[\d.]+\s*\(\s*\d+%\)\s*[\d.]+\s*\(\s*\d+%\)"
+    r"\s*(?P<wall>[\d.]+)\s*\(\s*\d+%\)")
+
+
+def gcc_hotspots(stderr, top):
+    """The slowest phases from gcc's -ftime-report."""
+    phases = []
+    for line in stderr.splitlines():
+        m = GCC_PHASE.match(line)
+        if m and not m.group("name").startswith("TOTAL"):
+            phases.append({"name": m.group("name"),
+                           "seconds": float(m.group("wall"))})
+    phases.sort(key=lambda p: p["seconds"], reverse=True)
+    return phases[:top]
+
+
+def clang_hotspots(trace_path, top):
+    """The slowest events from clang's -ftime-trace, the "Total ..." events
+    are totals per kind (e.g. InstantiateClass) and the others are
+    individual templates or functions."""
+    with open(trace_path) as f:
+        events = json.load(f)["traceEvents"]
+    totals = {}
+    for e in events:
+        if e.get("ph") != "X" or "dur" not in e:
+            continue
+        name = e["name"]
+        detail = e.get("args", {}).get("detail")
+        key = "{0} {1}".format(name, detail) if detail else name
+        totals[key] = totals.get(key, 0) + e["dur"] / 1e6
+    hot = [{"name": k, "seconds": v} for k, v in totals.items()
+           if k not in ("ExecuteCompiler", "Total ExecuteCompiler")]
+    hot.sort(key=lambda p: p["seconds"], reverse=True)
+    return hot[:top]
+
+
+def bench(cxx, size, include, std, flags, workdir, top):
+    src = os.path.join(workdir, "bench_{0}.cpp".format(size))
+    obj = os.path.join(workdir, "bench_{0}.o".format(size))
+    with open(src, "w") as f:
+        f.write(generate_source(size))
+    cmd = [cxx, "-std=" + std, "-I", include, "-c", src, "-o", obj] + flags
+    clang = is_clang(cxx)
+    cmd.append("-ftime-trace" if clang else "-ftime-report")
+    wall, rss, stderr = run_with_rusage(cmd, workdir)
+    if clang:
+        hotspots = clang_hotspots(os.path.splitext(obj)[0] + ".json", top)
+    else:
+        hotspots = gcc_hotspots(stderr, top)
+    return {"compiler": cxx, "version": compiler_version(cxx), "size": size,
+            "wall_s": round(wall, 3), "peak_rss_kb": rss,
+            "hotspots": hotspots}
+
+
+def git_commit(include):
+    out = sp.run(["git", "rev-parse", "HEAD"], cwd=include, stdout=sp.PIPE,
+                 stderr=sp.DEVNULL, universal_newlines=True)
+    return out.stdout.strip() or None
+
+
+def compare(report, baseline, threshold):
+    """Print the change from baseline for each result, returns False if any
+    wall time or peak RSS grew by more than threshold."""
+    old = {(r["compiler"], r["size"]): r for r in baseline["results"]}
+    ok = True
+    for r in report["results"]:
+        b = old.get((r["compiler"], r["size"]))
+        if b is None:
+            continue
+        for key in ("wall_s", "peak_rss_kb"):
+            change = (r[key] - b[key]) / b[key] if b[key] else 0.0
+            regressed = change > threshold
+            ok = ok and not regressed
+            print("{0:>10} {1:>6} {2:>12}: {3:>12} -> {4:>12} ({5:+.1%}){6}"
+                  .format(r["compiler"], r["size"], key, b[key], r[key],
+                          change, "  REGRESSION" if regressed else ""))
+    return ok
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--include", default=os.path.dirname(
+        os.path.abspath(__file__)), help="directory with the units headers")
+    parser.add_argument("--out", default="compile_bench.json")
+    parser.add_argument("--cxx", nargs="+", default=None,
+                        help="compilers, defaults to g++ and clang++ if "
+                             "they are on the PATH")
+    parser.add_argument("--sizes", nargs="+", type=int,
+                        default=DEFAULT_SIZES)
+    parser.add_argument("--std", default="gnu++2a")
+    parser.add_argument("--flags", nargs="*", default=["-O2"])
+    parser.add_argument("--top", type=int, default=10,
+                        help="number of hotspots to keep per result")
+    parser.add_argument("--baseline", default=None,
+                        help="an earlier report to compare against")
+    parser.add_argument("--threshold", type=float, default=0.1)
+    args = parser.parse_args()
+
+    compilers = args.cxx or [c for c in ("g++", "clang++") if shutil.which(c)]
+    report = {"commit": git_commit(args.include),
+              "date": datetime.datetime.utcnow().isoformat() + "Z",
+              "std": args.std, "flags": args.flags, "results": []}
+    workdir = tempfile.mkdtemp(prefix="units_compile_bench_")
+    try:
+        for cxx in compilers:
+            for size in args.sizes:
+                result = bench(cxx, size, args.include, args.std, args.flags,
+                               workdir, args.top)
+                print("{0:>10} {1:>6} types: {2:8.2f} s {3:10d} KB".format(
+                    cxx, size, result["wall_s"], result["peak_rss_kb"]))
+                report["results"].append(result)
+    finally:
+        shutil.rmtree(workdir)
+
+    with open(args.out, "w") as f:
+        json.dump(report, f, indent=2)
+    print("report written to " + args.out)
+
+    if args.baseline:
+        with open(args.baseline) as f:
+            if not compare(report, json.load(f), args.threshold):
+                return 1
+    return 0
+
+
+if __name__ == "__main__":
+    exit(main())
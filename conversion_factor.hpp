@@ -0,0 +1,290 @@
+#pragma once
+
+#include "force_inline.hpp"
+#include "prefix_value.hpp"
+
+#include <cassert>
+#include <cstdint>
+#include <limits>
+#include <ratio>
+#include <stdexcept>
+#include <type_traits>
+
+namespace units {
+  namespace Impl {
+    constexpr bool is_power_of_two(std::uintmax_t v) {
+      return v != 0 && (v & (v - 1)) == 0;
+    }
+
+    constexpr int bit_width(std::uintmax_t v) {
+      auto width = 0;
+      for (; v != 0; v >>= 1) {
+        ++width;
+      }
+      return width;
+    }
+
+    /// v * 2^exp, exact unless the result over or underflows T.
+    template <class T>
+    constexpr T times_power_of_two(T v, int exp) {
+      for (; exp > 0; --exp) {
+        v *= 2;
+      }
+      for (; exp < 0; ++exp) {
+        v /= 2;
+      }
+      return v;
+    }
+
+    /** m * 2^exp, where m has two more bits than T holds, rounded to
+     * nearest (ties to even) using those two bits and sticky, which is set
+     * if anything nonzero was dropped below them. */
+    template <class T>
+    constexpr T round_quotient(std::uintmax_t m, int exp, bool sticky) {
+      constexpr auto digits = std::numeric_limits<T>::digits;
+      const auto guard = (m & 2) != 0;
+      const auto round = (m & 1) != 0;
+      m >>= 2;
+      exp += 2;
+      if (guard && (round || sticky || (m & 1) != 0)) {
+        ++m;
+        if (bit_width(m) > digits) {
+          m >>= 1;
+          ++exp;
+        }
+      }
+      return times_power_of_two(static_cast<T>(m), exp);
+    }
+
+    /** num / den rounded once, to nearest (ties to even), to the floating
+     * point type T. The quotient is found by long division to two more bits
+     * than T holds, plus a sticky bit for the remainder, so there is none of
+     * the double rounding of converting num and den to T then dividing. */
+    template <class T>
+    constexpr T correctly_rounded_quotient(std::uintmax_t num,
+                                           std::uintmax_t den) {
+      constexpr auto digits = std::numeric_limits<T>::digits;
+      constexpr auto max_digits = std::numeric_limits<std::uintmax_t>::digits;
+      if constexpr (digits + 2 >= max_digits) {
+        return static_cast<T>(num) / static_cast<T>(den);
+      } else {
+        constexpr auto exact = std::uintmax_t{1} << digits;
+        if (num <= exact && den <= exact) {
+          // both are exact in T, so IEEE division rounds once
+          return static_cast<T>(num) / static_cast<T>(den);
+        }
+        auto m = num / den;
+        auto r = num % den;
+        auto exp = 0;
+        auto sticky = false;
+        if (bit_width(m) <= digits + 2) {
+          while (bit_width(m) < digits + 2) {
+            // r < den <= INTMAX_MAX, so doubling r cannot overflow
+            r *= 2;
+            m = m * 2 + (r >= den ? 1 : 0);
+            r = r >= den ? r - den : r;
+            --exp;
+          }
+          sticky = r != 0;
+        } else {
+          while (bit_width(m) > digits + 2) {
+            sticky = sticky || (m & 1) != 0;
+            m >>= 1;
+            ++exp;
+          }
+          sticky = sticky || r != 0;
+        }
+        return round_quotient<T>(m, exp, sticky);
+      }
+    }
+
+    /// v as the floating point type T, for types too wide to round with a
+    /// std::uintmax_t mantissa.
+    template <class T, int Words>
+    constexpr T to_floating_point(const BigUint<Words>& v) {
+      auto r = T{};
+      for (auto i = Words - 1; i >= 0; --i) {
+        r = r * T{4294967296.0} + static_cast<T>(v.word[i]);
+      }
+      return r;
+    }
+
+    /** n / d rounded once to the floating point type T, as
+     * correctly_rounded_quotient, for the wide values of prefixes with an
+     * exponent. */
+    template <class T, int Words>
+    constexpr T correctly_rounded_quotient(BigUint<Words> n,
+                                           BigUint<Words> d) {
+      constexpr auto digits = std::numeric_limits<T>::digits;
+      constexpr auto max_digits = std::numeric_limits<std::uintmax_t>::digits;
+      if constexpr (digits + 2 >= max_digits) {
+        return to_floating_point<T>(n) / to_floating_point<T>(d);
+      } else {
+        // shift so the quotient has digits + 2 or digits + 3 bits
+        auto exp = n.bit_width() - d.bit_width() - (digits + 2);
+        if (exp < 0) {
+          n.shift_left(-exp);
+        } else {
+          d.shift_left(exp);
+        }
+        auto m = std::uintmax_t{};
+        for (auto i = digits + 2; i >= 0; --i) {
+          auto s = d;
+          s.shift_left(i);
+          m <<= 1;
+          if (!(n < s)) {
+            n.subtract(s);
+            m |= 1;
+          }
+        }
+        auto sticky = !n.is_zero();
+        while (bit_width(m) > digits + 2) {
+          sticky = sticky || (m & 1) != 0;
+          m >>= 1;
+          ++exp;
+        }
+        return round_quotient<T>(m, exp, sticky);
+      }
+    }
+
+    /// The largest power of ten in a prefix that can be rounded to a
+    /// BaseType, well beyond the range of double.
+    inline constexpr int max_prefix_exponent = 330;
+
+    /// The prefix p rounded once to the floating point type T.
+    template <class T>
+    constexpr T rounded_prefix(const PrefixValue& p) {
+      assert(p.num > 0);
+      if (p.is_ratio()) {
+        return correctly_rounded_quotient<T>(p.num, p.den);
+      }
+      if (p.exponent > max_prefix_exponent ||
+          p.exponent < -max_prefix_exponent) {
+        throw std::overflow_error("prefix exponent out of range");
+      }
+      // room for INTMAX_MAX * 10^330 (1159 bits) shifted by the long division
+      using Wide = BigUint<44>;
+      auto n = Wide{static_cast<std::uintmax_t>(p.num)};
+      auto d = Wide{static_cast<std::uintmax_t>(p.den)};
+      for (auto e = p.exponent; e > 0; --e) {
+        n.multiply(10);
+      }
+      for (auto e = p.exponent; e < 0; ++e) {
+        d.multiply(10);
+      }
+      return correctly_rounded_quotient<T>(n, d);
+    }
+  } // namespace Impl
+
+  /** A prefix ratio folded into a single BaseType constant. The division is
+   * done once at compile time so converting a value is one multiply. */
+  template <class Ratio, class BaseType>
+  constexpr BaseType conversion_factor() {
+    if constexpr (is_extended_prefix(Ratio{})) {
+      static_assert(std::is_floating_point_v<BaseType>,
+                    "prefixes beyond a std::ratio need a floating point "
+                    "BaseType");
+      return Impl::rounded_prefix<BaseType>(Ratio::value);
+    } else if constexpr (std::is_floating_point_v<BaseType>) {
+      static_assert(Ratio::num > 0 && Ratio::den > 0);
+      return Impl::correctly_rounded_quotient<BaseType>(Ratio::num,
+                                                        Ratio::den);
+    } else {
+      static_assert(Ratio::num > 0 && Ratio::den > 0);
+      static_assert(Ratio::den == 1, "only integral factors are exact for "
+                                     "integral BaseTypes");
+      return static_cast<BaseType>(Ratio::num);
+    }
+  }
+
+  /** True if multiplying by the conversion factor gives the same answer as
+   * the exact v * num / den (before the final rounding), i.e. the factor is
+   * exactly representable: an integer (e.g. kilo, or any power of ten up to
+   * 10^22 for doubles) or one divided by a power of two. */
+  template <class Ratio, class BaseType>
+  constexpr bool is_exact_conversion_factor() {
+    if constexpr (std::is_floating_point_v<BaseType>) {
+      constexpr auto digits = std::numeric_limits<BaseType>::digits;
+      auto odd = static_cast<std::uintmax_t>(Ratio::num);
+      while ((odd & 1) == 0) {
+        odd >>= 1;
+      }
+      return Impl::is_power_of_two(Ratio::den) &&
+             Impl::bit_width(odd) <= digits;
+    } else {
+      return Ratio::den == 1;
+    }
+  }
+
+  namespace Impl {
+    /// True if scale_by divides by Ratio::den rather than multiplying by
+    /// the rounded 1 / den: one over an integer a BaseType holds exactly,
+    /// which isn't a power of two.
+    template <class Ratio, class BaseType>
+    constexpr bool scales_by_division() {
+      if constexpr (is_extended_prefix(Ratio{}) ||
+                    !std::is_floating_point_v<BaseType>) {
+        return false;
+      } else if constexpr (Ratio::num != 1) {
+        return false;
+      } else {
+        return !is_exact_conversion_factor<Ratio, BaseType>() &&
+               is_exact_conversion_factor<std::ratio<Ratio::den>,
+                                          BaseType>();
+      }
+    }
+  } // namespace Impl
+
+  /** Convert a value by the prefix ratio Ratio (e.g. Ratio = kilo converts
+   * km to m).
+   *  - a ratio of one does no work at all,
+   *  - an ExtendedPrefix, one beyond a std::ratio, is a single multiply by
+   *    the constant rounded once from its exact value,
+   *  - exact factors (integers, powers of ten up to the precision of
+   *    BaseType, powers of two) are a single exact multiply,
+   *  - one over an exact integer, e.g. milli or nano, is a single divide by
+   *    it, which is correctly rounded where a multiply by the rounded
+   *    1 / den can be an ulp out,
+   *  - any other factor for a floating point BaseType is a single multiply
+   *    by the correctly rounded constant num / den,
+   *  - integral BaseTypes multiply then divide, which truncates as integer
+   *    division does.
+   */
+  template <class Ratio, class BaseType>
+  UNITS_INLINE constexpr BaseType scale_by(const BaseType& v) noexcept {
+    if constexpr (is_extended_prefix(Ratio{})) {
+      constexpr auto factor = conversion_factor<Ratio, BaseType>();
+      return v * factor;
+    } else if constexpr (Ratio::num == Ratio::den) {
+      return v;
+    } else if constexpr (Impl::scales_by_division<Ratio, BaseType>()) {
+      return v / static_cast<BaseType>(Ratio::den);
+    } else if constexpr (std::is_floating_point_v<BaseType>) {
+      constexpr auto factor = conversion_factor<Ratio, BaseType>();
+      return v * factor;
+    } else if constexpr (Ratio::den == 1) {
+      return v * Ratio::num;
+    } else {
+      return v * Ratio::num / Ratio::den;
+    }
+  }
+
+  static_assert(conversion_factor<std::kilo, double>() == 1000.);
+  static_assert(conversion_factor<std::milli, double>() == 0.001);
+  static_assert(conversion_factor<std::ratio<1, 3>, double>() == 1. / 3);
+  static_assert(conversion_factor<std::ratio<2, 3>, float>() == 2.f / 3);
+  static_assert(conversion_factor<std::ratio<254, 10000>, double>() == 0.0254);
+  static_assert(conversion_factor<std::atto, double>() == 1e-18);
+  static_assert(conversion_factor<std::exa, double>() == 1e18);
+  static_assert(is_exact_conversion_factor<std::giga, double>());
+  static_assert(is_exact_conversion_factor<std::ratio<1, 1024>, float>());
+  static_assert(!is_exact_conversion_factor<std::milli, double>());
+  static_assert(scale_by<std::ratio<1, 1>>(3) == 3);
+  static_assert(scale_by<std::kilo>(3) == 3000);
+  static_assert(scale_by<std::milli>(3500) == 3);
+  static_assert(scale_by<std::milli>(9.0) == 9.0 / 1000);
+  static_assert(conversion_factor<ExtendedPrefix<PrefixValue{1, 1, 30}>,
+                                  double>() == 1e30);
+  static_assert(conversion_factor<ExtendedPrefix<PrefixValue{1, 3, -40}>,
+                                  double>() == 1e-40 / 3);
+} // namespace units
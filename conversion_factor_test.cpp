@@ -0,0 +1,58 @@
+#include "common_quantities.hpp"
+#include "conversion_factor.hpp"
+#include <catch.hpp>
+
+SCENARIO("Testing the conversion factors") {
+  GIVEN("some prefixes") {
+    THEN("factors that are exact are flagged as exact") {
+      static_assert(units::is_exact_conversion_factor<units::kilo, double>());
+      static_assert(units::is_exact_conversion_factor<units::giga, float>());
+      static_assert(
+          units::is_exact_conversion_factor<std::ratio<1, 8>, double>());
+      static_assert(
+          !units::is_exact_conversion_factor<units::centi, double>());
+      static_assert(
+          !units::is_exact_conversion_factor<std::ratio<1, 3>, double>());
+    }
+    THEN("the factors are the nearest doubles to num / den") {
+      REQUIRE(units::conversion_factor<units::centi, double>() == 0.01);
+      REQUIRE(units::conversion_factor<std::ratio<37'854'118, 10'000'000>,
+                                       double>() == 3.7854118);
+      REQUIRE(units::conversion_factor<std::ratio<454'609, 100'000>,
+                                       float>() == 4.54609f);
+    }
+    THEN("one over a power of ten divides by it exactly") {
+      static_assert(units::Impl::scales_by_division<units::milli, double>());
+      static_assert(units::Impl::scales_by_division<units::nano, float>());
+      static_assert(
+          !units::Impl::scales_by_division<std::ratio<1, 8>, double>());
+      // a multiply by the rounded 0.001 is an ulp out for 9
+      REQUIRE(9.0 * 0.001 != 9.0 / 1000);
+      REQUIRE(units::scale_by<units::milli>(9.0) == 9.0 / 1000);
+      REQUIRE(units::scale_by<units::micro>(7.0f) == 7.0f / 1'000'000);
+    }
+    THEN("a ratio of one is not applied at all") {
+      REQUIRE(units::scale_by<units::unity>(0.1) == 0.1);
+    }
+    THEN("integral values are scaled exactly by integral factors") {
+      REQUIRE(units::scale_by<units::giga>(std::int64_t{3}) ==
+              3'000'000'000);
+      REQUIRE(units::scale_by<units::milli>(std::int64_t{2'999}) == 2);
+    }
+  }
+
+  GIVEN("Quantities with different prefixes") {
+    THEN("mixed prefix arithmetic uses the folded factors") {
+      REQUIRE(km{1.5} + metres{20} == metres{1520});
+      REQUIRE(metres{20} + km{1.5} == metres{1520});
+      REQUIRE((km{1} += metres{500}) == km{1.5});
+      REQUIRE((km{1} -= metres{500}) == km{0.5});
+      REQUIRE(km{2}.underlying_value_no_prefix() == 2000);
+    }
+    THEN("scaling by a dimensionless Quantity only uses its own prefix") {
+      auto two_million = Quantity<units::derived_t<units::mega>>{2};
+      REQUIRE((km{2} *= two_million) == km{4'000'000});
+      REQUIRE((km{2} /= two_million) == km{1e-6});
+    }
+  }
+}
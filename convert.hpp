@@ -0,0 +1,279 @@
+#pragma once
+
+#include "conversion_factor.hpp"
+#include "quantity.hpp"
+#include "quantity_cast.hpp"
+#include "quantity_vector.hpp"
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <immintrin.h>
+#define UNITS_HAS_STREAMING_STORES 1
+#else
+#define UNITS_HAS_STREAMING_STORES 0
+#endif
+
+// ************************************************************************* /
+//    Bulk conversion between buffers of Quantities with the same dimensions /
+//    but different prefixes, e.g. km to metres or us_gallon to litres, and  /
+//    between BaseTypes, e.g. float storage to double (narrow goes back).    /
+//    The dimensions and tags are checked once at compile time, then the     /
+//    buffer is converted in a single pass with the prefixes folded into one /
+//    constant (see conversion_factor.hpp).                                  /
+// ************************************************************************* /
+
+namespace units {
+  namespace Impl {
+    template <class UnitsFrom, class UnitsTo, class Tag0, class Tag1>
+    constexpr void check_convertible() {
+      use_dimension_names<same_dimension(UnitsFrom{}, UnitsTo{}),
+                          decltype(make_names_from_dimension(UnitsFrom{})),
+                          decltype(make_names_from_dimension(UnitsTo{}))>();
+      static_assert(std::is_same_v<Tag0, Tag1>);
+    }
+
+    /// The factor converting a value in UnitsFrom to one in UnitsTo.
+    template <class UnitsFrom, class UnitsTo>
+    using conversion_ratio = prefix_divide_t<UnitsFrom, UnitsTo>;
+
+    template <class Obj>
+    struct is_span : std::false_type {};
+
+    template <class T, std::size_t Extent>
+    struct is_span<std::span<T, Extent>> : std::true_type {};
+
+    template <class Obj>
+    constexpr bool is_span_v = is_span<std::remove_cvref_t<Obj>>::value;
+
+#if UNITS_HAS_STREAMING_STORES
+    /** out[i] = scale_by<Ratio>(in[i]) with non-temporal stores, which write
+     * straight to memory rather than pulling the destination into the cache.
+     * Returns the number of elements converted, the caller converts the
+     * rest. */
+    template <class Ratio, class BaseType>
+    std::size_t streaming_scale(BaseType* out, const BaseType* in,
+                                std::size_t n) noexcept {
+      constexpr auto width = 16 / sizeof(BaseType);
+      // the same single multiply or divide as scale_by
+      constexpr auto divide = scales_by_division<Ratio, BaseType>();
+      constexpr auto factor = [] {
+        if constexpr (divide) {
+          return static_cast<BaseType>(Ratio::den);
+        } else {
+          return conversion_factor<Ratio, BaseType>();
+        }
+      }();
+      std::size_t i = 0;
+      if constexpr (std::is_same_v<BaseType, double> ||
+                    std::is_same_v<BaseType, float>) {
+        // the streaming stores need an aligned destination
+        for (; i < n && reinterpret_cast<std::uintptr_t>(out + i) % 16 != 0;
+             ++i) {
+          out[i] = scale_by<Ratio>(in[i]);
+        }
+        if constexpr (std::is_same_v<BaseType, double>) {
+          const auto f = _mm_set1_pd(factor);
+          for (; i + width <= n; i += width) {
+            const auto v = _mm_loadu_pd(in + i);
+            _mm_stream_pd(out + i, divide ? _mm_div_pd(v, f)
+                                          : _mm_mul_pd(v, f));
+          }
+        } else {
+          const auto f = _mm_set1_ps(factor);
+          for (; i + width <= n; i += width) {
+            const auto v = _mm_loadu_ps(in + i);
+            _mm_stream_ps(out + i, divide ? _mm_div_ps(v, f)
+                                          : _mm_mul_ps(v, f));
+          }
+        }
+        // make the streamed stores visible before the caller reads them
+        _mm_sfence();
+      }
+      return i;
+    }
+#endif
+  } // namespace Impl
+
+  /** Convert every element of from into the units of to, which must be the
+   * same size. Only compiles if the dimensions and tags match. */
+  template <class UnitsFrom, class UnitsTo, class BaseType, class Tag0,
+            class Tag1, std::size_t Extent0, std::size_t Extent1>
+  void
+  convert(std::span<const Quantity<UnitsFrom, BaseType, Tag0>, Extent0> from,
+          std::span<Quantity<UnitsTo, BaseType, Tag1>, Extent1> to) {
+    Impl::check_convertible<UnitsFrom, UnitsTo, Tag0, Tag1>();
+    using Ratio = Impl::conversion_ratio<UnitsFrom, UnitsTo>;
+    assert(from.size() == to.size());
+    const auto* in = Impl::underlying_data(from.data());
+    auto* out = Impl::underlying_data(to.data());
+    const auto n = from.size();
+    for (std::size_t i = 0; i < n; ++i) {
+      out[i] = scale_by<Ratio>(in[i]);
+    }
+  }
+
+  /** As above from a narrower BaseType to a wider one, e.g. float samples
+   * into double metres. Each value is widened and then scaled, so nothing
+   * is lost. Going the other way is narrow. */
+  template <class UnitsFrom, class UnitsTo, class BaseType0, class BaseType1,
+            class Tag0, class Tag1, std::size_t Extent0, std::size_t Extent1,
+            typename = std::enable_if_t<widens_to_v<BaseType1, BaseType0>>>
+  void
+  convert(std::span<const Quantity<UnitsFrom, BaseType0, Tag0>, Extent0> from,
+          std::span<Quantity<UnitsTo, BaseType1, Tag1>, Extent1> to) {
+    Impl::check_convertible<UnitsFrom, UnitsTo, Tag0, Tag1>();
+    using Ratio = Impl::conversion_ratio<UnitsFrom, UnitsTo>;
+    assert(from.size() == to.size());
+    const auto* in = Impl::underlying_data(from.data());
+    auto* out = Impl::underlying_data(to.data());
+    const auto n = from.size();
+    for (std::size_t i = 0; i < n; ++i) {
+      out[i] = scale_by<Ratio>(static_cast<BaseType1>(in[i]));
+    }
+  }
+
+  /** As above for any contiguous ranges (std::vector, std::array,
+   * QuantityVector...) e.g. convert(kilometres, metres). */
+  template <class From, class To,
+            typename = std::enable_if_t<!Impl::is_span_v<From> ||
+                                        !Impl::is_span_v<To>>>
+  auto convert(const From& from, To&& to)
+      -> decltype(convert(std::span{from}, std::span{to})) {
+    return convert(std::span{from}, std::span{to});
+  }
+
+  /** Convert every element of from into the units and the narrower BaseType
+   * of to, e.g. double results to float for storage. Each value is scaled
+   * in the wider BaseType then converted as by static_cast, so doubles are
+   * rounded to the nearest float and a floating point value is truncated
+   * towards zero into an integral BaseType. Values out of range aren't
+   * checked, see checked_narrow. */
+  template <class UnitsFrom, class UnitsTo, class BaseType0, class BaseType1,
+            class Tag0, class Tag1, std::size_t Extent0, std::size_t Extent1,
+            typename = std::enable_if_t<std::is_arithmetic_v<BaseType1>>>
+  void
+  narrow(std::span<const Quantity<UnitsFrom, BaseType0, Tag0>, Extent0> from,
+         std::span<Quantity<UnitsTo, BaseType1, Tag1>, Extent1> to) noexcept {
+    Impl::check_convertible<UnitsFrom, UnitsTo, Tag0, Tag1>();
+    using Ratio = Impl::conversion_ratio<UnitsFrom, UnitsTo>;
+    using Common = promoted_base_t<BaseType0, BaseType1>;
+    assert(from.size() == to.size());
+    const auto* in = Impl::underlying_data(from.data());
+    auto* out = Impl::underlying_data(to.data());
+    const auto n = from.size();
+    for (std::size_t i = 0; i < n; ++i) {
+      const auto v = scale_by<Ratio>(static_cast<Common>(in[i]));
+      out[i] = static_cast<BaseType1>(v);
+    }
+  }
+
+  template <class From, class To,
+            typename = std::enable_if_t<!Impl::is_span_v<From> ||
+                                        !Impl::is_span_v<To>>>
+  auto narrow(const From& from, To&& to)
+      -> decltype(narrow(std::span{from}, std::span{to})) {
+    return narrow(std::span{from}, std::span{to});
+  }
+
+  /** As narrow, but throws std::overflow_error if a value doesn't fit in
+   * to's BaseType (or the scaled value overflows), after converting the
+   * values before it. Infinities fit any floating point BaseType, NaNs are
+   * out of range. */
+  template <class UnitsFrom, class UnitsTo, class BaseType0, class BaseType1,
+            class Tag0, class Tag1, std::size_t Extent0, std::size_t Extent1,
+            typename = std::enable_if_t<std::is_arithmetic_v<BaseType1>>>
+  void checked_narrow(
+      std::span<const Quantity<UnitsFrom, BaseType0, Tag0>, Extent0> from,
+      std::span<Quantity<UnitsTo, BaseType1, Tag1>, Extent1> to) {
+    Impl::check_convertible<UnitsFrom, UnitsTo, Tag0, Tag1>();
+    using Ratio = Impl::conversion_ratio<UnitsFrom, UnitsTo>;
+    using Common = promoted_base_t<BaseType0, BaseType1>;
+    assert(from.size() == to.size());
+    const auto* in = Impl::underlying_data(from.data());
+    auto* out = Impl::underlying_data(to.data());
+    const auto n = from.size();
+    for (std::size_t i = 0; i < n; ++i) {
+      const auto v = checked_scale_by<Ratio>(static_cast<Common>(in[i]));
+      if (!Impl::in_range<BaseType1>(v)) {
+        throw std::overflow_error("units::checked_narrow: a value does not "
+                                  "fit in the BaseType");
+      }
+      out[i] = static_cast<BaseType1>(v);
+    }
+  }
+
+  template <class From, class To,
+            typename = std::enable_if_t<!Impl::is_span_v<From> ||
+                                        !Impl::is_span_v<To>>>
+  auto checked_narrow(const From& from, To&& to)
+      -> decltype(checked_narrow(std::span{from}, std::span{to})) {
+    return checked_narrow(std::span{from}, std::span{to});
+  }
+
+  /** Convert the elements of q to UnitsTo in place, returning a span of the
+   * converted Quantities over the same memory. The original span must not be
+   * used afterwards, the objects it referred to have been replaced. */
+  template <class UnitsTo, class UnitsFrom, class BaseType, class Tag,
+            std::size_t Extent>
+  auto
+  convert_in_place(std::span<Quantity<UnitsFrom, BaseType, Tag>, Extent> q) {
+    Impl::check_convertible<UnitsFrom, UnitsTo, Tag, Tag>();
+    using From = Quantity<UnitsFrom, BaseType, Tag>;
+    using To = Quantity<UnitsTo, BaseType, Tag>;
+    static_assert(sizeof(From) == sizeof(To) && alignof(From) == alignof(To));
+    static_assert(std::is_trivially_copyable_v<From> &&
+                  std::is_trivially_destructible_v<From>);
+    using Ratio = Impl::conversion_ratio<UnitsFrom, UnitsTo>;
+    auto* p = q.data();
+    const auto n = q.size();
+    for (std::size_t i = 0; i < n; ++i) {
+      const auto v = p[i].underlying_value();
+      ::new (static_cast<void*>(p + i)) To{scale_by<Ratio>(v)};
+    }
+    return std::span<To, Extent>{std::launder(reinterpret_cast<To*>(p)), n};
+  }
+
+  /** As convert, but the destination is written with non-temporal (streaming)
+   * stores where the target supports them (SSE2 for float and double). Use
+   * for buffers larger than the cache that will not be read again soon, the
+   * destination is then not read into the cache before being overwritten,
+   * which saves a third of the memory traffic. Falls back to convert
+   * otherwise. */
+  template <class UnitsFrom, class UnitsTo, class BaseType, class Tag0,
+            class Tag1, std::size_t Extent0, std::size_t Extent1>
+  void convert_streaming(
+      std::span<const Quantity<UnitsFrom, BaseType, Tag0>, Extent0> from,
+      std::span<Quantity<UnitsTo, BaseType, Tag1>, Extent1> to) {
+    Impl::check_convertible<UnitsFrom, UnitsTo, Tag0, Tag1>();
+    using Ratio = Impl::conversion_ratio<UnitsFrom, UnitsTo>;
+    assert(from.size() == to.size());
+    const auto* in = Impl::underlying_data(from.data());
+    auto* out = Impl::underlying_data(to.data());
+    const auto n = from.size();
+    std::size_t i = 0;
+#if UNITS_HAS_STREAMING_STORES
+    if constexpr (std::is_floating_point_v<BaseType>) {
+      i = Impl::streaming_scale<Ratio>(out, in, n);
+    }
+#endif
+    for (; i < n; ++i) {
+      out[i] = scale_by<Ratio>(in[i]);
+    }
+  }
+
+  template <class From, class To,
+            typename = std::enable_if_t<!Impl::is_span_v<From> ||
+                                        !Impl::is_span_v<To>>>
+  auto convert_streaming(const From& from, To&& to)
+      -> decltype(convert_streaming(std::span{from}, std::span{to})) {
+    return convert_streaming(std::span{from}, std::span{to});
+  }
+} // namespace units
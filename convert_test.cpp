@@ -0,0 +1,128 @@
+#include "common_quantities.hpp"
+#include "convert.hpp"
+#include "quantity_vector.hpp"
+#include <catch.hpp>
+
+#include <array>
+#include <cstdint>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+SCENARIO("Testing bulk conversion between prefixes") {
+  using units::QuantityVector;
+  GIVEN("a buffer of distances in km") {
+    auto distances = std::vector<km>{km{1}, km{0.5}, km{-2}, km{0}};
+    WHEN("converting into a buffer of metres") {
+      auto out = std::vector<metres>(distances.size());
+      units::convert(distances, out);
+      THEN("every element is scaled by the prefix") {
+        REQUIRE(out[0] == metres{1000});
+        REQUIRE(out[1] == metres{500});
+        REQUIRE(out[2] == metres{-2000});
+        REQUIRE(out[3] == metres{0});
+      }
+    }
+    WHEN("converting through spans") {
+      auto out = std::array<metres, 2>{};
+      units::convert(std::span<const km>{distances}.first(2),
+                     std::span<metres, 2>{out});
+      THEN("only the elements in the span are converted") {
+        REQUIRE(out[0] == metres{1000});
+        REQUIRE(out[1] == metres{500});
+      }
+    }
+    WHEN("converting in place") {
+      auto in_metres = units::convert_in_place<metres_t>(std::span{distances});
+      THEN("the same memory now holds metres") {
+        static_assert(std::is_same_v<decltype(in_metres)::value_type, metres>);
+        REQUIRE(static_cast<void*>(in_metres.data()) ==
+                static_cast<void*>(distances.data()));
+        REQUIRE(in_metres[0] == metres{1000});
+        REQUIRE(in_metres[2] == metres{-2000});
+      }
+    }
+  }
+  GIVEN("volumes in US gallons") {
+    auto gallons = QuantityVector<us_gallon_t>(1001);
+    for (auto i = 0u; i < gallons.size(); ++i) {
+      gallons[i] = us_gallon{static_cast<double>(i)};
+    }
+    WHEN("converting to litres") {
+      auto out = QuantityVector<litres_t>(gallons.size());
+      units::convert(gallons, out);
+      THEN("the result matches converting each Quantity on its own") {
+        for (auto i = 0u; i < gallons.size(); ++i) {
+          REQUIRE(out[i] == litres{} + gallons[i]);
+        }
+      }
+    }
+    WHEN("converting with streaming stores into an unaligned destination") {
+      auto out = std::vector<litres>(gallons.size() + 1);
+      units::convert_streaming(std::span<const us_gallon>{gallons},
+                               std::span{out}.subspan(1));
+      THEN("the result is the same as the plain conversion") {
+        auto expected = QuantityVector<litres_t>(gallons.size());
+        units::convert(gallons, expected);
+        for (auto i = 0u; i < gallons.size(); ++i) {
+          REQUIRE(out[i + 1] == expected[i]);
+        }
+      }
+    }
+  }
+
+  GIVEN("lengths in metres") {
+    auto ms = std::vector<metres>(1001);
+    for (auto i = 0u; i < ms.size(); ++i) {
+      ms[i] = metres{static_cast<double>(i)};
+    }
+    WHEN("converting to km, plainly and with streaming stores") {
+      auto plain = std::vector<km>(ms.size());
+      auto streamed = std::vector<km>(ms.size() + 1);
+      units::convert(ms, plain);
+      units::convert_streaming(std::span<const metres>{ms},
+                               std::span{streamed}.subspan(1));
+      THEN("both divide exactly by 1000") {
+        for (auto i = 0u; i < ms.size(); ++i) {
+          const auto expected = static_cast<double>(i) / 1000;
+          REQUIRE(plain[i].underlying_value() == expected);
+          REQUIRE(streamed[i + 1].underlying_value() == expected);
+        }
+      }
+    }
+  }
+
+  GIVEN("pressures computed in double") {
+    using fkPa = Quantity<units::derived_t<units::kilo, Pascals_t>, float>;
+    const auto ps = std::vector<Pascals>{Pascals{101325}, Pascals{0.1},
+                                         Pascals{-2500}};
+    WHEN("narrowing them to float kPa for storage") {
+      auto stored = std::vector<fkPa>(ps.size());
+      units::narrow(ps, stored);
+      THEN("each is rounded to the nearest float") {
+        REQUIRE(stored[0].underlying_value() == 101.325f);
+        REQUIRE(stored[1].underlying_value() == 1e-4f);
+        REQUIRE(stored[2] == fkPa{-2.5f});
+      }
+      THEN("widening them again is within float precision") {
+        auto back = std::vector<Pascals>(ps.size());
+        units::convert(stored, back);
+        for (auto i = 0u; i < ps.size(); ++i) {
+          REQUIRE(back[i].underlying_value() ==
+                  Approx(ps[i].underlying_value()).epsilon(1e-7));
+        }
+      }
+    }
+    WHEN("narrowing to an integral BaseType") {
+      using Pa16 = Quantity<Pascals_t, std::int16_t>;
+      auto out = std::vector<Pa16>(ps.size());
+      THEN("checked_narrow throws on overflow") {
+        REQUIRE_THROWS_AS(units::checked_narrow(ps, out), std::overflow_error);
+        units::checked_narrow(std::span{ps}.subspan(1),
+                              std::span{out}.first(2));
+        REQUIRE(out[0] == Pa16{0});
+        REQUIRE(out[1] == Pa16{-2500});
+      }
+    }
+  }
+}
@@ -0,0 +1,404 @@
+#pragma once
+
+#include "conversion_factor.hpp"
+#include "quantity.hpp"
+#include "quantity_cast.hpp"
+#include "unit_parser.hpp"
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <istream>
+#include <iterator>
+#include <ostream>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// ************************************************************************* /
+//    Streaming CSV (or TSV) of Quantity columns. The units are in the       /
+//    header, e.g. "length [km],time [s]", and are checked once per file     /
+//    rather than printed after every value. Values are parsed a chunk at a  /
+//    time with std::from_chars, optionally split across threads, and        /
+//    written with std::to_chars, so they round trip exactly.                /
+// ************************************************************************* /
+
+namespace units {
+  struct CsvOptions {
+    char delimiter = ',';
+    /// Threads to parse each chunk with, 1 parses on the calling thread
+    unsigned threads = 1;
+    /// Bytes read (or written) at a time
+    std::size_t chunk_size = std::size_t{1} << 22;
+  };
+
+  namespace Impl {
+    constexpr std::string_view trim(std::string_view s) {
+      while (!s.empty() && (s.front() == ' ' || s.front() == '\t')) {
+        s.remove_prefix(1);
+      }
+      while (!s.empty() && (s.back() == ' ' || s.back() == '\t' ||
+                            s.back() == '\r')) {
+        s.remove_suffix(1);
+      }
+      return s;
+    }
+
+    /// A header field "name [unit]", the unit is empty if there are no
+    /// brackets.
+    constexpr std::pair<std::string_view, std::string_view>
+    split_header(std::string_view field) {
+      field = trim(field);
+      const auto open = field.rfind('[');
+      if (open == std::string_view::npos || field.back() != ']') {
+        return {field, {}};
+      }
+      return {trim(field.substr(0, open)),
+              trim(field.substr(open + 1, field.size() - open - 2))};
+    }
+
+    /** The factor converting values in the units of the header to Units,
+     * or throws std::invalid_argument if the dimensions are different. */
+    template <class Units, class BaseType>
+    BaseType header_factor(std::string_view name, std::string_view unit) {
+      const auto r = parse_unit(unit);
+      if (r.ec != std::errc{} || !r.code.same_dimension(Units::code)) {
+        throw std::invalid_argument(
+            "csv column \"" + std::string{name} + "\" has units [" +
+            std::string{unit} + "], expected [" + format_unit(Units::code) +
+            "]");
+      }
+      const auto ratio = r.code.prefix / Units::code.prefix;
+      if (ratio == Rational{1}) {
+        return 1;
+      }
+      if constexpr (std::is_floating_point_v<BaseType>) {
+        return rounded_prefix<BaseType>(ratio);
+      } else {
+        if (!ratio.is_ratio() || ratio.den != 1) {
+          throw std::invalid_argument("csv column \"" + std::string{name} +
+                                      "\" would need rounding");
+        }
+        return static_cast<BaseType>(ratio.num);
+      }
+    }
+
+    /// Where parsing a chunk failed, line is relative to the chunk
+    struct CsvError {
+      std::size_t line = 0;
+      std::size_t column = 0;
+      bool failed = false;
+    };
+  } // namespace Impl
+
+  /** Reads the columns of a CSV file into std::vectors of Qs, one per
+   * column, in order. The header is read and checked by the constructor:
+   * each field is "name [unit]", where unit is anything parse_unit takes,
+   * and must have the dimensions of the Quantity. If the prefix differs
+   * (e.g. [m] into km) the values are scaled by a factor worked out once.
+   *
+   *   auto reader = units::CsvReader<km, seconds>{file};
+   *   auto lengths = std::vector<km>{};
+   *   auto times = std::vector<seconds>{};
+   *   reader.read_all(lengths, times);
+   *
+   * Malformed values throw std::invalid_argument with the line number. */
+  template <class... Qs>
+  class CsvReader {
+  public:
+    static constexpr auto column_count = sizeof...(Qs);
+
+    explicit CsvReader(std::istream& in, CsvOptions options = {})
+        : _in{in}, _options{options} {
+      static_assert(column_count > 0);
+      static_assert((is_quantity(Qs{}) && ...), "columns must be Quantities");
+      auto header = std::string{};
+      if (!std::getline(_in, header)) {
+        throw std::invalid_argument("csv has no header");
+      }
+      auto fields = std::array<std::string_view, column_count>{};
+      auto rest = std::string_view{header};
+      for (auto i = std::size_t{}; i < column_count; ++i) {
+        const auto end = rest.find(_options.delimiter);
+        if ((end == std::string_view::npos) != (i + 1 == column_count)) {
+          throw std::invalid_argument("csv header has the wrong number of "
+                                      "columns");
+        }
+        fields[i] = rest.substr(0, end);
+        rest.remove_prefix(end == std::string_view::npos ? rest.size()
+                                                         : end + 1);
+      }
+      read_header(fields, std::index_sequence_for<Qs...>{});
+      _line = 1;
+    }
+
+    /// The names of the columns, without the units
+    const std::array<std::string, column_count>& names() const {
+      return _names;
+    }
+
+    /** Append the rows of the next chunk of the file to columns, returning
+     * the number of rows, which is 0 at the end of the file. */
+    std::size_t read_chunk(std::vector<Qs>&... columns) {
+      const auto before = (columns.size() + ...) / column_count;
+      auto rows = before;
+      while (rows == before && !_at_end) {
+        const auto keep = _buffer.size();
+        _buffer.resize(keep + _options.chunk_size);
+        _in.read(_buffer.data() + keep,
+                 static_cast<std::streamsize>(_options.chunk_size));
+        _buffer.resize(keep + static_cast<std::size_t>(_in.gcount()));
+        _at_end = !_in;
+        // only complete lines, unless it's the last chunk
+        const auto end = _at_end ? _buffer.size() : _buffer.rfind('\n') + 1;
+        parse(std::string_view{_buffer}.substr(0, end), columns...);
+        _buffer.erase(0, end);
+        rows = (columns.size() + ...) / column_count;
+      }
+      return rows - before;
+    }
+
+    /// Append all the remaining rows, returning the number read
+    std::size_t read_all(std::vector<Qs>&... columns) {
+      auto total = std::size_t{};
+      for (auto n = read_chunk(columns...); n != 0;
+           n = read_chunk(columns...)) {
+        total += n;
+      }
+      return total;
+    }
+
+  private:
+    std::istream& _in;
+    CsvOptions _options;
+    std::array<std::string, column_count> _names;
+    std::tuple<typename Qs::BaseType...> _factors;
+    std::string _buffer;
+    std::size_t _line = 0;
+    bool _at_end = false;
+
+    template <std::size_t... I>
+    void read_header(
+        const std::array<std::string_view, column_count>& fields,
+        std::index_sequence<I...>) {
+      (read_header_field<I, Qs>(fields[I]), ...);
+    }
+
+    template <std::size_t I, class Q>
+    void read_header_field(std::string_view field) {
+      using Units = typename Impl::quantity_traits<Q>::Units;
+      const auto [name, unit] = Impl::split_header(field);
+      _names[I] = name;
+      std::get<I>(_factors) =
+          Impl::header_factor<Units, typename Q::BaseType>(name, unit);
+    }
+
+    /// Parse text, complete lines, on the configured number of threads
+    void parse(std::string_view text, std::vector<Qs>&... columns) {
+      const auto threads = std::max(1u, _options.threads);
+      if (threads == 1 || text.size() < 2 * threads) {
+        std::size_t lines = 0;
+        report(parse_lines(text, lines, columns...));
+        _line += lines;
+        return;
+      }
+      // split at line ends into pieces of about the same size
+      auto pieces = std::vector<std::string_view>{};
+      for (auto rest = text; !rest.empty();) {
+        auto end = std::min(rest.size(), text.size() / threads);
+        end = rest.find('\n', end == 0 ? 0 : end - 1);
+        end = end == std::string_view::npos ? rest.size() : end + 1;
+        pieces.push_back(rest.substr(0, end));
+        rest.remove_prefix(end);
+      }
+      using Columns = std::tuple<std::vector<Qs>...>;
+      auto results = std::vector<Columns>(pieces.size());
+      auto errors = std::vector<Impl::CsvError>(pieces.size());
+      auto lines = std::vector<std::size_t>(pieces.size());
+      {
+        auto workers = std::vector<std::jthread>{};
+        for (auto i = std::size_t{1}; i < pieces.size(); ++i) {
+          workers.emplace_back([&, i] {
+            errors[i] = std::apply(
+                [&](auto&... cs) {
+                  return parse_lines(pieces[i], lines[i], cs...);
+                },
+                results[i]);
+          });
+        }
+        errors[0] = parse_lines(pieces[0], lines[0], columns...);
+      }
+      report(errors[0]);
+      _line += lines[0];
+      for (auto i = std::size_t{1}; i < pieces.size(); ++i) {
+        report(errors[i]);
+        _line += lines[i];
+        std::apply(
+            [&](auto&... cs) {
+              (columns.insert(columns.end(), cs.begin(), cs.end()), ...);
+            },
+            results[i]);
+      }
+    }
+
+    void report(const Impl::CsvError& e) const {
+      if (e.failed) {
+        throw std::invalid_argument(
+            "csv value on line " + std::to_string(_line + e.line + 1) +
+            ", column " + std::to_string(e.column + 1) + " is invalid");
+      }
+    }
+
+    /** Append the values on the lines of text to columns, counting the
+     * lines. Stops at the first error, as the columns are then unequal. */
+    Impl::CsvError parse_lines(std::string_view text, std::size_t& lines,
+                               std::vector<Qs>&... columns) const {
+      const auto* p = text.data();
+      const auto* const end = p + text.size();
+      for (lines = 0; p != end; ++lines) {
+        if (*p == '\n' || *p == '\r') {
+          // skip empty lines
+          p += *p == '\r' && p + 1 != end && p[1] == '\n' ? 2 : 1;
+          continue;
+        }
+        auto column = std::size_t{};
+        const auto ok = parse_row(p, end, column, columns...,
+                                  std::index_sequence_for<Qs...>{});
+        if (!ok) {
+          return {lines, column, true};
+        }
+      }
+      return {};
+    }
+
+    template <std::size_t... I>
+    bool parse_row(const char*& p, const char* end, std::size_t& column,
+                   std::vector<Qs>&... columns,
+                   std::index_sequence<I...>) const {
+      return (parse_field<I>(p, end, column, columns) && ...);
+    }
+
+    template <std::size_t I, class Q>
+    bool parse_field(const char*& p, const char* end, std::size_t& column,
+                     std::vector<Q>& out) const {
+      column = I;
+      while (p != end && *p == ' ') {
+        ++p;
+      }
+      auto v = typename Q::BaseType{};
+      const auto [next, ec] = std::from_chars(p, end, v);
+      if (ec != std::errc{}) {
+        return false;
+      }
+      p = next;
+      while (p != end && *p == ' ') {
+        ++p;
+      }
+      if constexpr (I + 1 < column_count) {
+        if (p == end || *p != _options.delimiter) {
+          return false;
+        }
+      } else {
+        p += p != end && *p == '\r' ? 1 : 0;
+        if (p != end && *p != '\n') {
+          return false;
+        }
+      }
+      p += p != end ? 1 : 0;
+      const auto factor = std::get<I>(_factors);
+      out.push_back(Q{factor == 1 ? v : v * factor});
+      return true;
+    }
+  };
+
+  /** Writes columns of Qs as CSV, the header has the name and unit of each
+   * column, e.g. "length [km]". Values are written with std::to_chars, the
+   * shortest representation that reads back exactly.
+   *
+   *   auto writer = units::CsvWriter<km, seconds>{file, {"length", "time"}};
+   *   writer.write(lengths, times);  // std::spans, can be called repeatedly
+   */
+  template <class... Qs>
+  class CsvWriter {
+  public:
+    static constexpr auto column_count = sizeof...(Qs);
+
+    CsvWriter(std::ostream& out,
+              const std::array<std::string_view, column_count>& names,
+              CsvOptions options = {})
+        : _out{out}, _options{options} {
+      static_assert(column_count > 0);
+      static_assert((is_quantity(Qs{}) && ...), "columns must be Quantities");
+      const std::string units[] = {format_unit(
+          Impl::quantity_traits<Qs>::Units::code)...};
+      for (auto i = std::size_t{}; i < column_count; ++i) {
+        if (i != 0) {
+          _out << _options.delimiter;
+        }
+        _out << names[i] << " [" << units[i] << "]";
+      }
+      _out << '\n';
+    }
+
+    /// Write a row for each element of the columns, which must all be the
+    /// same size.
+    void write(std::span<const Qs>... columns) {
+      const std::size_t sizes[] = {columns.size()...};
+      if (std::adjacent_find(std::begin(sizes), std::end(sizes),
+                             std::not_equal_to<>{}) != std::end(sizes)) {
+        throw std::invalid_argument("csv columns have different sizes");
+      }
+      constexpr auto max_row = max_field * column_count;
+      auto buffer = std::string(std::max(_options.chunk_size, 2 * max_row),
+                                '\0');
+      auto* p = buffer.data();
+      auto* const flush_at = buffer.data() + buffer.size() - max_row;
+      for (auto row = std::size_t{}; row < sizes[0]; ++row) {
+        write_row(p, row, columns..., std::index_sequence_for<Qs...>{});
+        if (p >= flush_at) {
+          _out.write(buffer.data(), p - buffer.data());
+          p = buffer.data();
+        }
+      }
+      _out.write(buffer.data(), p - buffer.data());
+    }
+
+    /// As above for containers of Quantities, e.g. std::vector
+    template <class... Cs>
+    auto write(const Cs&... columns)
+        -> decltype(write(std::span<const Qs>{columns}...)) {
+      write(std::span<const Qs>{columns}...);
+    }
+
+  private:
+    // the longest double from to_chars is 24 characters
+    static constexpr std::size_t max_field = 32;
+
+    std::ostream& _out;
+    CsvOptions _options;
+
+    template <std::size_t... I>
+    void write_row(char*& p, std::size_t row,
+                   std::span<const Qs>... columns,
+                   std::index_sequence<I...>) const {
+      (write_field<I>(p, columns[row].underlying_value()), ...);
+    }
+
+    template <std::size_t I, class T>
+    void write_field(char*& p, const T& v) const {
+      static_assert(sizeof(T) <= sizeof(double), "no room for long double");
+      p = std::to_chars(p, p + max_field, v).ptr;
+      *p++ = I + 1 < column_count ? _options.delimiter : '\n';
+    }
+  };
+} // namespace units
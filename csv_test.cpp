@@ -0,0 +1,122 @@
+#include "common_quantities.hpp"
+#include "csv.hpp"
+#include <catch.hpp>
+
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+SCENARIO("Reading and writing Quantity columns as CSV") {
+  using namespace units;
+  GIVEN("a CSV file with units in the header") {
+    auto file = std::istringstream{"length [km], time [s],pressure [MPa]\n"
+                                   "1.5,2,0.1\n"
+                                   "\n"
+                                   "  -3e2 , 4.25,7\r\n"
+                                   "0,0,0"};
+    auto lengths = std::vector<km>{};
+    auto times = std::vector<seconds>{};
+    auto pressures = std::vector<Pascals>{};
+    THEN("the columns are read into the Quantities") {
+      auto reader = CsvReader<km, seconds, Pascals>{file};
+      REQUIRE(reader.names()[0] == "length");
+      REQUIRE(reader.names()[2] == "pressure");
+      REQUIRE(reader.read_all(lengths, times, pressures) == 3);
+      REQUIRE(lengths == std::vector<km>{km{1.5}, km{-300}, km{0}});
+      REQUIRE(times == std::vector<seconds>{seconds{2}, seconds{4.25},
+                                            seconds{0}});
+      THEN("prefixes are scaled to the type") {
+        REQUIRE(pressures[0] == Pascals{100'000});
+        REQUIRE(pressures[1] == Pascals{7'000'000});
+      }
+    }
+    THEN("small chunks and many threads give the same result") {
+      auto reader = CsvReader<km, seconds, Pascals>{
+          file, {.threads = 3, .chunk_size = 4}};
+      REQUIRE(reader.read_all(lengths, times, pressures) == 3);
+      REQUIRE(lengths == std::vector<km>{km{1.5}, km{-300}, km{0}});
+      REQUIRE(pressures[1] == Pascals{7'000'000});
+    }
+    THEN("columns with the wrong dimensions throw") {
+      REQUIRE_THROWS_AS((CsvReader<km, km, Pascals>{file}),
+                        std::invalid_argument);
+    }
+    THEN("the wrong number of columns throws") {
+      REQUIRE_THROWS_AS((CsvReader<km, seconds>{file}), std::invalid_argument);
+    }
+  }
+
+  GIVEN("malformed values") {
+    auto file = std::istringstream{"a [m]\tb\n1\t2\n3\tx\n"};
+    THEN("the line and column are reported") {
+      auto reader = CsvReader<metres, dimensionless>{file, {.delimiter = '\t'}};
+      auto a = std::vector<metres>{};
+      auto b = std::vector<dimensionless>{};
+      REQUIRE_THROWS_WITH(reader.read_all(a, b),
+                          "csv value on line 3, column 2 is invalid");
+    }
+  }
+
+  GIVEN("columns of Quantities") {
+    auto lengths = std::vector<mm>{};
+    auto speeds = std::vector<metres_per_sec>{};
+    for (auto i = 0; i < 1000; ++i) {
+      lengths.push_back(mm{i / 7.0});
+      speeds.push_back(metres_per_sec{1e300 / (i + 1)});
+    }
+    THEN("the writer puts the units in the header only") {
+      auto out = std::ostringstream{};
+      auto writer = CsvWriter<mm, metres_per_sec>{out, {"x", "v"}};
+      writer.write(std::vector<mm>{mm{1.5}}, std::vector{metres_per_sec{-2}});
+      REQUIRE(out.str() == "x [mm],v [m s^-1]\n1.5,-2\n");
+    }
+    THEN("what is written reads back exactly") {
+      auto out = std::stringstream{};
+      auto writer = CsvWriter<mm, metres_per_sec>{out, {"x", "v"},
+                                                   {.chunk_size = 100}};
+      writer.write(lengths, speeds);
+      writer.write(lengths, speeds);
+      auto reader = CsvReader<mm, metres_per_sec>{out, {.threads = 4}};
+      auto l = std::vector<mm>{};
+      auto s = std::vector<metres_per_sec>{};
+      REQUIRE(reader.read_all(l, s) == 2000);
+      REQUIRE(std::equal(lengths.begin(), lengths.end(), l.begin()));
+      REQUIRE(std::equal(speeds.begin(), speeds.end(), s.begin() + 1000));
+    }
+    THEN("columns of different sizes throw") {
+      auto out = std::ostringstream{};
+      auto writer = CsvWriter<mm, metres_per_sec>{out, {"x", "v"}};
+      speeds.pop_back();
+      REQUIRE_THROWS_AS(writer.write(lengths, speeds), std::invalid_argument);
+    }
+  }
+}
+
+SCENARIO("Profiling CsvReader", "[Profile]") {
+  GIVEN("a large CSV file") {
+    auto out = std::stringstream{};
+    {
+      auto lengths = std::vector<km>{};
+      auto times = std::vector<seconds>{};
+      for (auto i = 0; i < 1'000'000; ++i) {
+        lengths.push_back(km{i * 0.001});
+        times.push_back(seconds{i / 3.0});
+      }
+      units::CsvWriter<km, seconds>{out, {"length", "time"}}.write(lengths,
+                                                                   times);
+    }
+    const auto text = out.str();
+    for (auto threads : {1u, 4u}) {
+      auto lengths = std::vector<km>{};
+      auto times = std::vector<seconds>{};
+      BENCHMARK("read " + std::to_string(threads) + " threads") {
+        auto in = std::istringstream{text};
+        units::CsvReader<km, seconds>{in, {.threads = threads}}.read_all(
+            lengths, times);
+      }
+      std::cout << text.size() << " bytes, " << lengths.size() << " rows\n";
+    }
+  }
+}
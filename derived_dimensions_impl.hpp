@@ -1,40 +1,148 @@
 #pragma once
 
 #include "base_dimensions.hpp"
-#include <boost/hana.hpp>
 #include <cassert>
-#include <exception>
+#include <cstdint>
+#include <numeric>
+#include <ratio>
 #include <type_traits>
 
 namespace units {
-  /** Compile time class which holds a std::ratio for each */
-  template <class Length, class Mass, class Time, class Current,
-            class Temperature, class Amount, class Luminosity, class Prefix>
-  struct Dimensions {
-    using length = Length;
-    using mass = Mass;
-    using time = Time;
-    using current = Current;
-    using temperature = Temperature;
-    using amount = Amount;
-    using luminosity = Luminosity;
-    using prefix = Prefix;
+  /** A compile time rational number that, unlike std::ratio, is a value
+   * rather than a type, so arithmetic on it is ordinary constexpr code
+   * rather than template instantiations. Always normalised (den > 0, num and
+   * den coprime) so equal values compare equal member by member, which is
+   * required for them to give the same type as template arguments. */
+  struct Rational {
+    std::intmax_t num = 0;
+    std::intmax_t den = 1;
+
+    constexpr Rational() = default;
+    constexpr Rational(std::intmax_t n, std::intmax_t d = 1) : num{n}, den{d} {
+      assert(d != 0);
+      if (d == 1) {
+        // already normalised, and skipping the gcd matters for the runtime
+        // unit parser
+        return;
+      }
+      const auto g = std::gcd(num, den);
+      num /= g;
+      den /= g;
+      if (den < 0) {
+        num = -num;
+        den = -den;
+      }
+    }
+
+    /// As a prefix, e.g. the scale parsed from a unit string.
+    constexpr operator PrefixValue() const { return {num, den}; }
+
+    friend constexpr bool operator==(const Rational&,
+                                     const Rational&) = default;
   };
 
-  template <class Le0, class M0, class Ti0, class C0, class Te0, class A0,
-            class Lu0, class Le1, class M1, class Ti1, class C1, class Te1,
-            class A1, class Lu1, class Pr0, class Pr1>
-  constexpr auto
-  same_dimension(Dimensions<Le0, M0, Ti0, C0, Te0, A0, Lu0, Pr0>,
-                 Dimensions<Le1, M1, Ti1, C1, Te1, A1, Lu1, Pr1>) {
-    if constexpr (std::ratio_equal_v<Le0, Le1> && std::ratio_equal_v<M0, M1> &&
-                  std::ratio_equal_v<Ti0, Ti1> && std::ratio_equal_v<C0, C1> &&
-                  std::ratio_equal_v<Te0, Te1> && std::ratio_equal_v<A0, A1> &&
-                  std::ratio_equal_v<Lu0, Lu1>) {
-      return std::true_type{};
-    } else {
-      return std::false_type{};
+  constexpr Rational operator+(const Rational& a, const Rational& b) {
+    const auto den = std::lcm(a.den, b.den);
+    return {a.num * (den / a.den) + b.num * (den / b.den), den};
+  }
+
+  constexpr Rational operator-(const Rational& a) { return {-a.num, a.den}; }
+
+  constexpr Rational operator-(const Rational& a, const Rational& b) {
+    return a + -b;
+  }
+
+  // Cross cancel first, as std::ratio_multiply does, to avoid overflow
+  constexpr Rational operator*(const Rational& a, const Rational& b) {
+    const auto g0 = std::gcd(a.num, b.den);
+    const auto g1 = std::gcd(b.num, a.den);
+    return {(a.num / g0) * (b.num / g1), (a.den / g1) * (b.den / g0)};
+  }
+
+  constexpr Rational operator/(const Rational& a, const Rational& b) {
+    assert(b.num != 0);
+    return a * Rational{b.den, b.num};
+  }
+
+  /** The exponents of the seven SI base dimensions and the prefix (scale) of
+   * a unit, packed in a single structural class so it can be used as a
+   * non-type template parameter of Dimensions. */
+  struct DimensionCode {
+    Rational length{};
+    Rational mass{};
+    Rational time{};
+    Rational current{};
+    Rational temperature{};
+    Rational amount{};
+    Rational luminosity{};
+    PrefixValue prefix{1};
+
+    friend constexpr bool operator==(const DimensionCode&,
+                                     const DimensionCode&) = default;
+
+    /// Equal exponents, ignoring the prefix.
+    constexpr bool same_dimension(const DimensionCode& o) const {
+      return length == o.length && mass == o.mass && time == o.time &&
+             current == o.current && temperature == o.temperature &&
+             amount == o.amount && luminosity == o.luminosity;
     }
+
+    constexpr bool is_dimensionless() const {
+      return same_dimension(DimensionCode{});
+    }
+
+    constexpr DimensionCode with_prefix(const PrefixValue& p) const {
+      auto code = *this;
+      code.prefix = p;
+      return code;
+    }
+
+    /// Multiply each exponent by power, leaving the prefix unchanged.
+    constexpr DimensionCode scale_exponents(const Rational& power) const {
+      return {length * power,      mass * power,        time * power,
+              current * power,     temperature * power, amount * power,
+              luminosity * power,  prefix};
+    }
+  };
+
+  constexpr DimensionCode operator*(const DimensionCode& a,
+                                    const DimensionCode& b) {
+    return {a.length + b.length,           a.mass + b.mass,
+            a.time + b.time,               a.current + b.current,
+            a.temperature + b.temperature, a.amount + b.amount,
+            a.luminosity + b.luminosity,   a.prefix * b.prefix};
+  }
+
+  constexpr DimensionCode operator/(const DimensionCode& a,
+                                    const DimensionCode& b) {
+    return {a.length - b.length,           a.mass - b.mass,
+            a.time - b.time,               a.current - b.current,
+            a.temperature - b.temperature, a.amount - b.amount,
+            a.luminosity - b.luminosity,   a.prefix / b.prefix};
+  }
+
+  /** Compile time class which holds the dimensions and prefix in its Code.
+   * The std::ratio aliases are kept for code that reads the exponents as
+   * types, e.g. Dimensions::length::num. The prefix alias is a std::ratio if
+   * the prefix fits in one and an ExtendedPrefix otherwise. */
+  template <DimensionCode Code>
+  struct Dimensions {
+    static constexpr DimensionCode code = Code;
+
+    using length = std::ratio<Code.length.num, Code.length.den>;
+    using mass = std::ratio<Code.mass.num, Code.mass.den>;
+    using time = std::ratio<Code.time.num, Code.time.den>;
+    using current = std::ratio<Code.current.num, Code.current.den>;
+    using temperature =
+        std::ratio<Code.temperature.num, Code.temperature.den>;
+    using amount = std::ratio<Code.amount.num, Code.amount.den>;
+    using luminosity = std::ratio<Code.luminosity.num, Code.luminosity.den>;
+    using prefix = Impl::prefix_type_t<Code.prefix>;
+  };
+
+  template <DimensionCode Code0, DimensionCode Code1>
+  constexpr auto same_dimension(Dimensions<Code0>, Dimensions<Code1>) {
+    return std::bool_constant<Code0.same_dimension(Code1)>{};
   }
 
   template <class Arg>
@@ -42,24 +150,14 @@ namespace units {
     return std::false_type{};
   }
 
-  template <class Arg0, class Arg1, class Arg2, class Arg3, class Arg4,
-            class Arg5, class Arg6, class Arg7>
-  constexpr std::true_type
-  is_dimensions(Dimensions<Arg0, Arg1, Arg2, Arg3, Arg4, Arg5, Arg6, Arg7>) {
+  template <DimensionCode Code>
+  constexpr std::true_type is_dimensions(Dimensions<Code>) {
     return std::true_type{};
   }
 
-  template <class Arg0, class Arg1, class Arg2, class Arg3, class Arg4,
-            class Arg5, class Arg6, class Prefix>
-  constexpr auto is_dimensionless(
-      Dimensions<Arg0, Arg1, Arg2, Arg3, Arg4, Arg5, Arg6, Prefix>) {
-    if constexpr (Arg0::num == 0 && Arg1::num == 0 && Arg2::num == 0 &&
-                  Arg3::num == 0 && Arg4::num == 0 && Arg5::num == 0 &&
-                  Arg6::num == 0) {
-      return std::true_type{};
-    } else {
-      return std::false_type{};
-    }
+  template <DimensionCode Code>
+  constexpr auto is_dimensionless(Dimensions<Code>) {
+    return std::bool_constant<Code.is_dimensionless()>{};
   }
 
   // Fwd declartion
@@ -77,240 +175,132 @@ namespace units {
   }
 
   namespace Impl {
-    template <template <class, class> class BinOpDim,
-              template <class, class> class BinOpPre, class Le0, class M0,
-              class Ti0, class C0, class Te0, class A0, class Lu0, class Le1,
-              class M1, class Ti1, class C1, class Te1, class A1, class Lu1,
-              class Pr0, class Pr1>
-    constexpr auto
-    dimensions_operator(Dimensions<Le0, M0, Ti0, C0, Te0, A0, Lu0, Pr0>,
-                        Dimensions<Le1, M1, Ti1, C1, Te1, A1, Lu1, Pr1>) {
-      return Dimensions<BinOpDim<Le0, Le1>, BinOpDim<M0, M1>,
-                        BinOpDim<Ti0, Ti1>, BinOpDim<C0, C1>,
-                        BinOpDim<Te0, Te1>, BinOpDim<A0, A1>,
-                        BinOpDim<Lu0, Lu1>, BinOpPre<Pr0, Pr1>>{};
+    template <class Ratio>
+    constexpr Rational to_rational() {
+      return {Ratio::num, Ratio::den};
     }
 
-    struct DimensionCounter {
-      struct runtime_ratio {
-        intmax_t n = 0;
-        intmax_t d = 1;
-        constexpr runtime_ratio() = default;
-        constexpr runtime_ratio(intmax_t a, intmax_t b) : n{a}, d{b} {}
-        constexpr runtime_ratio& operator+=(const runtime_ratio& other) {
-          n = n * other.d + other.n * d;
-          d *= other.d;
-          return *this;
-        }
-        template <intmax_t N, intmax_t D>
-        constexpr runtime_ratio& operator+=(std::ratio<N, D>) {
-          n = n * D + N * d;
-          d *= D;
-          return *this;
-        }
-
-        constexpr runtime_ratio& operator*=(const runtime_ratio& other) {
-          n *= other.n;
-          d *= other.d;
-          return *this;
-        }
-        template <intmax_t N, intmax_t D>
-        constexpr runtime_ratio& operator*=(std::ratio<N, D>) {
-          n *= N;
-          d *= D;
-          return *this;
-        }
-      };
-
-      runtime_ratio length{}, mass{}, time{}, current{}, temperature{},
-          amount{}, luminosity{}, prefix{1, 1};
-      constexpr DimensionCounter& operator+=(const DimensionCounter& other) {
-        length += other.length;
-        mass += other.mass;
-        time += other.time;
-        current += other.current;
-        temperature += other.temperature;
-        amount += other.amount;
-        luminosity += other.luminosity;
-        prefix *= other.prefix;
-        return *this;
-      }
-      constexpr DimensionCounter() = default;
-
-      template <class Le, class M, class Ti, class C, class Te, class A,
-                class Lu, class Pr>
-      constexpr DimensionCounter(const Dimensions<Le, M, Ti, C, Te, A, Lu, Pr>&)
-          : length{Le::num, Le::den},
-            mass{M::num, M::den},
-            time{Ti::num, Ti::den},
-            current{C::num, C::den},
-            temperature{Te::num, Te::den},
-            amount{A::num, A::den},
-            luminosity{Lu::num, Lu::den},
-            prefix{Pr::num, Pr::den} {}
-
-      template <intmax_t N, intmax_t D>
-      constexpr auto add_prefix(std::ratio<N, D> r) {
-        prefix *= r;
-      }
-    };
-
+    /** The DimensionCode of a single argument to derived_t: a base dimension,
+     * another Dimensions (or derived), or a std::ratio or ExtendedPrefix
+     * prefix. */
     template <class Arg>
-    constexpr DimensionCounter parse_base_unit(Arg arg) {
-      auto count = DimensionCounter{};
+    constexpr DimensionCode parse_arg(Arg arg) {
+      auto code = DimensionCode{};
       if constexpr (is_length(arg)) {
-        count.length += Arg::exp;
+        code.length = to_rational<decltype(Arg::exp)>();
       } else if constexpr (is_time(arg)) {
-        count.time += Arg::exp;
+        code.time = to_rational<decltype(Arg::exp)>();
       } else if constexpr (is_mass(arg)) {
-        count.mass += Arg::exp;
+        code.mass = to_rational<decltype(Arg::exp)>();
       } else if constexpr (is_temperature(arg)) {
-        count.temperature += Arg::exp;
+        code.temperature = to_rational<decltype(Arg::exp)>();
       } else if constexpr (is_amount(arg)) {
-        count.amount += Arg::exp;
+        code.amount = to_rational<decltype(Arg::exp)>();
       } else if constexpr (is_luminosity(arg)) {
-        count.luminosity += Arg::exp;
+        code.luminosity = to_rational<decltype(Arg::exp)>();
       } else if constexpr (is_current(arg)) {
-        count.current += Arg::exp;
-      } else {
-        assert(false);
-      }
-      return count;
-    } // namespace Impl
-
-    template <class Arg>
-    constexpr DimensionCounter parse_arg(Arg arg) {
-      auto count = DimensionCounter{};
-      if constexpr (units::is_base_dimension(arg)) {
-        count += parse_base_unit(arg);
-      } else if constexpr (units::is_dimensions(arg)) {
-        constexpr auto rt = DimensionCounter(arg);
-        count += rt;
-        // throw std::logic_error("Oops");
-        // std::cout << "Oops\n";
-        // assert(false);
-      } else if constexpr (is_ratio(arg)) {
-        count.add_prefix(arg);
+        code.current = to_rational<decltype(Arg::exp)>();
+      } else if constexpr (is_dimensions(arg)) {
+        code = Arg::code;
+      } else if constexpr (is_derived(arg)) {
+        code = Arg::type::code;
+      } else if constexpr (is_ratio(arg) || is_extended_prefix(arg)) {
+        code.prefix = to_prefix_value<Arg>();
       }
-      return count;
+      return code;
     }
 
-    /** At compile time create a dimension counter and add all of the Args to
-     * it. */
+    /** At compile time multiply the DimensionCodes of all of the Args, which
+     * adds their exponents and multiplies their prefixes. */
     template <class... Args>
-    constexpr auto parse_units() {
-      auto count = DimensionCounter{};
-      constexpr auto args = boost::hana::tuple<Args...>{};
-      boost::hana::for_each(
-          args, [&count](auto arg) { count += Impl::parse_arg(arg); });
-      return count;
+    constexpr DimensionCode parse_units() {
+      return (DimensionCode{} * ... * parse_arg(Args{}));
     }
 
+    template <class Arg>
+    constexpr bool is_units_arg(Arg arg) {
+      return is_base_dimension(arg) || is_derived(arg) || is_dimensions(arg) ||
+             is_ratio(arg) || is_extended_prefix(arg);
+    }
   } // namespace Impl
 
-  template <class... Args0, class... Args1>
-  constexpr auto operator*(Dimensions<Args0...> a, Dimensions<Args1...> b) {
-    return Impl::dimensions_operator<std::ratio_add, std::ratio_multiply>(a, b);
+  template <DimensionCode Code0, DimensionCode Code1>
+  constexpr auto operator*(Dimensions<Code0>, Dimensions<Code1>) {
+    return Dimensions<Code0 * Code1>{};
+  }
+
+  template <DimensionCode Code0, DimensionCode Code1>
+  constexpr auto operator/(Dimensions<Code0>, Dimensions<Code1>) {
+    return Dimensions<Code0 / Code1>{};
   }
 
-  template <class... Args0, class... Args1>
-  constexpr auto operator/(Dimensions<Args0...> a, Dimensions<Args1...> b) {
-    return Impl::dimensions_operator<std::ratio_subtract, std::ratio_divide>(a,
-                                                                             b);
+  template <DimensionCode Code>
+  constexpr auto sqrt([[maybe_unused]] const units::Dimensions<Code>& a) {
+    return Dimensions<Code.scale_exponents(Rational{1, 2})>{};
   }
 
-  template <class Le, class M, class Ti, class C, class Te, class A, class Lu,
-            class Pr>
-  constexpr auto sqrt([
-      [maybe_unused]] const units::Dimensions<Le, M, Ti, C, Te, A, Lu, Pr>& a) {
-    using two = std::ratio<2, 1>;
-    // static_assert(std::is_same_v<units::unity, Pr>);
-    using l = std::ratio_divide<Le, two>;
-    using m = std::ratio_divide<M, two>;
-    using t = std::ratio_divide<Ti, two>;
-    using c = std::ratio_divide<C, two>;
-    using te = std::ratio_divide<Te, two>;
-    using am = std::ratio_divide<A, two>;
-    using lu = std::ratio_divide<Lu, two>;
-    return units::Dimensions<l, m, t, c, te, am, lu, Pr>{};
+  /** Raised to the power N/D, each exponent multiplied by it. The prefix is
+   * raised to integer powers, rational powers need a prefix of unity as the
+   * result would be irrational. */
+  template <int N, int D = 1, DimensionCode Code>
+  constexpr auto pow([[maybe_unused]] const units::Dimensions<Code>& a) {
+    static_assert(D > 0);
+    static_assert(D == 1 || Code.prefix == PrefixValue{1},
+                  "only integer powers of a prefix are exact");
+    constexpr auto prefix = [] {
+      auto p = PrefixValue{1};
+      for (auto i = 0; i < (N < 0 ? -N : N); ++i) {
+        p = p * Code.prefix;
+      }
+      return N < 0 ? PrefixValue{1} / p : p;
+    }();
+    return Dimensions<Code.scale_exponents(Rational{N, D}).with_prefix(
+        D == 1 ? prefix : PrefixValue{1})>{};
+  }
+
+  /// The N-th root, each exponent divided by N
+  template <int N, DimensionCode Code>
+  constexpr auto root([[maybe_unused]] const units::Dimensions<Code>& a) {
+    static_assert(N > 0);
+    return Dimensions<Code.scale_exponents(Rational{1, N})>{};
   }
 
-  template <class Le, class M, class Ti, class C, class Te, class A, class Lu,
-            class Pr>
-  constexpr auto invert([
-      [maybe_unused]] const units::Dimensions<Le, M, Ti, C, Te, A, Lu, Pr>& a) {
-    using minus_1 = std::ratio<-1, 1>;
-    // static_assert(std::is_same_v<units::unity, Pr>);
-    using l = std::ratio_multiply<Le, minus_1>;
-    using m = std::ratio_multiply<M, minus_1>;
-    using t = std::ratio_multiply<Ti, minus_1>;
-    using c = std::ratio_multiply<C, minus_1>;
-    using te = std::ratio_multiply<Te, minus_1>;
-    using am = std::ratio_multiply<A, minus_1>;
-    using lu = std::ratio_multiply<Lu, minus_1>;
-    using pr = std::ratio_divide<std::ratio<1, 1>, Pr>;
-    return units::Dimensions<l, m, t, c, te, am, lu, pr>{};
+  template <DimensionCode Code>
+  constexpr auto cbrt(const units::Dimensions<Code>& a) {
+    return root<3>(a);
+  }
+
+  template <DimensionCode Code>
+  constexpr auto invert([[maybe_unused]] const units::Dimensions<Code>& a) {
+    return Dimensions<Code.scale_exponents(Rational{-1}).with_prefix(
+        PrefixValue{1} / Code.prefix)>{};
   }
 
   /** Collect a number of derived or base dimension classes into a single one.
    */
   template <class Arg0, class... Args>
   constexpr auto parse_units() {
-    constexpr auto count = Impl::parse_units<Arg0, Args...>();
-    return Dimensions<
-        // units::Length<count.length.exp.n, count.length.exp.d>,
-        std::ratio<count.length.n, count.length.d>,
-        std::ratio<count.mass.n, count.mass.d>,
-        std::ratio<count.time.n, count.time.d>,
-        std::ratio<count.current.n, count.current.d>,
-        std::ratio<count.temperature.n, count.temperature.d>,
-        std::ratio<count.amount.n, count.amount.d>,
-        std::ratio<count.luminosity.n, count.luminosity.d>,
-        std::ratio<count.prefix.n, count.prefix.d>>{};
+    return Dimensions<Impl::parse_units<Arg0, Args...>()>{};
   }
-  /*constexpr auto parse_units() {
-    return Dimensions{};
-  }*/
 
   template <class Arg0, class... Args>
   constexpr auto parse_units_unity_prefix() {
-    constexpr auto count = Impl::parse_units<Arg0, Args...>();
-    return Dimensions<std::ratio<count.length.n, count.length.d>,
-                      std::ratio<count.mass.n, count.mass.d>,
-                      std::ratio<count.time.n, count.time.d>,
-                      std::ratio<count.current.n, count.current.d>,
-                      std::ratio<count.temperature.n, count.temperature.d>,
-                      std::ratio<count.amount.n, count.amount.d>,
-                      std::ratio<count.luminosity.n, count.luminosity.d>,
-                      std::ratio<1, 1>>{};
+    constexpr auto code = Impl::parse_units<Arg0, Args...>();
+    return Dimensions<code.with_prefix(PrefixValue{1})>{};
   }
 
   /** Convert base dimensions or derived types into a single Dimension class in
    * its "type" alias.*/
   template <class... Args>
   struct derived {
+    static_assert((Impl::is_units_arg(Args{}) && ...));
     using type = decltype(parse_units<Args...>());
-    constexpr static auto Units = boost::hana::tuple<Args...>{};
-    static_assert(boost::hana::all_of(Units, [](auto arg) {
-      return is_base_dimension(arg) || is_derived(arg) || is_dimensions(arg) ||
-             is_ratio(arg);
-    }));
-    /*template<class Other>
-    static constexpr auto per(Other other = Other{}) {
-      using Inverted = invert(std::move(other));
-
-
-    }*/
   };
 
   template <class... Args>
   struct derived_unity {
+    static_assert((Impl::is_units_arg(Args{}) && ...));
     using type = decltype(parse_units_unity_prefix<Args...>());
-    constexpr static auto Units = boost::hana::tuple<Args...>{};
-    static_assert(boost::hana::all_of(Units, [](auto arg) {
-      return is_base_dimension(arg) || is_derived(arg) || is_dimensions(arg) ||
-             is_ratio(arg);
-    }));
   };
 
   template <class... Args>
@@ -319,8 +309,18 @@ namespace units {
   template <class... Args>
   using derived_unity_t = typename derived_unity<Args...>::type;
 
+  namespace Impl {
+    template <DimensionCode Code, class Prefix>
+    struct with_prefix<Dimensions<Code>, Prefix> {
+      using type = Dimensions<Code.with_prefix(to_prefix_value<Prefix>())>;
+    };
+  } // namespace Impl
+
   static_assert(!is_derived(Length<1>{}));
   static_assert(is_derived(derived<Length<1>>{}));
   static_assert(is_derived(derived<Length<1>, Mass<1>>{}));
-
-} // namespace units
\ No newline at end of file
+  static_assert(std::is_same_v<derived_t<Length<2, 4>>,
+                               derived_t<Length<1, 2>>>);
+  static_assert(std::is_same_v<derived_t<Length<1>, Time<-1>, Length<-1>>,
+                               derived_t<Time<-1>>>);
+} // namespace units
@@ -169,17 +169,24 @@ namespace units {
 /** Print the Dimension class, e.g. something like "km" or "ms", including
  *  superscripts for to the power of.
  */
-template <class L, class M, class T, class C, class Te, class A, class Lu,
-          class Pr>
-std::ostream& operator<<(std::ostream& os,
-                         const units::Dimensions<L, M, T, C, Te, A, Lu, Pr>&) {
+template <units::DimensionCode Code>
+std::ostream& operator<<(std::ostream& os, const units::Dimensions<Code>&) {
   using namespace units;
-  using type = units::Dimensions<L, M, T, C, Te, A, Lu, Pr>;
+  using type = units::Dimensions<Code>;
   using prefix = typename type::prefix;
+  using L = typename type::length;
+  using M = typename type::mass;
+  using T = typename type::time;
+  using C = typename type::current;
+  using Te = typename type::temperature;
+  using A = typename type::amount;
+  using Lu = typename type::luminosity;
 
   // Print k, M, G etc for kilo, mega, giga ...
   bool prefixed = true;
-  if constexpr (std::ratio_not_equal_v<prefix, units::unity>) {
+  if constexpr (is_extended_prefix(prefix{})) {
+    prefixed = false;
+  } else if constexpr (std::ratio_not_equal_v<prefix, units::unity>) {
     if constexpr (std::ratio_equal_v<prefix, units::kilo>)
       os << "k";
     else if constexpr (std::ratio_equal_v<prefix, units::mega>)
@@ -211,7 +218,16 @@ std::ostream& operator<<(std::ostream& os,
 
   // if no prefix (k, M) etc then maybe we should add "x 10 ^ ?"
   if (!prefixed) {
-    if constexpr (type::prefix::num == type::prefix::den) {
+    if constexpr (is_extended_prefix(prefix{})) {
+      // beyond a std::ratio, e.g. " x 1.6377e+17 x 10¹⁸"
+      constexpr auto p = Code.prefix;
+      if constexpr (p.num != p.den) {
+        os << " x " << static_cast<double>(p.num) / p.den;
+      }
+      os << " x 10" << (p.exponent < 0 ? "\u207B" : "")
+         << units::to_integer_superscript(p.exponent < 0 ? -p.exponent
+                                                         : p.exponent);
+    } else if constexpr (type::prefix::num == type::prefix::den) {
       // nothing, x
     } else if constexpr (type::prefix::num / type::prefix::den != 0) {
       auto pw = std::log10(type::prefix::num / type::prefix::den);
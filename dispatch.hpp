@@ -0,0 +1,149 @@
+#pragma once
+
+#include "derived_dimensions_impl.hpp"
+#include "quantity.hpp"
+#include "quantity_span.hpp"
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <type_traits>
+
+// ************************************************************************* /
+//    Calls a statically typed kernel on a batch of doubles whose units are  /
+//    only known at runtime, e.g. a column of a file parsed with parse_unit. /
+//    The runtime DimensionCode is looked up once per batch in a hash table  /
+//    built at compile time from a list of candidate derived_t types, and    /
+//    the kernel is called with a span of Quantities of the matching type,   /
+//    so the inner loops have no runtime checks.                             /
+// ************************************************************************* /
+
+namespace units {
+  /// A compile time list of derived_t types, the candidates for dispatch.
+  template <class... Units>
+  struct unit_list {};
+
+  namespace Impl {
+    constexpr std::uint64_t mix(std::uint64_t h) {
+      // the finaliser of MurmurHash3
+      h ^= h >> 33;
+      h *= 0xFF51AFD7ED558CCD;
+      h ^= h >> 33;
+      h *= 0xC4CEB9FE1A85EC53;
+      h ^= h >> 33;
+      return h;
+    }
+
+    constexpr std::uint64_t hash(const DimensionCode& code) {
+      const Rational values[] = {code.length,      code.mass,
+                                 code.time,        code.current,
+                                 code.temperature, code.amount,
+                                 code.luminosity};
+      auto h = std::uint64_t{};
+      for (const auto& v : values) {
+        h = mix(h ^ static_cast<std::uint64_t>(v.num)) +
+            static_cast<std::uint64_t>(v.den);
+      }
+      const auto& p = code.prefix;
+      h = mix(h ^ static_cast<std::uint64_t>(p.num)) +
+          static_cast<std::uint64_t>(p.den) +
+          static_cast<std::uint64_t>(p.exponent);
+      return mix(h);
+    }
+
+    /** An open addressing hash table from the codes of Units to their index
+     * in Units. Units with the same code as an earlier one are left out, so
+     * the first one is called. */
+    template <class... Units>
+    struct DispatchTable {
+      static_assert(sizeof...(Units) > 0, "no candidates to dispatch to");
+
+      static constexpr std::size_t npos = sizeof...(Units);
+      static constexpr DimensionCode codes[] = {Units::code...};
+      // at most half full, so the probe sequences are short
+      static constexpr std::size_t size = std::bit_ceil(2 * sizeof...(Units));
+
+      // index + 1 into codes, 0 for an empty slot
+      static constexpr auto slots = [] {
+        auto s = std::array<std::size_t, size>{};
+        for (auto i = std::size_t{}; i < npos; ++i) {
+          auto duplicate = false;
+          for (auto j = std::size_t{}; j < i; ++j) {
+            duplicate = duplicate || codes[j] == codes[i];
+          }
+          if (duplicate) {
+            continue;
+          }
+          auto h = hash(codes[i]) & (size - 1);
+          while (s[h] != 0) {
+            h = (h + 1) & (size - 1);
+          }
+          s[h] = i + 1;
+        }
+        return s;
+      }();
+
+      /// The index of code in Units, or npos
+      static constexpr std::size_t find(const DimensionCode& code) {
+        for (auto h = hash(code) & (size - 1); slots[h] != 0;
+             h = (h + 1) & (size - 1)) {
+          if (codes[slots[h] - 1] == code) {
+            return slots[h] - 1;
+          }
+        }
+        return npos;
+      }
+    };
+
+    template <class Units, class T, std::size_t Extent, class Kernel>
+    void call_kernel(std::span<T, Extent> data, Kernel& kernel) {
+      kernel(units::as_quantities<Units>(data));
+    }
+
+    template <class... Units, class T, std::size_t Extent, class Kernel>
+    bool dispatch(unit_list<Units...>, const DimensionCode& code,
+                  std::span<T, Extent> data, Kernel& kernel) {
+      using Table = DispatchTable<Units...>;
+      using Call = void (*)(std::span<T, Extent>, Kernel&);
+      static constexpr Call calls[] = {
+          &call_kernel<Units, T, Extent, Kernel>...};
+      const auto i = Table::find(code);
+      if (i == Table::npos) {
+        return false;
+      }
+      calls[i](data, kernel);
+      return true;
+    }
+  } // namespace Impl
+
+  /** Call kernel once with data as a std::span of Quantity<Units, T>, where
+   * Units is the first of the Candidates (a unit_list) with the same
+   * dimensions and prefix as code. For example:
+   *
+   *   auto r = units::parse_unit(header);
+   *   using Candidates = units::unit_list<Pascals_t, metres_t>;
+   *   units::dispatch<Candidates>(r.code, std::span{column},
+   *                               [](auto quantities) {
+   *     for (auto& q : quantities) { ... }
+   *   });
+   *
+   * kernel has to compile for each of the Candidates, e.g. a generic lambda.
+   * The lookup is one hash and compare per call rather than per element.
+   * Returns false without calling kernel if none of the Candidates match.
+   */
+  template <class Candidates, class T, std::size_t Extent, class Kernel>
+  [[nodiscard]] bool dispatch(const DimensionCode& code,
+                              std::span<T, Extent> data, Kernel&& kernel) {
+    return Impl::dispatch(Candidates{}, code, data, kernel);
+  }
+
+  /// The index in Candidates of the first type with the same code, or the
+  /// number of Candidates if there isn't one.
+  template <class... Units>
+  constexpr std::size_t find_unit(unit_list<Units...>,
+                                  const DimensionCode& code) {
+    return Impl::DispatchTable<Units...>::find(code);
+  }
+} // namespace units
@@ -0,0 +1,124 @@
+#include "common_quantities.hpp"
+#include "dispatch.hpp"
+#include "unit_parser.hpp"
+#include <catch.hpp>
+
+#include <iostream>
+#include <span>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace {
+  // everything in common_units.hpp, including some with the same code
+  using common_unit_list = units::unit_list<
+      kg_t, metres_t, mm_t, cm_t, km_t, metres2_t, acre_t, hectare_t,
+      metres3_t, litres_t, us_gallon_t, imp_gallon_t, metres05_t, seconds_t,
+      nanoseconds_t, minutes_t, hours_t, days_t, per_second_t, per_min_t,
+      per_hour_t, per_days_t, seconds2_t, metres_per_sec_t,
+      metres_per_sec2_t, Joules_t, Watts_t, kg_metres_per_sec_t,
+      kg_metres_per_sec2_t, Newtons_t, Pascals_t, MPam05_t>;
+} // namespace
+
+SCENARIO("Dispatching runtime units to statically typed kernels") {
+  using namespace units;
+  GIVEN("a column of values and its parsed units") {
+    auto column = std::vector<double>{1, 2, 3};
+    THEN("the kernel is called with Quantities of the matching type") {
+      auto pascals = false;
+      auto called = dispatch<common_unit_list>(
+          parse_unit("N/m^2").code, std::span{column}, [&](auto quantities) {
+            using Q = typename decltype(quantities)::value_type;
+            pascals = std::is_same_v<Q, Pascals>;
+          });
+      REQUIRE(called);
+      REQUIRE(pascals);
+    }
+    THEN("the prefix is part of the match") {
+      auto result = std::string_view{};
+      const auto name = [&](auto quantities) {
+        using Q = typename decltype(quantities)::value_type;
+        result = std::is_same_v<Q, km>          ? "km"
+                 : std::is_same_v<Q, metres>    ? "m"
+                 : std::is_same_v<Q, minutes>   ? "min"
+                 : std::is_same_v<Q, litres>    ? "L"
+                 : std::is_same_v<Q, metres3>   ? "m3"
+                                                : "other";
+      };
+      auto data = std::span{column};
+      REQUIRE(dispatch<common_unit_list>(parse_unit("km").code, data, name));
+      REQUIRE(result == "km");
+      REQUIRE(dispatch<common_unit_list>(parse_unit("m").code, data, name));
+      REQUIRE(result == "m");
+      REQUIRE(dispatch<common_unit_list>(parse_unit("min").code, data, name));
+      REQUIRE(result == "min");
+      REQUIRE(dispatch<common_unit_list>(parse_unit("L").code, data, name));
+      REQUIRE(result == "L");
+      REQUIRE(dispatch<common_unit_list>(parse_unit("m^3").code, data, name));
+      REQUIRE(result == "m3");
+    }
+    THEN("the kernel can modify the values in place") {
+      auto ok = dispatch<common_unit_list>(
+          parse_unit("km").code, std::span{column}, [](auto quantities) {
+            for (auto& q : quantities) {
+              q *= 2;
+            }
+          });
+      REQUIRE(ok);
+      REQUIRE(column == std::vector<double>{2, 4, 6});
+    }
+    THEN("const data gives const Quantities") {
+      const auto& c = column;
+      auto total = 0.0;
+      auto ok = dispatch<common_unit_list>(
+          parse_unit("s").code, std::span{c}, [&](auto quantities) {
+            using Q = typename decltype(quantities)::element_type;
+            static_assert(std::is_const_v<Q>);
+            for (const auto& q : quantities) {
+              total += q.underlying_value();
+            }
+          });
+      REQUIRE(ok);
+      REQUIRE(total == 6);
+    }
+    THEN("units that aren't candidates don't call the kernel") {
+      auto called = false;
+      auto ok = dispatch<common_unit_list>(parse_unit("cd").code,
+                                           std::span{column},
+                                           [&](auto) { called = true; });
+      REQUIRE(!ok);
+      REQUIRE(!called);
+    }
+  }
+
+  GIVEN("candidates with the same code") {
+    THEN("the first one is found") {
+      using list = unit_list<Newtons_t, kg_metres_per_sec2_t, Joules_t>;
+      static_assert(find_unit(list{}, Newtons_t::code) == 0);
+      static_assert(find_unit(list{}, Joules_t::code) == 2);
+      static_assert(find_unit(list{}, metres_t::code) == 3);
+      REQUIRE(find_unit(common_unit_list{}, Newtons_t::code) ==
+              find_unit(common_unit_list{}, kg_metres_per_sec2_t::code));
+    }
+  }
+}
+
+SCENARIO("Profiling dispatch", "[Profile]") {
+  GIVEN("many small batches") {
+    auto column = std::vector<double>(64, 1.0);
+    const auto code = units::parse_unit("Pa").code;
+    auto total = 0.0;
+    BENCHMARK("dispatch 100'000 batches of 64") {
+      for (auto i = 0; i < 100'000; ++i) {
+        auto ok = units::dispatch<common_unit_list>(
+            code, std::span{column}, [&](auto quantities) {
+              for (const auto& q : quantities) {
+                total += q.underlying_value();
+              }
+            });
+        total += ok;
+      }
+    }
+    std::cout << total << "\n";
+  }
+}
@@ -0,0 +1,346 @@
+#pragma once
+
+#include "convert.hpp"
+#include "quantity.hpp"
+#include "quantity_cast.hpp"
+#include "quantity_span.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <ratio>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+
+#if defined(__F16C__)
+#include <immintrin.h>
+#define UNITS_HAS_F16C 1
+#else
+#define UNITS_HAS_F16C 0
+#endif
+
+// ************************************************************************* /
+//    16 bit floating point storage for Quantities, e.g. history buffers of  /
+//    Quantity<Pascals_t, units::float16>. The dimensions and prefix stay in /
+//    the type, the values are widened to float or double to compute with   /
+//    and narrowed back in bulk, with F16C where the target has it.          /
+// ************************************************************************* /
+
+namespace units {
+  namespace Impl {
+    /// The nearest IEEE binary16 to f, ties to even
+    constexpr std::uint16_t float_to_half(float f) noexcept {
+      const auto x = std::bit_cast<std::uint32_t>(f);
+      const auto sign = static_cast<std::uint16_t>((x >> 16) & 0x8000);
+      const auto abs = x & 0x7fff'ffff;
+      if (abs >= 0x7f80'0000) {
+        // infinity, or a NaN kept quiet with the top of its payload
+        const auto nan = abs > 0x7f80'0000 ? 0x200 | ((abs >> 13) & 0x3ff) : 0;
+        return static_cast<std::uint16_t>(sign | 0x7c00 | nan);
+      }
+      if (abs >= 0x477f'f000) {
+        // 65520 and above round to infinity
+        return static_cast<std::uint16_t>(sign | 0x7c00);
+      }
+      if (abs >= 0x3880'0000) {
+        // a normal half, rebias the exponent and round off 13 bits
+        auto h = abs - 0x3800'0000;
+        h += 0xfff + ((h >> 13) & 1);
+        return static_cast<std::uint16_t>(sign | (h >> 13));
+      }
+      // a subnormal half, in units of 2^-24
+      const auto e = static_cast<int>(abs >> 23);
+      if (e < 102) {
+        return sign;
+      }
+      const auto m = (abs & 0x7f'ffff) | 0x80'0000;
+      const auto shift = 126 - e;
+      const auto rem = m & ((1u << shift) - 1);
+      const auto halfway = 1u << (shift - 1);
+      auto h = m >> shift;
+      h += rem > halfway || (rem == halfway && (h & 1));
+      return static_cast<std::uint16_t>(sign | h);
+    }
+
+    /// The float equal to the binary16 h, which is always exact
+    constexpr float half_to_float(std::uint16_t h) noexcept {
+      const auto sign = static_cast<std::uint32_t>(h & 0x8000) << 16;
+      const auto e = static_cast<std::uint32_t>(h >> 10) & 0x1f;
+      const auto m = static_cast<std::uint32_t>(h) & 0x3ff;
+      if (e == 0x1f) {
+        return std::bit_cast<float>(sign | 0x7f80'0000 | (m << 13));
+      }
+      if (e != 0) {
+        return std::bit_cast<float>(sign | ((e + 112) << 23) | (m << 13));
+      }
+      const auto v = static_cast<float>(m) * 0x1p-24f;
+      return sign ? -v : v;
+    }
+
+    /// The nearest bfloat16 to f, ties to even
+    constexpr std::uint16_t float_to_bfloat(float f) noexcept {
+      const auto x = std::bit_cast<std::uint32_t>(f);
+      if ((x & 0x7fff'ffff) > 0x7f80'0000) {
+        return static_cast<std::uint16_t>((x >> 16) | 0x40);
+      }
+      return static_cast<std::uint16_t>((x + 0x7fff + ((x >> 16) & 1)) >> 16);
+    }
+
+    constexpr float bfloat_to_float(std::uint16_t b) noexcept {
+      return std::bit_cast<float>(static_cast<std::uint32_t>(b) << 16);
+    }
+  } // namespace Impl
+
+  /** IEEE 754 binary16: 11 significant bits, normal values from 6.1e-5 to
+   * 65504. A storage type, convert to float to compute with it. */
+  struct float16 {
+    std::uint16_t bits;
+
+    constexpr float16() = default;
+    constexpr explicit float16(float f) noexcept
+        : bits(Impl::float_to_half(f)) {}
+    constexpr explicit operator float() const noexcept {
+      return Impl::half_to_float(bits);
+    }
+
+    /// The smallest normal and the largest finite values, as numeric_limits
+    static constexpr float min() noexcept { return 0x1p-14f; }
+    static constexpr float max() noexcept { return 65504.0f; }
+  };
+
+  /** bfloat16, the top half of a float: 8 significant bits, with the range
+   * of float. A storage type, convert to float to compute with it. */
+  struct bfloat16 {
+    std::uint16_t bits;
+
+    constexpr bfloat16() = default;
+    constexpr explicit bfloat16(float f) noexcept
+        : bits(Impl::float_to_bfloat(f)) {}
+    constexpr explicit operator float() const noexcept {
+      return Impl::bfloat_to_float(bits);
+    }
+
+    static constexpr float min() noexcept { return 0x1p-126f; }
+    static constexpr float max() noexcept { return 0x1.fep127f; }
+  };
+
+  namespace Impl {
+    template <class T>
+    inline constexpr bool is_float16_v =
+        std::is_same_v<T, float16> || std::is_same_v<T, bfloat16>;
+
+    /// Floats converted a block at a time, small enough to stay in L1
+    inline constexpr std::size_t float16_block = 512;
+
+    inline void narrow_floats(const float* in, float16* out,
+                              std::size_t n) noexcept {
+      std::size_t i = 0;
+#if UNITS_HAS_F16C
+      for (; i + 8 <= n; i += 8) {
+        const auto h = _mm256_cvtps_ph(_mm256_loadu_ps(in + i),
+                                       _MM_FROUND_TO_NEAREST_INT);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), h);
+      }
+#endif
+      for (; i < n; ++i) {
+        out[i] = float16{in[i]};
+      }
+    }
+
+    inline void widen_floats(const float16* in, float* out,
+                             std::size_t n) noexcept {
+      std::size_t i = 0;
+#if UNITS_HAS_F16C
+      for (; i + 8 <= n; i += 8) {
+        const auto h =
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+        _mm256_storeu_ps(out + i, _mm256_cvtph_ps(h));
+      }
+#endif
+      for (; i < n; ++i) {
+        out[i] = static_cast<float>(in[i]);
+      }
+    }
+
+    // bfloat16 is integer shifts and adds, which the compiler vectorises
+    inline void narrow_floats(const float* in, bfloat16* out,
+                              std::size_t n) noexcept {
+      for (std::size_t i = 0; i < n; ++i) {
+        out[i] = bfloat16{in[i]};
+      }
+    }
+
+    inline void widen_floats(const bfloat16* in, float* out,
+                             std::size_t n) noexcept {
+      for (std::size_t i = 0; i < n; ++i) {
+        out[i] = static_cast<float>(in[i]);
+      }
+    }
+
+    /// Scale in into floats in UnitsTo, and narrow each block of them into
+    /// out. If Checked, throws std::overflow_error for values that don't fit
+    template <bool Checked, class UnitsFrom, class UnitsTo, class BaseType,
+              class Storage>
+    void narrow_blocks(const BaseType* in, Storage* out, std::size_t n) {
+      using Ratio = conversion_ratio<UnitsFrom, UnitsTo>;
+      using Common = promoted_base_t<BaseType, float>;
+      float block[float16_block];
+      for (std::size_t first = 0; first < n; first += float16_block) {
+        const auto size = std::min(float16_block, n - first);
+        for (std::size_t i = 0; i < size; ++i) {
+          const auto v = scale_by<Ratio>(static_cast<Common>(in[first + i]));
+          if constexpr (Checked) {
+            if (std::isnan(v)) {
+              throw std::overflow_error("units::checked_narrow: a value is "
+                                        "NaN");
+            }
+            if (!in_range<float>(v)) {
+              throw std::overflow_error("units::checked_narrow: a value does "
+                                        "not fit in float");
+            }
+          }
+          block[i] = static_cast<float>(v);
+        }
+        narrow_floats(block, out + first, size);
+        if constexpr (Checked) {
+          for (std::size_t i = 0; i < size; ++i) {
+            const auto f = static_cast<float>(out[first + i]);
+            if (std::isinf(f) && !std::isinf(block[i])) {
+              throw std::overflow_error("units::checked_narrow: a value does "
+                                        "not fit in the storage type");
+            }
+            if (f == 0 && in[first + i] != 0) {
+              throw std::underflow_error("units::checked_narrow: a value is "
+                                         "too small for the storage type");
+            }
+          }
+        }
+      }
+    }
+
+    /** The power of ten that centres [min, max] in the normal range of
+     * Storage, on a log scale. */
+    template <class Storage>
+    constexpr int fitting_exponent(double min, double max) {
+      // the centres are the geometric means, compare their squares
+      const auto r =
+          min * max / (static_cast<double>(Storage::min()) * Storage::max());
+      auto k = 0;
+      auto p = 1.0;
+      while (r > p * p * 10) {
+        p *= 10;
+        ++k;
+      }
+      while (r < p * p / 10) {
+        p /= 10;
+        --k;
+      }
+      return k;
+    }
+
+    template <int K>
+    constexpr std::intmax_t power_of_ten() {
+      static_assert(K >= 0 && K <= 18, "the prefix does not fit in a ratio");
+      std::intmax_t p = 1;
+      for (auto i = 0; i < K; ++i) {
+        p *= 10;
+      }
+      return p;
+    }
+
+    template <int K>
+    using power_of_ten_ratio =
+        std::conditional_t<(K >= 0),
+                           std::ratio<power_of_ten<(K < 0 ? 0 : K)>()>,
+                           std::ratio<1, power_of_ten<(K < 0 ? -K : 0)>()>>;
+  } // namespace Impl
+
+  /** Units with the dimensions of Units and a power of ten prefix chosen so
+   * that magnitudes from Min to Max, in Units, are normal values of Storage,
+   * e.g. for pressures from 1 Pa to 10 MPa stored as float16
+   *
+   *   using history_t = units::storage_units_t<units::float16, Pascals_t,
+   *                                            1.0, 1e7>;  // kPa
+   *
+   * The range is centred in that of Storage, so there's room for values a
+   * little outside it. Doesn't compile if it is too wide for Storage. */
+  template <class Storage, class Units, double Min, double Max>
+  struct storage_units {
+    static_assert(Impl::is_float16_v<Storage>);
+    static_assert(0 < Min && Min <= Max);
+    static constexpr auto exponent = Impl::fitting_exponent<Storage>(Min, Max);
+    using prefix = Impl::power_of_ten_ratio<exponent>;
+    static_assert(Max * prefix::den / prefix::num <= Storage::max() &&
+                      Min * prefix::den / prefix::num >= Storage::min(),
+                  "the range of values is too wide for the storage type");
+    using type = derived_t<prefix, Units>;
+  };
+
+  template <class Storage, class Units, double Min, double Max>
+  using storage_units_t =
+      typename storage_units<Storage, Units, Min, Max>::type;
+
+  /** Narrow every element of from into to, 16 bit storage in any units of
+   * the same dimensions, e.g. double Pascals into float16 kPa. Each value is
+   * scaled, rounded to float, then to the nearest Storage, so values beyond
+   * the range of Storage become infinities (see storage_units_t). */
+  template <class UnitsFrom, class UnitsTo, class BaseType, class Storage,
+            class Tag0, class Tag1, std::size_t Extent0, std::size_t Extent1,
+            std::enable_if_t<Impl::is_float16_v<Storage>, int> = 0>
+  void
+  narrow(std::span<const Quantity<UnitsFrom, BaseType, Tag0>, Extent0> from,
+         std::span<Quantity<UnitsTo, Storage, Tag1>, Extent1> to) noexcept {
+    Impl::check_convertible<UnitsFrom, UnitsTo, Tag0, Tag1>();
+    assert(from.size() == to.size());
+    Impl::narrow_blocks<false, UnitsFrom, UnitsTo>(
+        Impl::underlying_data(from.data()), Impl::underlying_data(to.data()),
+        from.size());
+  }
+
+  /** As narrow, but throws std::overflow_error if a value is a NaN or a
+   * finite one becomes an infinity in to, and std::underflow_error if a
+   * nonzero one becomes zero. The values before it are converted. */
+  template <class UnitsFrom, class UnitsTo, class BaseType, class Storage,
+            class Tag0, class Tag1, std::size_t Extent0, std::size_t Extent1,
+            std::enable_if_t<Impl::is_float16_v<Storage>, int> = 0>
+  void checked_narrow(
+      std::span<const Quantity<UnitsFrom, BaseType, Tag0>, Extent0> from,
+      std::span<Quantity<UnitsTo, Storage, Tag1>, Extent1> to) {
+    Impl::check_convertible<UnitsFrom, UnitsTo, Tag0, Tag1>();
+    assert(from.size() == to.size());
+    Impl::narrow_blocks<true, UnitsFrom, UnitsTo>(
+        Impl::underlying_data(from.data()), Impl::underlying_data(to.data()),
+        from.size());
+  }
+
+  /** Widen every element of from, 16 bit storage, into to, float or double
+   * in any units of the same dimensions. This is exact before the scaling
+   * to to's units. */
+  template <class UnitsFrom, class UnitsTo, class Storage, class BaseType,
+            class Tag0, class Tag1, std::size_t Extent0, std::size_t Extent1,
+            std::enable_if_t<Impl::is_float16_v<Storage> &&
+                                 std::is_floating_point_v<BaseType>,
+                             int> = 0>
+  void
+  convert(std::span<const Quantity<UnitsFrom, Storage, Tag0>, Extent0> from,
+          std::span<Quantity<UnitsTo, BaseType, Tag1>, Extent1> to) {
+    Impl::check_convertible<UnitsFrom, UnitsTo, Tag0, Tag1>();
+    using Ratio = Impl::conversion_ratio<UnitsFrom, UnitsTo>;
+    assert(from.size() == to.size());
+    const auto* in = Impl::underlying_data(from.data());
+    auto* out = Impl::underlying_data(to.data());
+    const auto n = from.size();
+    float block[Impl::float16_block];
+    for (std::size_t first = 0; first < n; first += Impl::float16_block) {
+      const auto size = std::min(Impl::float16_block, n - first);
+      Impl::widen_floats(in + first, block, size);
+      for (std::size_t i = 0; i < size; ++i) {
+        out[first + i] = scale_by<Ratio>(static_cast<BaseType>(block[i]));
+      }
+    }
+  }
+} // namespace units
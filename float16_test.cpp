@@ -0,0 +1,156 @@
+#include "common_quantities.hpp"
+#include "float16.hpp"
+#include <catch.hpp>
+
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+SCENARIO("Converting between float and the 16 bit storage types") {
+  using units::bfloat16;
+  using units::float16;
+  GIVEN("values that are exact in 16 bits") {
+    THEN("they round trip") {
+      for (auto f : {0.0f, -0.0f, 1.0f, -2.5f, 65504.0f, 0x1p-14f, 0x1p-24f,
+                     0x1.ff8p-15f}) {
+        REQUIRE(static_cast<float>(float16{f}) == f);
+        REQUIRE(std::signbit(static_cast<float>(float16{f})) ==
+                std::signbit(f));
+      }
+      for (auto f : {0.0f, 1.0f, -3.0f, 0x1p-126f, 0x1.fep127f}) {
+        REQUIRE(static_cast<float>(bfloat16{f}) == f);
+      }
+      static_assert(float16{1.0f}.bits == 0x3c00);
+      static_assert(bfloat16{1.0f}.bits == 0x3f80);
+    }
+  }
+  GIVEN("values between two 16 bit values") {
+    THEN("they round to the nearest, ties to even") {
+      REQUIRE(float16{1.0f + 0x1p-11f}.bits == 0x3c00);
+      REQUIRE(float16{1.0f + 0x1p-11f + 0x1p-20f}.bits == 0x3c01);
+      REQUIRE(float16{1.0f + 3 * 0x1p-11f}.bits == 0x3c02);
+      REQUIRE(float16{0x1p-25f}.bits == 0);
+      REQUIRE(float16{0x1.8p-25f}.bits == 1);
+      REQUIRE(float16{3 * 0x1p-25f}.bits == 2);
+      REQUIRE(float16{65519.0f}.bits == 0x7bff);
+      REQUIRE(float16{65520.0f}.bits == 0x7c00);
+      REQUIRE(bfloat16{1.0f + 0x1p-8f}.bits == 0x3f80);
+      REQUIRE(bfloat16{1.0f + 3 * 0x1p-8f}.bits == 0x3f82);
+    }
+    THEN("every binary16 converts to float and back") {
+      for (auto bits = 0u; bits <= 0xffff; ++bits) {
+        auto h = float16{};
+        h.bits = static_cast<std::uint16_t>(bits);
+        const auto f = static_cast<float>(h);
+        if (std::isnan(f)) {
+          REQUIRE(std::isnan(static_cast<float>(float16{f})));
+        } else {
+          REQUIRE(float16{f}.bits == bits);
+        }
+      }
+    }
+  }
+  GIVEN("infinities and NaNs") {
+    constexpr auto inf = std::numeric_limits<float>::infinity();
+    constexpr auto nan = std::numeric_limits<float>::quiet_NaN();
+    THEN("they are kept") {
+      REQUIRE(static_cast<float>(float16{-inf}) == -inf);
+      REQUIRE(std::isnan(static_cast<float>(float16{nan})));
+      REQUIRE(static_cast<float>(bfloat16{inf}) == inf);
+      REQUIRE(std::isnan(static_cast<float>(bfloat16{nan})));
+    }
+  }
+}
+
+SCENARIO("Storing Quantities in 16 bits") {
+  using units::bfloat16;
+  using units::float16;
+  using history_t =
+      units::storage_units_t<float16, Pascals_t, 1.0, 1e7>;
+  using History = Quantity<history_t, float16>;
+  GIVEN("a prefix chosen for pressures from 1 Pa to 10 MPa") {
+    THEN("it's kPa") {
+      static_assert(std::is_same_v<history_t,
+                                   units::derived_t<units::kilo, Pascals_t>>);
+      static_assert(units::has_underlying_layout<History>);
+      static_assert(sizeof(History) == 2);
+      using speeds_t =
+          units::storage_units_t<float16, metres_per_sec_t, 1e-3, 1e2>;
+      static_assert(
+          std::is_same_v<speeds_t,
+                         units::derived_t<std::deci, metres_per_sec_t>>);
+    }
+  }
+  GIVEN("pressures in double") {
+    auto ps = std::vector<Pascals>{};
+    for (auto i = 0; i < 1000; ++i) {
+      ps.push_back(Pascals{std::pow(1.017, i)});
+    }
+    WHEN("they are narrowed to float16 and widened back") {
+      auto history = std::vector<History>(ps.size());
+      units::narrow(ps, history);
+      auto back = std::vector<Pascals>(ps.size());
+      units::convert(history, back);
+      THEN("they're within the 11 bits of precision") {
+        for (auto i = 0u; i < ps.size(); ++i) {
+          REQUIRE(back[i].underlying_value() ==
+                  Approx(ps[i].underlying_value()).epsilon(0x1p-11));
+        }
+      }
+    }
+    WHEN("they are narrowed to bfloat16") {
+      auto history = std::vector<Quantity<Pascals_t, bfloat16>>(ps.size());
+      units::narrow(ps, history);
+      auto back = std::vector<Quantity<Pascals_t, float>>(ps.size());
+      units::convert(history, back);
+      THEN("they're within the 8 bits of precision") {
+        for (auto i = 0u; i < ps.size(); ++i) {
+          REQUIRE(back[i].underlying_value() ==
+                  Approx(ps[i].underlying_value()).epsilon(0x1p-8));
+        }
+      }
+    }
+    WHEN("they don't fit") {
+      auto history = std::vector<Quantity<Pascals_t, float16>>(ps.size());
+      THEN("checked_narrow throws") {
+        REQUIRE_THROWS_AS(units::checked_narrow(ps, history),
+                          std::overflow_error);
+        units::checked_narrow(std::span<const Pascals>{ps}.first(100),
+                              std::span{history}.first(100));
+        REQUIRE(static_cast<float>(history[0].underlying_value()) == 1);
+      }
+    }
+    WHEN("they are NaN or too small to store") {
+      auto history = std::vector<Quantity<Pascals_t, float16>>(2);
+      THEN("checked_narrow throws") {
+        const auto nan = std::numeric_limits<double>::quiet_NaN();
+        const auto bad = std::vector<Pascals>{Pascals{1}, Pascals{nan}};
+        REQUIRE_THROWS_AS(units::checked_narrow(bad, history),
+                          std::overflow_error);
+        const auto tiny = std::vector<Pascals>{Pascals{0}, Pascals{1e-9}};
+        REQUIRE_THROWS_AS(units::checked_narrow(tiny, history),
+                          std::underflow_error);
+        REQUIRE(static_cast<float>(history[0].underlying_value()) == 0);
+      }
+    }
+  }
+}
+
+SCENARIO("Profiling 16 bit storage", "[Profile]") {
+  using units::float16;
+  GIVEN("a large history buffer") {
+    const auto ps = std::vector<Pascals>(1'000'000, Pascals{101325});
+    using kPa16 =
+        Quantity<units::derived_t<units::kilo, Pascals_t>, float16>;
+    auto history = std::vector<kPa16>(ps.size());
+    auto back = std::vector<Pascals>(ps.size());
+    BENCHMARK("narrow to float16") { units::narrow(ps, history); }
+    BENCHMARK("widen from float16") { units::convert(history, back); }
+    std::cout << back.back() << "\n";
+  }
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+// ************************************************************************* /
+//    Fast debug builds. Define UNITS_FAST_DEBUG to force inline every       /
+//    Quantity member, operator and numeric function, even at -O0 and -Og,   /
+//    so debug builds run at close to the speed of the same code written     /
+//    with doubles. All the static_asserts on the dimensions still apply.    /
+//    Without it UNITS_INLINE is empty, leaving optimised builds unchanged.  /
+// ************************************************************************* /
+
+#if defined(UNITS_FAST_DEBUG)
+#if defined(__GNUC__) || defined(__clang__)
+#define UNITS_INLINE [[gnu::always_inline]] inline
+#elif defined(_MSC_VER)
+// only applies with /Ob1 or above
+#define UNITS_INLINE __forceinline
+#else
+#define UNITS_INLINE inline
+#endif
+#else
+#define UNITS_INLINE
+#endif
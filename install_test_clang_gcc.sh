@@ -1,7 +1,7 @@
 #!/bin/bash
 
 
-files=(string_constants.hpp prefixes.hpp base_dimensions.hpp derived_dimensions.hpp derived_dimensions_printing.hpp derived_dimensions_impl.hpp quantity.hpp numeric_functions.hpp common_units.hpp common_quantities.hpp units.hpp)
+files=(string_constants.hpp force_inline.hpp prefix_value.hpp conversion_factor.hpp prefixes.hpp base_dimensions.hpp derived_dimensions.hpp derived_dimensions_printing.hpp derived_dimensions_impl.hpp quantity.hpp numeric_functions.hpp quantity_cast.hpp common_units.hpp common_quantities.hpp units.hpp)
 #copy header files into system header
 for fname in ${files[*]}; do
     cp $fname "/usr/local/include/"$fname
@@ -1,79 +1,275 @@
 #pragma once
 
+#include "force_inline.hpp"
 #include "quantity.hpp"
+#include "quantity_cast.hpp"
+#include <cassert>
+#include <cmath>
+#include <cstddef>
 #include <experimental/type_traits>
 #include <limits>
+#include <numeric>
+#include <span>
+#include <type_traits>
+
+#if __has_include(<experimental/simd>)
+#include <experimental/simd>
+#define UNITS_HAS_SIMD 1
+#else
+#define UNITS_HAS_SIMD 0
+#endif
+
+// std::is_constant_evaluated is a call of its own in unoptimised builds, the
+// builtin behind it is folded even at -O0
+#if defined(__has_builtin)
+#if __has_builtin(__builtin_is_constant_evaluated)
+#define UNITS_IS_CONSTANT_EVALUATED() __builtin_is_constant_evaluated()
+#endif
+#endif
+#if !defined(UNITS_IS_CONSTANT_EVALUATED)
+#define UNITS_IS_CONSTANT_EVALUATED() std::is_constant_evaluated()
+#endif
 
 // ************************************************************************* /
 //    Creating a pow function, needs compile time Power as types are         /
-//    generated                                                              /
+//    generated. The value is raised by repeated squaring, only the result   /
+//    is a new Quantity type.                                                /
 // ************************************************************************* /
+namespace Impl {
+  /// x^N by repeated squaring, N - 1 multiplies at most and log2(N) deep
+  template <int N, class T>
+  UNITS_INLINE constexpr T power_of(T x) noexcept {
+    static_assert(N >= 0);
+    if constexpr (N == 0) {
+      return T{1};
+    } else if constexpr (N == 1) {
+      return x;
+    } else if constexpr (N % 2 == 0) {
+      const auto half = Impl::power_of<N / 2>(x);
+      return half * half;
+    } else {
+      return x * Impl::power_of<N - 1>(x);
+    }
+  }
+
+  /// The type of a Quantity raised to the power N/D. As for multiplication,
+  /// floating point results have a prefix of unity and integral ones keep
+  /// the power of the prefix.
+  template <int N, int D, class Units, class BaseType, class Tag>
+  using pow_t = Quantity<
+      std::conditional_t<std::is_integral_v<BaseType>,
+                         decltype(units::pow<N, D>(Units{})),
+                         units::derived_unity_t<decltype(units::pow<N, D>(
+                             units::derived_unity_t<Units>{}))>>,
+      BaseType, Tag>;
+} // namespace Impl
+
 template <int power, class Units, class BaseType, class Tag>
-constexpr auto pow(const Quantity<Units, BaseType, Tag>& a) noexcept {
-  if constexpr (power == 1) {
-    return a;
-  } else if constexpr (power > 1) {
-    return a * pow<power - 1>(a);
-  } else if constexpr (power == -1) {
-    return 1 / a;
-  } else if constexpr (power < -1) {
-    return (1 / a) * pow<power + 1>(a);
-  } else if constexpr (power == 0) {
+UNITS_INLINE constexpr auto
+pow(const Quantity<Units, BaseType, Tag>& a) noexcept {
+  static_assert(tags_compatible_multiplication<Tag, Tag>());
+  if constexpr (power == 0) {
     return 1;
+  } else {
+    using Result = Impl::pow_t<power, 1, Units, BaseType, Tag>;
+    const auto v = std::is_integral_v<BaseType>
+                       ? a.underlying_value()
+                       : a.underlying_value_no_prefix();
+    if constexpr (power > 0) {
+      return Result{Impl::power_of<power>(v)};
+    } else {
+      return Result{1 / Impl::power_of<-power>(v)};
+    }
   }
 }
 
 // ************************************************************************* /
-//    Creating a sqrt function, needs compile time Power as types are        /
-//    generated                                                              /
+//    Creating sqrt, cbrt and root<N> functions, needs compile time Power as  /
+//    types are generated. At runtime these are the hardware instruction or  /
+//    the standard library, Newton-Raphson is only used in constant          /
+//    expressions.                                                           /
 // ************************************************************************* /
 
-/*
- * Constexpr version of the square root
- * Return value:
- *   - For a finite and non-negative value of "x", returns an approximation for
- * the square root of "x"
- *   - Otherwise, returns NaN
- */
 namespace Impl {
-  template <class T> //, std::enable_if_t<std::is_arithmetic_v(T{})>>
-  T constexpr sqrtNewtonRaphson(T x, T curr, T prev) {
-    return curr == prev ? curr
-                        : sqrtNewtonRaphson(x, (curr + x / curr) / 2, curr);
+  /* Newton-Raphson iteration for the N-th root of a finite x > 0. Starting
+   * above the root the iterates decrease until they converge, so stop at the
+   * first one that doesn't. */
+  template <int N, class T>
+  constexpr T rootNewtonRaphson(T x) {
+    auto curr = x > 1 ? x : T{1};
+    for (;;) {
+      const auto next = ((N - 1) * curr + x / power_of<N - 1>(curr)) / N;
+      if (!(next < curr)) {
+        return curr;
+      }
+      curr = next;
+    }
   }
 
-  template <class T> //, std::enable_if_t<std::is_arithmetic_v(T{})>>
-  T constexpr sqrt(T x) {
-    assert(x > 0);
-    return x >= 0 && x < std::numeric_limits<T>::infinity()
-               ? Impl::sqrtNewtonRaphson(x, x, T{0})
-               : std::numeric_limits<T>::quiet_NaN();
+  /*
+   * The N-th root of x, as std::sqrt and std::cbrt: NaN for a negative x when
+   * N is even (for odd N the root of a negative x is negative), and zero,
+   * infinity and NaN return themselves.
+   */
+  template <int N, class T>
+  constexpr T constant_root(T x) {
+    if (x < 0) {
+      return N % 2 == 1 ? -Impl::constant_root<N>(-x)
+                        : std::numeric_limits<T>::quiet_NaN();
+    }
+    return x == 0 || !(x < std::numeric_limits<T>::infinity())
+               ? x
+               : Impl::rootNewtonRaphson<N>(x);
+  }
+
+  template <int N, class T>
+  UNITS_INLINE constexpr T root(T x) {
+    static_assert(N > 0);
+    if (UNITS_IS_CONSTANT_EVALUATED()) {
+      return Impl::constant_root<N>(x);
+    }
+    if constexpr (N == 1) {
+      return x;
+    } else if constexpr (N == 2) {
+      return static_cast<T>(std::sqrt(x));
+    } else if constexpr (N == 3) {
+      return static_cast<T>(std::cbrt(x));
+    } else if constexpr (N == 4) {
+      return static_cast<T>(std::sqrt(std::sqrt(x)));
+    } else if constexpr (N % 2 == 1) {
+      const auto r = std::pow(std::abs(x), 1 / static_cast<double>(N));
+      return static_cast<T>(x < 0 ? -r : r);
+    } else {
+      return static_cast<T>(std::pow(x, 1 / static_cast<double>(N)));
+    }
   }
+
+  template <class T>
+  UNITS_INLINE constexpr T sqrt(T x) {
+    return Impl::root<2>(x);
+  }
+
+  /// The type of the N-th root of a Quantity, in units without a prefix
+  template <int N, class Units, class BaseType, class Tag>
+  using root_t = Quantity<decltype(units::root<N>(
+                              units::derived_unity_t<decltype(Units{})>{})),
+                          BaseType, Tag>;
 } // namespace Impl
 
+template <int N, class Units, class BaseType, class Tag>
+UNITS_INLINE constexpr auto root(const Quantity<Units, BaseType, Tag>& a) {
+  using Result = Impl::root_t<N, Units, BaseType, Tag>;
+  return Result{Impl::root<N>(a.underlying_value_no_prefix())};
+}
+
 namespace std {
   template <class Units, class BaseType, class Tag>
-  constexpr auto sqrt(const Quantity<Units, BaseType, Tag>& a) {
-    using Units0 = units::derived_unity_t<decltype(Units{})>;
-    using Units1 = decltype(units::sqrt(Units0{}));
-    auto val = Impl::sqrt(a.underlying_value_no_prefix());
-    return Quantity<Units1, BaseType, Tag>{val};
+  UNITS_INLINE constexpr auto sqrt(const Quantity<Units, BaseType, Tag>& a) {
+    return ::root<2>(a);
+  }
+
+  template <class Units, class BaseType, class Tag>
+  UNITS_INLINE constexpr auto cbrt(const Quantity<Units, BaseType, Tag>& a) {
+    return ::root<3>(a);
   }
 } // namespace std
 
+/*
+ * a raised to the rational power N/D, e.g. pow<3, 2>(a) for a^1.5. The
+ * powers 1/2, 1/3, 3/2 and their reciprocals are square and cube roots and
+ * multiplies, others call std::pow at runtime. In constant expressions it's
+ * the D-th root (by Newton-Raphson) raised to N.
+ */
+template <int N, int D, class Units, class BaseType, class Tag>
+UNITS_INLINE constexpr auto pow(const Quantity<Units, BaseType, Tag>& a) {
+  static_assert(D > 0);
+  constexpr auto g = std::gcd(N, D);
+  if constexpr (D / g == 1) {
+    return ::pow<N / g>(a);
+  } else {
+    static_assert(std::is_floating_point_v<BaseType>,
+                  "rational powers need a floating point BaseType");
+    constexpr auto n = N / g;
+    constexpr auto d = D / g;
+    using Result = Impl::pow_t<n, d, Units, BaseType, Tag>;
+    const auto x = a.underlying_value_no_prefix();
+    auto v = BaseType{};
+    if (UNITS_IS_CONSTANT_EVALUATED()) {
+      v = Impl::power_of<(n < 0 ? -n : n)>(Impl::root<d>(x));
+    } else if constexpr (d == 2 && (n == 1 || n == -1)) {
+      v = std::sqrt(x);
+    } else if constexpr (d == 3 && (n == 1 || n == -1)) {
+      v = std::cbrt(x);
+    } else if constexpr (d == 2 && (n == 3 || n == -3)) {
+      v = x * std::sqrt(x);
+    } else {
+      return Result{static_cast<BaseType>(
+          std::pow(x, static_cast<BaseType>(n) / static_cast<BaseType>(d)))};
+    }
+    return Result{n < 0 ? 1 / v : v};
+  }
+}
+
+/*
+ * The N-th root of each of in, written to out, which must be at least as
+ * long. The square and fourth roots use SIMD square root instructions
+ * through std::experimental::simd where it's available, as a loop of
+ * std::sqrt can only be vectorised with -fno-math-errno.
+ */
+template <int N, class In, std::size_t E0, class Out, std::size_t E1>
+void root(std::span<In, E0> in, std::span<Out, E1> out) {
+  using Traits = units::Impl::quantity_traits<std::remove_const_t<In>>;
+  using BaseType = typename Traits::BaseType;
+  using Result =
+      Impl::root_t<N, typename Traits::Units, BaseType, typename Traits::Tag>;
+  static_assert(std::is_same_v<Out, Result>,
+                "out must be of the type root<N> returns");
+  assert(out.size() >= in.size());
+  auto i = std::size_t{};
+#if UNITS_HAS_SIMD
+  if constexpr ((N == 2 || N == 4) && std::is_floating_point_v<BaseType>) {
+    namespace stdx = std::experimental;
+    using V = stdx::native_simd<BaseType>;
+    for (; i + V::size() <= in.size(); i += V::size()) {
+      auto v = stdx::sqrt(
+          V{[&](auto j) { return in[i + j].underlying_value_no_prefix(); }});
+      if constexpr (N == 4) {
+        v = stdx::sqrt(v);
+      }
+      for (auto j = std::size_t{}; j < V::size(); ++j) {
+        out[i + j] = Out{v[j]};
+      }
+    }
+  }
+#endif
+  for (; i < in.size(); ++i) {
+    out[i] = ::root<N>(in[i]);
+  }
+}
+
+template <class In, std::size_t E0, class Out, std::size_t E1>
+void sqrt(std::span<In, E0> in, std::span<Out, E1> out) {
+  root<2>(in, out);
+}
+
+template <class In, std::size_t E0, class Out, std::size_t E1>
+void cbrt(std::span<In, E0> in, std::span<Out, E1> out) {
+  root<3>(in, out);
+}
+
 // ************************************************************************* /
 //    Overloading the abs functions /
 // ************************************************************************* /
 namespace std {
   template <class Units, class BaseType, class Tag>
-  constexpr Quantity<Units, BaseType, Tag>
+  UNITS_INLINE constexpr Quantity<Units, BaseType, Tag>
   abs(const Quantity<Units, BaseType, Tag>& a) noexcept {
     return Quantity<Units, BaseType, Tag>{std::abs(a.underlying_value())};
   }
 
   template <class Units, class BaseType, class Tag,
             typename = std::enable_if_t<std::is_floating_point_v<BaseType>>>
-  constexpr Quantity<Units, BaseType, Tag>
+  UNITS_INLINE constexpr Quantity<Units, BaseType, Tag>
   fabs(const Quantity<Units, BaseType, Tag>& a) noexcept {
     return Quantity<Units, BaseType, Tag>{std::fabs(a.underlying_value())};
   }
@@ -90,23 +286,31 @@ namespace std {
     using nlim = std::numeric_limits<BaseType>;
     using Quant = Quantity<Units, BaseType, Tag>;
 
-    constexpr static auto min() noexcept { return Quant{nlim::min()}; }
-    constexpr static auto lowest() noexcept { return Quant{nlim::lowest()}; }
-    constexpr static auto max() noexcept { return Quant{nlim::max()}; }
-    constexpr static auto epsilon() noexcept { return Quant{nlim::epsilon()}; }
-    constexpr static auto round_error() noexcept {
+    UNITS_INLINE constexpr static auto min() noexcept {
+      return Quant{nlim::min()};
+    }
+    UNITS_INLINE constexpr static auto lowest() noexcept {
+      return Quant{nlim::lowest()};
+    }
+    UNITS_INLINE constexpr static auto max() noexcept {
+      return Quant{nlim::max()};
+    }
+    UNITS_INLINE constexpr static auto epsilon() noexcept {
+      return Quant{nlim::epsilon()};
+    }
+    UNITS_INLINE constexpr static auto round_error() noexcept {
       return Quant{nlim::round_error()};
     }
-    constexpr static auto infinity() noexcept {
+    UNITS_INLINE constexpr static auto infinity() noexcept {
       return Quant{nlim::infinity()};
     }
-    constexpr static auto quiet_NaN() noexcept {
+    UNITS_INLINE constexpr static auto quiet_NaN() noexcept {
       return Quant{nlim::quiet_NaN()};
     }
-    constexpr static auto signaling_NaN() noexcept {
+    UNITS_INLINE constexpr static auto signaling_NaN() noexcept {
       return Quant{nlim::signaling_NaN()};
     }
-    constexpr static auto denorm_min() noexcept {
+    UNITS_INLINE constexpr static auto denorm_min() noexcept {
       return Quant{nlim::denorm_min()};
     }
 
@@ -138,16 +342,16 @@ namespace std {
 // Helper functions, nicer to write huge(T{}) than numeric_limits<T>::()
 // (borrowed from Fortan!)
 template <class Units, class BaseType, class Tag>
-constexpr auto huge(Quantity<Units, BaseType, Tag>) noexcept {
+UNITS_INLINE constexpr auto huge(Quantity<Units, BaseType, Tag>) noexcept {
   return std::numeric_limits<Quantity<Units, BaseType, Tag>>::max();
 }
 
 template <class Units, class BaseType, class Tag>
-constexpr auto tiny(Quantity<Units, BaseType, Tag>) noexcept {
+UNITS_INLINE constexpr auto tiny(Quantity<Units, BaseType, Tag>) noexcept {
   return std::numeric_limits<Quantity<Units, BaseType, Tag>>::min();
 }
 
 template <class Units, class BaseType, class Tag>
-constexpr auto epsilon(Quantity<Units, BaseType, Tag>) noexcept {
+UNITS_INLINE constexpr auto epsilon(Quantity<Units, BaseType, Tag>) noexcept {
   return std::numeric_limits<Quantity<Units, BaseType, Tag>>::epsilon();
 }
\ No newline at end of file
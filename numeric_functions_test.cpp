@@ -3,6 +3,12 @@
 #include "quantity.hpp"
 #include <catch.hpp>
 
+#include <cmath>
+#include <iostream>
+#include <span>
+#include <utility>
+#include <vector>
+
 SCENARIO("Test testing numeric functions") {
   GIVEN("R values")
   WHEN("raising metres to a power") {
@@ -35,12 +41,78 @@ SCENARIO("Test testing numeric functions") {
       REQUIRE(pow<2>(metres{-2}) == metres2{4});
       REQUIRE(pow<3>(metres{-2}) == metres3{-8});
       REQUIRE(pow<1>(metres{-2}) == metres{-2});
+      REQUIRE(pow<4>(metres{2}) ==
+              Quantity<units::derived_t<units::Length<4>>>{16});
+      REQUIRE(pow<-3>(metres{2}) == 1 / metres3{8});
+      REQUIRE(pow<2>(km{2}) == metres2{4e6});
+      REQUIRE(pow<-1>(km{2}) == 1 / metres{2000});
+      REQUIRE(pow<0>(metres{2}) == 1);
+      static_assert(pow<7>(metres{2}).underlying_value() == 128);
+      static_assert(pow<-6>(metres{2}).underlying_value() == 1. / 64);
+    }
+    WHEN("using rational powers") {
+      REQUIRE(pow<1, 2>(metres{4}) == metres05{2});
+      REQUIRE(pow<1, 2>(metres{4}) == std::sqrt(metres{4}));
+      REQUIRE(pow<2, 4>(metres{4}) == metres05{2});
+      REQUIRE(pow<4, 2>(metres{3}) == pow<2>(metres{3}));
+      REQUIRE(pow<3, 2>(metres{4}) ==
+              Quantity<units::derived_t<units::Length<3, 2>>>{8});
+      REQUIRE(pow<-1, 2>(metres{4}) ==
+              Quantity<units::derived_t<units::Length<-1, 2>>>{0.5});
+      REQUIRE(pow<1, 3>(metres3{8}).underlying_value() == Approx(2));
+      REQUIRE(pow<2, 3>(metres3{8}).underlying_value() == Approx(4));
+      REQUIRE(Pascals{1e6} * pow<1, 2>(metres{4}) == MPam05{2});
+      static_assert(pow<3, 2>(metres{4}).underlying_value() == 8);
+      static_assert(pow<-2, 3>(metres{8}).underlying_value() == 0.25);
     }
     WHEN("using sqrt") {
       REQUIRE(std::sqrt(metres{1}) == metres05{1});
       REQUIRE(std::sqrt(metres{9}) == metres05{3});
       REQUIRE(std::sqrt(metres2{9}) == metres{3});
-      // REQUIRE(sqrt(m2{-9}) == metres{3});         should assert false
+      REQUIRE(std::sqrt(metres2{0}) == metres{0});
+      REQUIRE(std::isnan(std::sqrt(metres2{-9}).underlying_value()));
+      REQUIRE(std::sqrt(Quantity<km_t>{4}) == Quantity<metres05_t>{
+                                                   std::sqrt(4000.)});
+    }
+    WHEN("using cbrt and root") {
+      REQUIRE(std::cbrt(metres3{27}).underlying_value() == Approx(3));
+      REQUIRE(std::cbrt(metres3{-8}).underlying_value() == Approx(-2));
+      REQUIRE(root<4>(pow<4>(metres{3})) == metres{3});
+      REQUIRE(root<5>(pow<5>(metres{-2})).underlying_value() == Approx(-2));
+      REQUIRE(root<1>(metres{2}) == metres{2});
+    }
+    WHEN("in constant expressions") {
+      static_assert(std::sqrt(metres2{9}) == metres{3});
+      static_assert(std::sqrt(metres2{0}) == metres{0});
+      static_assert(std::cbrt(metres3{-27}) == metres{-3});
+      // Newton-Raphson is within an ulp of the hardware's correctly rounded
+      // result, so compare with a tolerance
+      constexpr auto close = [](auto a, double b) {
+        const auto d = a.underlying_value() / b - 1;
+        return d < 3e-16 && d > -3e-16;
+      };
+      static_assert(close(std::sqrt(metres2{2}), 1.4142135623730951));
+      static_assert(close(std::sqrt(metres2{1e300}), 1e150));
+      static_assert(close(root<4>(pow<4>(metres{1e-3})), 1e-3));
+      static_assert(close(std::cbrt(metres3{1e-30}), 1e-10));
+    }
+    WHEN("taking the roots of arrays") {
+      auto areas = std::vector<metres2>{};
+      for (auto i = 0; i < 11; ++i) {
+        areas.push_back(metres2{i * 1.5});
+      }
+      auto lengths = std::vector<metres>(areas.size());
+      sqrt(std::span{std::as_const(areas)}, std::span{lengths});
+      for (auto i = std::size_t{}; i < areas.size(); ++i) {
+        REQUIRE(lengths[i] == std::sqrt(areas[i]));
+      }
+      auto roots = std::vector<Quantity<metres05_t>>(areas.size());
+      root<4>(std::span{areas}, std::span{roots});
+      REQUIRE(roots[10] == root<4>(areas[10]));
+      auto volumes = std::vector<metres3>{metres3{8}, metres3{-1}};
+      cbrt(std::span{volumes}, std::span{lengths});
+      REQUIRE(lengths[0] == std::cbrt(volumes[0]));
+      REQUIRE(lengths[1] == std::cbrt(volumes[1]));
     }
   }
 }
@@ -113,4 +185,20 @@ SCENARIO("Testing std overloads in numeric_limits for Quantities") {
   GIVEN("an underlying type of short") { runner<short>(); }
   GIVEN("an underlying type of long double") { runner<long double>(); }
   GIVEN("an underlying type of long long") { runner<long long>(); }
-}
\ No newline at end of file
+}
+SCENARIO("Profiling sqrt", "[Profile]") {
+  GIVEN("a million areas") {
+    auto areas = std::vector<metres2>{};
+    for (auto i = 0; i < 1'000'000; ++i) {
+      areas.push_back(metres2{i * 0.5});
+    }
+    auto lengths = std::vector<metres>(areas.size());
+    BENCHMARK("std::sqrt") {
+      for (auto i = std::size_t{}; i < areas.size(); ++i) {
+        lengths[i] = std::sqrt(areas[i]);
+      }
+    }
+    BENCHMARK("batch sqrt") { sqrt(std::span{areas}, std::span{lengths}); }
+    std::cout << lengths.back() << "\n";
+  }
+}
@@ -0,0 +1,376 @@
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+#include <numeric>
+#include <ratio>
+#include <stdexcept>
+#include <type_traits>
+
+// ************************************************************************* /
+//    The prefix (scale) of a unit as an exact value: a reduced num / den    /
+//    times a power of ten. A product of prefixes that doesn't fit in a      /
+//    std::ratio of intmax_t, e.g. giga * acre or kilo * per_ns * us_gallon, /
+//    keeps its powers of ten in the exponent and so stays exact at compile  /
+//    time. It is only rounded once, to the BaseType, where it's used.       /
+// ************************************************************************* /
+
+namespace units {
+  namespace Impl {
+    /** An unsigned integer of Words 32 bit words, least significant first.
+     * Just enough of an arbitrary precision integer for exact prefix
+     * arithmetic at compile time, so only the operations that needs. */
+    template <int Words>
+    struct BigUint {
+      static_assert(Words >= 2);
+      std::uint32_t word[Words]{};
+
+      constexpr BigUint() = default;
+      constexpr BigUint(std::uintmax_t v) {
+        word[0] = static_cast<std::uint32_t>(v);
+        word[1] = static_cast<std::uint32_t>(v >> 32);
+      }
+
+      constexpr bool is_zero() const {
+        for (auto w : word) {
+          if (w != 0) {
+            return false;
+          }
+        }
+        return true;
+      }
+
+      constexpr int bit_width() const {
+        for (auto i = Words - 1; i >= 0; --i) {
+          for (auto b = 31; b >= 0; --b) {
+            if ((word[i] >> b) & 1) {
+              return 32 * i + b + 1;
+            }
+          }
+        }
+        return 0;
+      }
+
+      /// The low 64 bits.
+      constexpr std::uintmax_t low() const {
+        return std::uintmax_t{word[0]} | std::uintmax_t{word[1]} << 32;
+      }
+
+      constexpr bool fits(std::uintmax_t max) const {
+        for (auto i = 2; i < Words; ++i) {
+          if (word[i] != 0) {
+            return false;
+          }
+        }
+        return low() <= max;
+      }
+
+      /// *this *= m, false (and *this unspecified) if it overflows.
+      constexpr bool multiply(std::uint32_t m) {
+        auto carry = std::uintmax_t{};
+        for (auto& w : word) {
+          carry += std::uintmax_t{w} * m;
+          w = static_cast<std::uint32_t>(carry);
+          carry >>= 32;
+        }
+        return carry == 0;
+      }
+
+      /// *this *= m, false (and *this unspecified) if it overflows.
+      constexpr bool multiply(const BigUint& m) {
+        auto product = BigUint{};
+        for (auto i = 0; i < Words; ++i) {
+          auto carry = std::uintmax_t{};
+          for (auto j = 0; j < Words; ++j) {
+            carry += std::uintmax_t{word[i]} * m.word[j];
+            if (i + j < Words) {
+              carry += product.word[i + j];
+              product.word[i + j] = static_cast<std::uint32_t>(carry);
+            } else if (static_cast<std::uint32_t>(carry) != 0) {
+              return false;
+            }
+            carry >>= 32;
+          }
+          if (carry != 0) {
+            return false;
+          }
+        }
+        *this = product;
+        return true;
+      }
+
+      /// *this /= d if d divides it exactly, and whether it did.
+      constexpr bool divide_exact(std::uint32_t d) {
+        auto quotient = *this;
+        auto r = std::uintmax_t{};
+        for (auto i = Words - 1; i >= 0; --i) {
+          r = r << 32 | word[i];
+          quotient.word[i] = static_cast<std::uint32_t>(r / d);
+          r %= d;
+        }
+        if (r != 0) {
+          return false;
+        }
+        *this = quotient;
+        return true;
+      }
+
+      /// *this <<= n, the caller makes sure nothing is shifted out.
+      constexpr void shift_left(int n) {
+        const auto words = n / 32;
+        const auto bits = n % 32;
+        for (auto i = Words - 1; i >= 0; --i) {
+          auto w = std::uint32_t{};
+          if (i - words >= 0) {
+            w = word[i - words] << bits;
+            if (bits != 0 && i - words - 1 >= 0) {
+              w |= word[i - words - 1] >> (32 - bits);
+            }
+          }
+          word[i] = w;
+        }
+      }
+
+      /// *this -= b, for b <= *this.
+      constexpr void subtract(const BigUint& b) {
+        auto borrow = std::uint32_t{};
+        for (auto i = 0; i < Words; ++i) {
+          const auto d = std::uintmax_t{word[i]} - b.word[i] - borrow;
+          word[i] = static_cast<std::uint32_t>(d);
+          borrow = d >> 63;
+        }
+      }
+
+      friend constexpr bool operator<(const BigUint& a, const BigUint& b) {
+        for (auto i = Words - 1; i >= 0; --i) {
+          if (a.word[i] != b.word[i]) {
+            return a.word[i] < b.word[i];
+          }
+        }
+        return false;
+      }
+    };
+
+    constexpr std::uintmax_t magnitude(std::intmax_t v) {
+      return v < 0 ? -static_cast<std::uintmax_t>(v)
+                   : static_cast<std::uintmax_t>(v);
+    }
+  } // namespace Impl
+
+  /** An exact prefix, num / den * 10^exponent. Canonical, so equal values
+   * compare equal member by member and give the same type as template
+   * arguments:
+   *  - a value that fits in a ratio of intmax_t has an exponent of 0 and
+   *    num and den coprime, just as std::ratio,
+   *  - any other has den coprime to 10 and num not a multiple of 10.
+   * Products that don't fit even so throw std::overflow_error, which is a
+   * compile error in a constant expression. */
+  struct PrefixValue {
+    std::intmax_t num = 1;
+    std::intmax_t den = 1;
+    int exponent = 0;
+
+    constexpr PrefixValue() = default;
+    constexpr PrefixValue(std::intmax_t n, std::intmax_t d = 1)
+        : num{n}, den{d} {
+      assert(d != 0);
+      if (d == 1) {
+        return;
+      }
+      const auto g = std::gcd(num, den);
+      num /= g;
+      den /= g;
+      if (den < 0) {
+        num = -num;
+        den = -den;
+      }
+    }
+    constexpr PrefixValue(std::intmax_t n, std::intmax_t d, int exp);
+
+    /// True if the value is num / den, i.e. it fits in a std::ratio.
+    constexpr bool is_ratio() const { return exponent == 0; }
+
+    friend constexpr bool operator==(const PrefixValue&,
+                                     const PrefixValue&) = default;
+  };
+
+  namespace Impl {
+    /// Wide enough for a product of two intmax_t and so any prefix product
+    using PrefixWord = BigUint<4>;
+
+    /** n / d * 10^exponent, with n and d coprime, in the canonical form of
+     * PrefixValue. False if it needs a num or den beyond intmax_t. */
+    constexpr bool normalise_prefix(PrefixWord n, PrefixWord d, int exponent,
+                                    bool negative, PrefixValue& out) {
+      constexpr auto max = static_cast<std::uintmax_t>(INTMAX_MAX);
+      const auto sign = [&](std::uintmax_t v) {
+        return negative ? -static_cast<std::intmax_t>(v)
+                        : static_cast<std::intmax_t>(v);
+      };
+      if (n.is_zero()) {
+        out = PrefixValue{0};
+        return true;
+      }
+      while (n.divide_exact(10)) {
+        ++exponent;
+      }
+      while (d.divide_exact(10)) {
+        --exponent;
+      }
+      // the plain ratio, each power of ten cancelling a 2 or 5 if it can
+      auto rn = n;
+      auto rd = d;
+      auto fits = rn.fits(max) && rd.fits(max);
+      for (auto e = exponent; fits && e > 0; --e) {
+        fits = rd.divide_exact(2)   ? rn.multiply(5)
+               : rd.divide_exact(5) ? rn.multiply(2)
+                                    : rn.multiply(10);
+        fits = fits && rn.fits(max);
+      }
+      for (auto e = exponent; fits && e < 0; ++e) {
+        fits = rn.divide_exact(2)   ? rd.multiply(5)
+               : rn.divide_exact(5) ? rd.multiply(2)
+                                    : rd.multiply(10);
+        fits = fits && rd.fits(max);
+      }
+      if (fits) {
+        out.num = sign(rn.low());
+        out.den = static_cast<std::intmax_t>(rd.low());
+        out.exponent = 0;
+        return true;
+      }
+      // otherwise move the 2s and 5s of den into num and the exponent,
+      // den has only one of them as it has no factor of 10
+      while (d.divide_exact(2)) {
+        if (!n.multiply(5)) {
+          return false;
+        }
+        --exponent;
+      }
+      while (d.divide_exact(5)) {
+        if (!n.multiply(2)) {
+          return false;
+        }
+        --exponent;
+      }
+      if (!n.fits(max) || !d.fits(max)) {
+        return false;
+      }
+      out.num = sign(n.low());
+      out.den = static_cast<std::intmax_t>(d.low());
+      out.exponent = exponent;
+      return true;
+    }
+
+    /** out = a * b, false if the result doesn't fit in a PrefixValue. Cross
+     * cancels first, as std::ratio_multiply does, and products of plain
+     * ratios that fit skip the wide arithmetic. */
+    constexpr bool multiply_prefixes(const PrefixValue& a,
+                                     const PrefixValue& b, PrefixValue& out) {
+      if (a.num == 0 || b.num == 0) {
+        out = PrefixValue{0};
+        return true;
+      }
+      const auto g0 = std::gcd(a.num, b.den);
+      const auto g1 = std::gcd(b.num, a.den);
+      const auto an = magnitude(a.num / g0);
+      const auto bn = magnitude(b.num / g1);
+      const auto ad = magnitude(a.den / g1);
+      const auto bd = magnitude(b.den / g0);
+      const auto negative = (a.num < 0) != (b.num < 0);
+      constexpr auto max = static_cast<std::uintmax_t>(INTMAX_MAX);
+      if (a.exponent == 0 && b.exponent == 0 && an <= max / bn &&
+          ad <= max / bd) {
+        const auto n = static_cast<std::intmax_t>(an * bn);
+        out.num = negative ? -n : n;
+        out.den = static_cast<std::intmax_t>(ad * bd);
+        out.exponent = 0;
+        return true;
+      }
+      auto n = PrefixWord{an};
+      auto d = PrefixWord{ad};
+      n.multiply(PrefixWord{bn});
+      d.multiply(PrefixWord{bd});
+      return normalise_prefix(n, d, a.exponent + b.exponent, negative, out);
+    }
+
+    /// 1 / p, not canonical unless p is a ratio, for multiply_prefixes.
+    constexpr PrefixValue reciprocal(const PrefixValue& p) {
+      assert(p.num != 0);
+      auto r = PrefixValue{};
+      r.num = p.num < 0 ? -p.den : p.den;
+      r.den = p.num < 0 ? -p.num : p.num;
+      r.exponent = -p.exponent;
+      return r;
+    }
+  } // namespace Impl
+
+  constexpr PrefixValue::PrefixValue(std::intmax_t n, std::intmax_t d,
+                                     int exp) {
+    assert(d != 0);
+    const auto g = std::gcd(n, d);
+    if (!Impl::normalise_prefix(Impl::magnitude(n / g),
+                                Impl::magnitude(d / g), exp,
+                                (n < 0) != (d < 0), *this)) {
+      throw std::overflow_error("prefix does not fit in a PrefixValue");
+    }
+  }
+
+  constexpr PrefixValue operator*(const PrefixValue& a, const PrefixValue& b) {
+    auto out = PrefixValue{};
+    if (!Impl::multiply_prefixes(a, b, out)) {
+      throw std::overflow_error("product of prefixes does not fit in a "
+                                "PrefixValue");
+    }
+    return out;
+  }
+
+  constexpr PrefixValue operator/(const PrefixValue& a, const PrefixValue& b) {
+    return a * Impl::reciprocal(b);
+  }
+
+  /** A prefix that doesn't fit in a std::ratio, the prefix alias of
+   * Dimensions whose Code.prefix isn't a ratio. It can be used as an
+   * argument to derived_t as a std::ratio can. */
+  template <PrefixValue P>
+  struct ExtendedPrefix {
+    static constexpr PrefixValue value = P;
+  };
+
+  template <class Arg>
+  constexpr std::false_type is_extended_prefix(Arg) {
+    return std::false_type{};
+  }
+
+  template <PrefixValue P>
+  constexpr std::true_type is_extended_prefix(ExtendedPrefix<P>) {
+    return std::true_type{};
+  }
+
+  namespace Impl {
+    /// The std::ratio of P if it is one, else ExtendedPrefix<P>.
+    template <PrefixValue P>
+    using prefix_type_t = std::conditional_t<P.is_ratio(),
+                                             std::ratio<P.num, P.den>,
+                                             ExtendedPrefix<P>>;
+
+    /// The PrefixValue of a std::ratio or ExtendedPrefix.
+    template <class Prefix>
+    constexpr PrefixValue to_prefix_value() {
+      if constexpr (is_extended_prefix(Prefix{})) {
+        return Prefix::value;
+      } else {
+        return {Prefix::num, Prefix::den};
+      }
+    }
+  } // namespace Impl
+
+  static_assert(PrefixValue{1000, 1'000'000} == PrefixValue{1, 1000});
+  static_assert(PrefixValue{1, 1, 3} == PrefixValue{1000});
+  static_assert(PrefixValue{1, 1, 30}.exponent == 30);
+  static_assert(PrefixValue{1, 1, 30} / PrefixValue{1, 1, 20} ==
+                PrefixValue{10'000'000'000});
+  static_assert(PrefixValue{404'685'642} * PrefixValue{1, 1, 18} ==
+                PrefixValue{202'342'821, 1, 18} * PrefixValue{2});
+  static_assert(PrefixValue{1, 4, 30} == PrefixValue{25, 1, 28});
+} // namespace units
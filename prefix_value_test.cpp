@@ -0,0 +1,109 @@
+#include "any_quantity.hpp"
+#include "common_quantities.hpp"
+#include "convert.hpp"
+#include "derived_dimensions_printing.hpp"
+#include "prefix_value.hpp"
+#include "quantity_cast.hpp"
+#include "unit_parser.hpp"
+#include <catch.hpp>
+
+#include <iostream>
+#include <sstream>
+#include <type_traits>
+#include <vector>
+
+SCENARIO("Exact prefixes beyond std::ratio") {
+  using units::PrefixValue;
+  GIVEN("prefixes that fit in a std::ratio") {
+    THEN("they have no exponent and are reduced as std::ratio") {
+      static_assert(PrefixValue{10, 1000} == PrefixValue{1, 100});
+      static_assert(PrefixValue{1, 1, -3} == PrefixValue{1, 1000});
+      static_assert(PrefixValue{1, 1, -3}.is_ratio());
+      static_assert(PrefixValue{37'854'118, 10'000'000} * PrefixValue{10} ==
+                    PrefixValue{18'927'059, 500'000});
+    }
+  }
+  GIVEN("products that overflow intmax_t") {
+    constexpr auto big = PrefixValue{404'685'642};
+    constexpr auto exa = PrefixValue{1'000'000'000'000'000'000};
+    THEN("their powers of ten go in the exponent") {
+      constexpr auto p = big * big * exa;
+      static_assert(!p.is_ratio());
+      static_assert(p.num == 163'770'468'840'952'164 && p.den == 1 &&
+                    p.exponent == 18);
+      static_assert(p / exa / big == big);
+      static_assert(PrefixValue{1} / exa / exa == PrefixValue{1, 1, -36});
+      static_assert(PrefixValue{1, 3} * PrefixValue{1, 1, -30} ==
+                    PrefixValue{1, 3, -30});
+    }
+    THEN("they are rounded once to the BaseType") {
+      using P = units::ExtendedPrefix<big * big * exa>;
+      REQUIRE(units::conversion_factor<P, double>() ==
+              163'770'468'840'952'164e18);
+      REQUIRE(units::conversion_factor<P, float>() ==
+              163'770'468'840'952'164e18f);
+      using Third = units::ExtendedPrefix<PrefixValue{1, 3, -300}>;
+      REQUIRE(units::conversion_factor<Third, double>() ==
+              3.3333333333333334e-301);
+    }
+  }
+}
+
+SCENARIO("Units with prefixes beyond std::ratio") {
+  using Gm_t = units::derived_t<units::giga, metres_t>;
+  using volume_t = units::derived_t<units::giga, acre_t, Gm_t>;
+  GIVEN("a chain of units whose prefix doesn't fit in a std::ratio") {
+    THEN("it's an ExtendedPrefix, folded at compile time") {
+      static_assert(units::is_extended_prefix(volume_t::prefix{}));
+      static_assert(volume_t::code.prefix ==
+                    units::PrefixValue{40'468'564'224, 1, 11});
+      static_assert(same_dimension(volume_t{}, metres3_t{}));
+      std::ostringstream os;
+      os << volume_t{};
+      REQUIRE(os.str() == "m³ x 4.04686e+10 x 10¹¹");
+    }
+    THEN("dividing it out gives a std::ratio again") {
+      using area_t = decltype(volume_t{} / Gm_t{});
+      static_assert(
+          std::is_same_v<area_t::prefix, std::ratio<4'046'856'422'400>>);
+    }
+    WHEN("Quantities of it are converted") {
+      const auto v = Quantity<volume_t>{2};
+      THEN("it's a single multiply by the rounded factor") {
+        REQUIRE(quantity_cast<Quantity<metres3_t>>(v).underlying_value() ==
+                2 * 40'468'564'224e11);
+        REQUIRE(v.underlying_value_no_prefix() == 2 * 40'468'564'224e11);
+        REQUIRE(v + Quantity<metres3_t>{1} ==
+                Quantity<metres3_t>{2 * 40'468'564'224e11 + 1});
+        const auto vs = std::vector<Quantity<volume_t>>(3, v);
+        auto out = std::vector<Quantity<metres3_t>>(3);
+        units::convert(vs, out);
+        REQUIRE(out[2].underlying_value() == 2 * 40'468'564'224e11);
+      }
+    }
+  }
+  GIVEN("units parsed at runtime") {
+    THEN("their prefixes are exact too") {
+      REQUIRE(units::parse_unit("Gm^9").code.prefix ==
+              units::PrefixValue{1, 1, 81});
+      REQUIRE(units::parse_unit("1e30/7 m").code.prefix ==
+              units::PrefixValue{1, 7, 30});
+      REQUIRE(units::format_unit(units::parse_unit("1e30/7 m").code) ==
+              "1e30/7 m");
+      REQUIRE(units::AnyQuantity{2.0, units::parse_unit("1e30 m").code}
+                  .prefix_exponent() == 30);
+    }
+  }
+}
+
+SCENARIO("Profiling conversions by extended prefixes", "[Profile]") {
+  using volume_t =
+      units::derived_t<units::giga, acre_t, units::giga, metres_t>;
+  GIVEN("Quantities with a prefix beyond std::ratio") {
+    const auto vs = std::vector<Quantity<volume_t>>(1'000'000,
+                                                    Quantity<volume_t>{1.5});
+    auto out = std::vector<Quantity<metres3_t>>(vs.size());
+    BENCHMARK("convert to m^3") { units::convert(vs, out); }
+    std::cout << out.back() << "\n";
+  }
+}
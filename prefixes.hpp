@@ -1,17 +1,57 @@
 #pragma once
 
-#include <boost/hana.hpp>
+#include "conversion_factor.hpp"
+#include "force_inline.hpp"
+#include <numeric>
 #include <ratio>
-//#include <boost/hana/experimental/printable.hpp>
-#include <tuple>
 #include <utility>
 
 template <class, class, class>
 class Quantity;
 
+namespace units {
+  namespace Impl {
+    /// The largest prefix both Prefix0 and Prefix1 are an integer multiple
+    /// of, e.g. a milli for metres and km, a nano for ns and seconds.
+    template <class Prefix0, class Prefix1>
+    using common_prefix =
+        typename std::ratio<std::gcd(Prefix0::num, Prefix1::num),
+                            std::lcm(Prefix0::den, Prefix1::den)>::type;
+
+    /// The prefix converting a value in UnitsFrom to one in UnitsTo, a
+    /// std::ratio if it fits in one, else an ExtendedPrefix. Worked out from
+    /// the exact prefixes, so e.g. acre per mm^2 can't overflow.
+    template <class UnitsFrom, class UnitsTo>
+    using prefix_divide_t =
+        prefix_type_t<UnitsFrom::code.prefix / UnitsTo::code.prefix>;
+
+    /// Units with the same dimensions as Units but a prefix of Prefix,
+    /// specialised for Dimensions in derived_dimensions_impl.hpp.
+    template <class Units, class Prefix>
+    struct with_prefix;
+
+    template <class Units, class Prefix>
+    using with_prefix_t = typename with_prefix<Units, Prefix>::type;
+
+    /// The result of rescale, a Quantity or a reference to one for each
+    /// argument. A plain aggregate rather than a std::tuple so that binding
+    /// it costs no function calls in unoptimised builds.
+    template <class First, class Second>
+    struct Rescaled {
+      First first;
+      Second second;
+    };
+  } // namespace Impl
+} // namespace units
+
+/** Bring a and b to the same prefix so their underlying values can be
+ * compared or added. Floating point Quantities are converted to the prefix of
+ * one of them. Integral (fixed point) Quantities are both converted to their
+ * common prefix, which is always an exact integer multiply, so 1 s + 1 ns is
+ * 1'000'000'001 ns rather than 1 s. */
 template <class Units0, class Units1, class BaseType, class Tag>
-constexpr auto rescale(const Quantity<Units0, BaseType, Tag>& a,
-                       const Quantity<Units1, BaseType, Tag>& b) {
+UNITS_INLINE constexpr auto rescale(const Quantity<Units0, BaseType, Tag>& a,
+                                    const Quantity<Units1, BaseType, Tag>& b) {
   static_assert(same_dimension(Units0{}, Units1{}));
   using T0 = Quantity<Units0, BaseType, Tag>;
   using T1 = Quantity<Units1, BaseType, Tag>;
@@ -19,20 +59,33 @@ constexpr auto rescale(const Quantity<Units0, BaseType, Tag>& a,
   using Ratio1 = typename Units1::prefix;
 
   if constexpr (std::is_same_v<Ratio0, Ratio1>) {
-    return std::tuple<const T0&, const T1&>{a, b};
-  } else if constexpr (Ratio0::num == 1 && Ratio0::den == 1) {
-    return std::tuple<const T0&, T0>{a, T0{b.underlying_value_no_prefix()}};
-  } else if constexpr (Ratio1::num == 1 && Ratio1::den == 1) {
-    return std::tuple<T1, const T1&>{T1{a.underlying_value_no_prefix()}, b};
+    return units::Impl::Rescaled<const T0&, const T1&>{a, b};
+  } else if constexpr (std::is_integral_v<BaseType>) {
+    using Common = units::Impl::common_prefix<Ratio0, Ratio1>;
+    using TC =
+        Quantity<units::Impl::with_prefix_t<Units0, Common>, BaseType, Tag>;
+    using Scale0 = std::ratio_divide<Ratio0, Common>;
+    using Scale1 = std::ratio_divide<Ratio1, Common>;
+    static_assert(Scale0::den == 1 && Scale1::den == 1);
+    return units::Impl::Rescaled<TC, TC>{
+        TC{units::scale_by<Scale0>(a.underlying_value())},
+        TC{units::scale_by<Scale1>(b.underlying_value())}};
+  } else if constexpr (std::is_same_v<Ratio0, std::ratio<1, 1>>) {
+    return units::Impl::Rescaled<const T0&, T0>{
+        a, T0{b.underlying_value_no_prefix()}};
+  } else if constexpr (std::is_same_v<Ratio1, std::ratio<1, 1>>) {
+    return units::Impl::Rescaled<T1, const T1&>{
+        T1{a.underlying_value_no_prefix()}, b};
   } else {
-    using Ratio2 = std::ratio_divide<Ratio1, Ratio0>;
-    return std::tuple<const T0&, T0>{a, T0{b.underlying_value()} * Ratio2::num /
-                                            Ratio2::den};
+    using Ratio2 = units::Impl::prefix_divide_t<Units1, Units0>;
+    return units::Impl::Rescaled<const T0&, T0>{
+        a, T0{units::scale_by<Ratio2>(b.underlying_value())}};
   }
 }
 
 namespace units {
   using nano = std::nano;
+  using micro = std::micro;
   using milli = std::milli;
   using centi = std::centi;
   using unity = std::ratio<1, 1>;
@@ -1,8 +1,10 @@
 #pragma once
 
 #include "base_dimensions.hpp"
+#include "conversion_factor.hpp"
 #include "derived_dimensions.hpp"
 #include "derived_dimensions_printing.hpp"
+#include "force_inline.hpp"
 #include "prefixes.hpp"
 
 #include <cmath>
@@ -66,6 +68,39 @@ constexpr auto is_quantity(Quantity<Units, BaseType, Tag>) {
   return std::true_type{};
 }
 
+namespace units {
+  /** True if Quantities with BaseTypes B0 and B1 can be combined, e.g. float
+   * storage with double arithmetic. They're promoted to promoted_base_t, the
+   * usual arithmetic conversions: the wider floating point type, or the
+   * floating point type if one is integral, or the wider integral type.
+   * Signed and unsigned integers don't mix, their common type (the unsigned
+   * one) can't hold the negative values. */
+  template <class B0, class B1>
+  inline constexpr bool mixed_base_types_v =
+      !std::is_same_v<B0, B1> && std::is_arithmetic_v<B0> &&
+      std::is_arithmetic_v<B1> &&
+      (std::is_floating_point_v<B0> || std::is_floating_point_v<B1> ||
+       std::is_signed_v<B0> == std::is_signed_v<B1>);
+
+  template <class B0, class B1>
+  using promoted_base_t = std::common_type_t<B0, B1>;
+
+  /// True if a B1 can be added to a B0 without narrowing it. Integers wider
+  /// than a floating point B0's mantissa, e.g. int64_t to double, would
+  /// round, so they don't.
+  template <class B0, class B1>
+  inline constexpr bool widens_to_v = [] {
+    if constexpr (mixed_base_types_v<B0, B1>) {
+      return std::is_same_v<promoted_base_t<B0, B1>, B0> &&
+             (!std::is_integral_v<B1> ||
+              std::numeric_limits<B1>::digits <=
+                  std::numeric_limits<B0>::digits);
+    } else {
+      return false;
+    }
+  }();
+} // namespace units
+
 template <class Units, class BaseType_ = double, class Tag_ = std::false_type>
 class Quantity {
 public:
@@ -77,14 +112,16 @@ public:
   // Extra ctor to stop narrowing warning errors on creation, these can occur
   // when an int is passed to the BaseType ctor when the basetype is double.
   template <class U, std::enable_if_t<std::is_arithmetic_v<U>>>
-  constexpr Quantity(U v) noexcept : _val(std::move(v)) {}
+  UNITS_INLINE constexpr Quantity(U v) noexcept : _val(static_cast<U&&>(v)) {}
 
-  constexpr Quantity(const BaseType& v) noexcept(
+  UNITS_INLINE constexpr Quantity(const BaseType& v) noexcept(
       std::is_nothrow_copy_constructible_v<BaseType>)
       : _val(v) {}
-  constexpr Quantity(BaseType&& v) noexcept(
+  // static_cast rather than std::move, which is a function call in
+  // unoptimised builds
+  UNITS_INLINE constexpr Quantity(BaseType&& v) noexcept(
       std::is_nothrow_move_constructible_v<BaseType>)
-      : _val(std::move(v)) {}
+      : _val(static_cast<BaseType&&>(v)) {}
   constexpr Quantity(Quantity&& o) noexcept(
       std::is_nothrow_move_constructible_v<BaseType>) = default;
   constexpr Quantity(const Quantity& o) noexcept(
@@ -97,77 +134,117 @@ public:
   // Casts to basetype, doesn't convert to SI etc.
   // Return reference to BaseType if Quantity is an lvalue (& qualified)
   // Return value of BaseType if Quantity is an rvalue (&& qualified)
-  constexpr const BaseType& underlying_value() const& noexcept { return _val; }
-  constexpr BaseType& underlying_value() & noexcept { return _val; }
-  constexpr BaseType underlying_value() const&& noexcept { return _val; }
-  constexpr BaseType underlying_value() && noexcept { return _val; }
+  UNITS_INLINE constexpr const BaseType& underlying_value() const& noexcept {
+    return _val;
+  }
+  UNITS_INLINE constexpr BaseType& underlying_value() & noexcept {
+    return _val;
+  }
+  UNITS_INLINE constexpr BaseType underlying_value() const&& noexcept {
+    return _val;
+  }
+  UNITS_INLINE constexpr BaseType underlying_value() && noexcept {
+    return _val;
+  }
 
-  constexpr explicit operator BaseType&() const& noexcept { return _val; }
-  constexpr explicit operator BaseType&() & noexcept { return _val; }
-  constexpr explicit operator BaseType() const&& noexcept { return _val; }
-  constexpr explicit operator BaseType() && noexcept { return _val; }
+  UNITS_INLINE constexpr explicit operator BaseType&() const& noexcept {
+    return _val;
+  }
+  UNITS_INLINE constexpr explicit operator BaseType&() & noexcept {
+    return _val;
+  }
+  UNITS_INLINE constexpr explicit operator BaseType() const&& noexcept {
+    return _val;
+  }
+  UNITS_INLINE constexpr explicit operator BaseType() && noexcept {
+    return _val;
+  }
 
   /// Returns a copy of _val, converted to a prefix of 1, so if the units of
   /// this type are km and the _val is 1, then this returns 1000 (in m)
-  constexpr BaseType underlying_value_no_prefix() const noexcept {
-    return _val * Prefix::num / Prefix::den;
+  UNITS_INLINE constexpr BaseType underlying_value_no_prefix() const noexcept {
+    return units::scale_by<Prefix>(_val);
   }
 
   // Only want to define this if BaseType is not bool, otherwise the casts to
   // BaseType would already define the bool operator
   template <class Proxy = BaseType,
             typename = std::enable_if_t<!std::is_same_v<Proxy, bool>>>
-  constexpr explicit operator bool() const noexcept {
+  UNITS_INLINE constexpr explicit operator bool() const noexcept {
     return static_cast<bool>(_val);
   }
 
   template <class Units1,
             typename = std::enable_if_t<same_dimension(Units{}, Units1{})>>
-  Quantity& operator+=(const Quantity<Units1, BaseType, Tag>& o) noexcept {
-    using Ratio1 = typename Units1::prefix;
-    using Ratio2 = std::ratio_divide<Ratio1, Prefix>;
-    _val += o.underlying_value() * Ratio2::num / Ratio2::den;
+  UNITS_INLINE Quantity&
+  operator+=(const Quantity<Units1, BaseType, Tag>& o) noexcept {
+    using Ratio2 = units::Impl::prefix_divide_t<Units1, Units>;
+    _val += units::scale_by<Ratio2>(o.underlying_value());
     return *this;
   }
 
   template <class Units1,
             typename = std::enable_if_t<same_dimension(Units{}, Units1{})>>
-  Quantity& operator-=(const Quantity<Units1, BaseType, Tag>& o) noexcept {
-    using Ratio1 = typename Units1::prefix;
-    using Ratio2 = std::ratio_divide<Ratio1, Prefix>;
-    _val -= o.underlying_value() * Ratio2::num / Ratio2::den;
+  UNITS_INLINE Quantity&
+  operator-=(const Quantity<Units1, BaseType, Tag>& o) noexcept {
+    using Ratio2 = units::Impl::prefix_divide_t<Units1, Units>;
+    _val -= units::scale_by<Ratio2>(o.underlying_value());
+    return *this;
+  }
+
+  /// Accumulate a narrower BaseType, e.g. float samples into a double sum.
+  /// The value is widened before it's scaled.
+  template <class Units1, class BaseType1,
+            typename = std::enable_if_t<
+                same_dimension(Units{}, Units1{}) &&
+                units::widens_to_v<BaseType, BaseType1>>>
+  UNITS_INLINE Quantity&
+  operator+=(const Quantity<Units1, BaseType1, Tag>& o) noexcept {
+    using Ratio2 = units::Impl::prefix_divide_t<Units1, Units>;
+    const auto v = static_cast<BaseType>(o.underlying_value());
+    _val += units::scale_by<Ratio2>(v);
+    return *this;
+  }
+
+  template <class Units1, class BaseType1,
+            typename = std::enable_if_t<
+                same_dimension(Units{}, Units1{}) &&
+                units::widens_to_v<BaseType, BaseType1>>>
+  UNITS_INLINE Quantity&
+  operator-=(const Quantity<Units1, BaseType1, Tag>& o) noexcept {
+    using Ratio2 = units::Impl::prefix_divide_t<Units1, Units>;
+    const auto v = static_cast<BaseType>(o.underlying_value());
+    _val -= units::scale_by<Ratio2>(v);
     return *this;
   }
 
   template <class Div, typename = std::enable_if_t<std::is_arithmetic_v<Div>>>
-  Quantity& operator/=(const Div& d) noexcept {
+  UNITS_INLINE Quantity& operator/=(const Div& d) noexcept {
     _val /= d;
     return *this;
   }
 
-  Quantity operator-() const noexcept { return Quantity{-_val}; }
+  UNITS_INLINE Quantity operator-() const noexcept { return Quantity{-_val}; }
 
   template <class Mult, typename = std::enable_if_t<std::is_arithmetic_v<Mult>>>
-  Quantity& operator*=(const Mult& d) noexcept {
+  UNITS_INLINE Quantity& operator*=(const Mult& d) noexcept {
     _val *= d;
     return *this;
   }
 
   template <class Units1,
             typename = std::enable_if_t<is_dimensionless(Units1{})>>
-  Quantity& operator/=(const Quantity<Units1, BaseType, Tag>& d) noexcept {
-    using Ratio1 = typename Units1::prefix;
-    using Ratio2 = std::ratio_divide<Ratio1, Prefix>;
-    _val /= (d.underlying_value() * Ratio2::num / Ratio2::den);
+  UNITS_INLINE Quantity&
+  operator/=(const Quantity<Units1, BaseType, Tag>& d) noexcept {
+    _val /= d.underlying_value_no_prefix();
     return *this;
   }
 
   template <class Units1,
             typename = std::enable_if_t<is_dimensionless(Units1{})>>
-  Quantity& operator*=(const Quantity<Units1, BaseType, Tag>& d) noexcept {
-    using Ratio1 = typename Units1::prefix;
-    using Ratio2 = std::ratio_divide<Ratio1, Prefix>;
-    _val *= d.underlying_value() * Ratio2::num / Ratio2::den;
+  UNITS_INLINE Quantity&
+  operator*=(const Quantity<Units1, BaseType, Tag>& d) noexcept {
+    _val *= d.underlying_value_no_prefix();
     return *this;
   }
 
@@ -190,7 +267,16 @@ template <class Units, class BaseType, class Tag>
 std::ostream& operator<<(std::ostream& os,
                          const Quantity<Units, BaseType, Tag>& q) {
   auto u = Units{};
-  os << q.underlying_value() << " " << u;
+  // C++20 deletes printing wide characters to a narrow stream, print their
+  // numeric value instead
+  if constexpr (std::is_same_v<BaseType, wchar_t> ||
+                std::is_same_v<BaseType, char16_t> ||
+                std::is_same_v<BaseType, char32_t>) {
+    os << static_cast<std::uint_least32_t>(q.underlying_value());
+  } else {
+    os << q.underlying_value();
+  }
+  os << " " << u;
   return os;
 }
 
@@ -221,14 +307,15 @@ constexpr auto make_names_from_dimension([[maybe_unused]] Dimension) {
 }
 
 template <bool DimensionsBalance, class lhs, class rhs>
-constexpr auto use_dimension_names() {
+consteval void use_dimension_names() {
   static_assert(DimensionsBalance);
 }
 
 /// Equality
 template <class Units0, class Units1, class BaseType, class Tag0, class Tag1>
-constexpr auto operator==(const Quantity<Units0, BaseType, Tag0>& a,
-                          const Quantity<Units1, BaseType, Tag1>& b) {
+UNITS_INLINE constexpr auto
+operator==(const Quantity<Units0, BaseType, Tag0>& a,
+           const Quantity<Units1, BaseType, Tag1>& b) {
   use_dimension_names<same_dimension(Units0{}, Units1{}),
                       decltype(make_names_from_dimension(Units0{})),
                       decltype(make_names_from_dimension(Units1{}))>();
@@ -240,16 +327,18 @@ constexpr auto operator==(const Quantity<Units0, BaseType, Tag0>& a,
 /// Inequality
 template <class Units0, class Units1, class BaseType, class Tag,
           typename = std::enable_if_t<same_dimension(Units0{}, Units1{})>>
-constexpr auto operator!=(const Quantity<Units0, BaseType, Tag>& a,
-                          const Quantity<Units1, BaseType, Tag>& b) {
+UNITS_INLINE constexpr auto
+operator!=(const Quantity<Units0, BaseType, Tag>& a,
+           const Quantity<Units1, BaseType, Tag>& b) {
   return !(a == b);
 }
 
 /// Less than
 template <class Units0, class Units1, class BaseType, class Tag0, class Tag1,
           typename = std::enable_if_t<same_dimension(Units0{}, Units1{})>>
-constexpr auto operator<(const Quantity<Units0, BaseType, Tag0>& a,
-                         const Quantity<Units1, BaseType, Tag1>& b) {
+UNITS_INLINE constexpr auto
+operator<(const Quantity<Units0, BaseType, Tag0>& a,
+          const Quantity<Units1, BaseType, Tag1>& b) {
   use_dimension_names<same_dimension(Units0{}, Units1{}),
                       decltype(make_names_from_dimension(Units0{})),
                       decltype(make_names_from_dimension(Units1{}))>();
@@ -261,8 +350,9 @@ constexpr auto operator<(const Quantity<Units0, BaseType, Tag0>& a,
 /// Less than or equal to
 template <class Units0, class Units1, class BaseType, class Tag0, class Tag1,
           typename = std::enable_if_t<same_dimension(Units0{}, Units1{})>>
-constexpr auto operator<=(const Quantity<Units0, BaseType, Tag0>& a,
-                          const Quantity<Units1, BaseType, Tag1>& b) {
+UNITS_INLINE constexpr auto
+operator<=(const Quantity<Units0, BaseType, Tag0>& a,
+           const Quantity<Units1, BaseType, Tag1>& b) {
   use_dimension_names<same_dimension(Units0{}, Units1{}),
                       decltype(make_names_from_dimension(Units0{})),
                       decltype(make_names_from_dimension(Units1{}))>();
@@ -274,8 +364,9 @@ constexpr auto operator<=(const Quantity<Units0, BaseType, Tag0>& a,
 /// Greater than
 template <class Units0, class Units1, class BaseType, class Tag0, class Tag1,
           typename = std::enable_if_t<same_dimension(Units0{}, Units1{})>>
-constexpr auto operator>(const Quantity<Units0, BaseType, Tag0>& a,
-                         const Quantity<Units1, BaseType, Tag1>& b) {
+UNITS_INLINE constexpr auto
+operator>(const Quantity<Units0, BaseType, Tag0>& a,
+          const Quantity<Units1, BaseType, Tag1>& b) {
   use_dimension_names<same_dimension(Units0{}, Units1{}),
                       decltype(make_names_from_dimension(Units0{})),
                       decltype(make_names_from_dimension(Units1{}))>();
@@ -286,8 +377,9 @@ constexpr auto operator>(const Quantity<Units0, BaseType, Tag0>& a,
 
 /// Greater than or equal
 template <class Units0, class Units1, class BaseType, class Tag0, class Tag1>
-constexpr auto operator>=(const Quantity<Units0, BaseType, Tag0>& a,
-                          const Quantity<Units1, BaseType, Tag1>& b) {
+UNITS_INLINE constexpr auto
+operator>=(const Quantity<Units0, BaseType, Tag0>& a,
+           const Quantity<Units1, BaseType, Tag1>& b) {
   use_dimension_names<same_dimension(Units0{}, Units1{}),
                       decltype(make_names_from_dimension(Units0{})),
                       decltype(make_names_from_dimension(Units1{}))>();
@@ -300,9 +392,10 @@ constexpr auto operator>=(const Quantity<Units0, BaseType, Tag0>& a,
 /// Within a tolerance
 template <class Units0, class Units1, class Units2, class BaseType, class Tag0,
           class Tag1, class Tag2>
-constexpr auto within(const Quantity<Units0, BaseType, Tag0>& a,
-                      const Quantity<Units1, BaseType, Tag1>& b,
-                      const Quantity<Units2, BaseType, Tag2>& tol) {
+UNITS_INLINE constexpr auto
+within(const Quantity<Units0, BaseType, Tag0>& a,
+       const Quantity<Units1, BaseType, Tag1>& b,
+       const Quantity<Units2, BaseType, Tag2>& tol) {
   use_dimension_names<same_dimension(Units0{}, Units1{}),
                       decltype(make_names_from_dimension(Units0{})),
                       decltype(make_names_from_dimension(Units1{}))>();
@@ -316,7 +409,8 @@ constexpr auto within(const Quantity<Units0, BaseType, Tag0>& a,
   assert(tol.underlying_value() >= 0);
   const auto delta = a - b;
   using Delta = decltype(delta);
-  return Delta{std::abs(delta.underlying_value())} <= tol;
+  const auto d = delta.underlying_value();
+  return Delta{d < 0 ? -d : d} <= tol;
 }
 
 // ************************************************************************* /
@@ -325,8 +419,9 @@ constexpr auto within(const Quantity<Units0, BaseType, Tag0>& a,
 
 /// Addition
 template <class Units0, class Units1, class BaseType, class Tag0, class Tag1>
-constexpr auto operator+(const Quantity<Units0, BaseType, Tag0>& a,
-                         const Quantity<Units1, BaseType, Tag1>& b) {
+UNITS_INLINE constexpr auto
+operator+(const Quantity<Units0, BaseType, Tag0>& a,
+          const Quantity<Units1, BaseType, Tag1>& b) {
   use_dimension_names<same_dimension(Units0{}, Units1{}),
                       decltype(make_names_from_dimension(Units0{})),
                       decltype(make_names_from_dimension(Units1{}))>();
@@ -339,8 +434,9 @@ constexpr auto operator+(const Quantity<Units0, BaseType, Tag0>& a,
 
 /// Subtraction
 template <class Units0, class Units1, class BaseType, class Tag0, class Tag1>
-constexpr auto operator-(const Quantity<Units0, BaseType, Tag0>& a,
-                         const Quantity<Units1, BaseType, Tag1>& b) {
+UNITS_INLINE constexpr auto
+operator-(const Quantity<Units0, BaseType, Tag0>& a,
+          const Quantity<Units1, BaseType, Tag1>& b) {
   use_dimension_names<same_dimension(Units0{}, Units1{}),
                       decltype(make_names_from_dimension(Units0{})),
                       decltype(make_names_from_dimension(Units1{}))>();
@@ -358,30 +454,51 @@ constexpr auto operator-(const Quantity<Units0, BaseType, Tag0>& a,
 /// Division, creates a new Quantity Type with the correct dimensions and a
 /// prefix of unity (1). For example:
 ///
+/// Integral (fixed point) Quantities multiply the numerator by the num of
+/// the quotient of the prefixes, and keep its den as the prefix, e.g.
+/// 5 km / 2000 m -> 5 * 1000 / 2000 = 2 and 1500 mm / 2 s -> 750 with a
+/// prefix of 1e-3, so neither side is truncated before dividing.
 template <class Units0, class Units1, class BaseType, class Tag0, class Tag1>
-constexpr auto operator/(const Quantity<Units0, BaseType, Tag0>& a,
-                         const Quantity<Units1, BaseType, Tag1>& b) {
+UNITS_INLINE constexpr auto
+operator/(const Quantity<Units0, BaseType, Tag0>& a,
+          const Quantity<Units1, BaseType, Tag1>& b) {
   static_assert(tags_compatible_multiplication<Tag0, Tag1>());
-  using Units = units::derived_unity_t<decltype(Units0{} / Units1{})>;
-  auto a_val = a.underlying_value_no_prefix();
-  auto b_val = b.underlying_value_no_prefix();
-  if constexpr (std::is_same_v<Tag0, std::false_type>) {
-    return Quantity<Units, BaseType, Tag1>{a_val / b_val};
+  using Tag = std::conditional_t<std::is_same_v<Tag0, std::false_type>, Tag1,
+                                 Tag0>;
+  using Quotient = decltype(Units0{} / Units1{});
+  if constexpr (std::is_integral_v<BaseType>) {
+    // integral BaseTypes have std::ratio prefixes
+    using Ratio =
+        std::ratio_divide<typename Units0::prefix, typename Units1::prefix>;
+    using Units =
+        units::Impl::with_prefix_t<Quotient, std::ratio<1, Ratio::den>>;
+    const auto a_val = a.underlying_value() * static_cast<BaseType>(Ratio::num);
+    return Quantity<Units, BaseType, Tag>{a_val / b.underlying_value()};
   } else {
-    return Quantity<Units, BaseType, Tag0>{a_val / b_val};
+    using Units = units::derived_unity_t<Quotient>;
+    return Quantity<Units, BaseType, Tag>{a.underlying_value_no_prefix() /
+                                          b.underlying_value_no_prefix()};
   }
 }
 
 // convert types bases dimensions to their multiple, then return
 // a variable with a prefix of unity
 // e.g. 1 km * 2 km  ->  1,000 * 2,000 m^2 = 2,000,000 m^2
+// Integral (fixed point) Quantities keep the product of the prefixes instead,
+// e.g. 2 mm * 3 mm -> 6 mm^2 with a prefix of 1e-6
 template <class Units0, class Units1, class BaseType, class Tag0, class Tag1>
-constexpr auto operator*(const Quantity<Units0, BaseType, Tag0>& a,
-                         const Quantity<Units1, BaseType, Tag1>& b) {
+UNITS_INLINE constexpr auto
+operator*(const Quantity<Units0, BaseType, Tag0>& a,
+          const Quantity<Units1, BaseType, Tag1>& b) {
   static_assert(tags_compatible_multiplication<Tag0, Tag1>());
-  using Units = units::derived_unity_t<decltype(Units0{} * Units1{})>;
-  auto a_val = a.underlying_value_no_prefix();
-  auto b_val = b.underlying_value_no_prefix();
+  constexpr auto fixed_point = std::is_integral_v<BaseType>;
+  using Units =
+      std::conditional_t<fixed_point, decltype(Units0{} * Units1{}),
+                         units::derived_unity_t<decltype(Units0{} * Units1{})>>;
+  auto a_val =
+      fixed_point ? a.underlying_value() : a.underlying_value_no_prefix();
+  auto b_val =
+      fixed_point ? b.underlying_value() : b.underlying_value_no_prefix();
   if constexpr (std::is_same_v<Tag0, std::false_type>) {
     return Quantity<Units, BaseType, Tag1>{a_val * b_val};
   } else {
@@ -389,36 +506,158 @@ constexpr auto operator*(const Quantity<Units0, BaseType, Tag0>& a,
   }
 }
 
+// ************************************************************************* /
+//    Mixed BaseTypes, both Quantities are promoted to the common BaseType   /
+//    (see units::promoted_base_t) then combined as above, e.g. float        /
+//    metres times double Newtons are double Joules.                         /
+// ************************************************************************* /
+
+namespace units::Impl {
+  template <class BaseType, class Units, class BaseType0, class Tag>
+  UNITS_INLINE constexpr Quantity<Units, BaseType, Tag>
+  promote(const Quantity<Units, BaseType0, Tag>& q) noexcept {
+    return Quantity<Units, BaseType, Tag>{
+        static_cast<BaseType>(q.underlying_value())};
+  }
+} // namespace units::Impl
+
+template <class Units0, class Units1, class BaseType0, class BaseType1,
+          class Tag0, class Tag1,
+          typename = std::enable_if_t<
+              units::mixed_base_types_v<BaseType0, BaseType1>>>
+UNITS_INLINE constexpr auto
+operator+(const Quantity<Units0, BaseType0, Tag0>& a,
+          const Quantity<Units1, BaseType1, Tag1>& b) {
+  using BaseType = units::promoted_base_t<BaseType0, BaseType1>;
+  return units::Impl::promote<BaseType>(a) + units::Impl::promote<BaseType>(b);
+}
+
+template <class Units0, class Units1, class BaseType0, class BaseType1,
+          class Tag0, class Tag1,
+          typename = std::enable_if_t<
+              units::mixed_base_types_v<BaseType0, BaseType1>>>
+UNITS_INLINE constexpr auto
+operator-(const Quantity<Units0, BaseType0, Tag0>& a,
+          const Quantity<Units1, BaseType1, Tag1>& b) {
+  using BaseType = units::promoted_base_t<BaseType0, BaseType1>;
+  return units::Impl::promote<BaseType>(a) - units::Impl::promote<BaseType>(b);
+}
+
+template <class Units0, class Units1, class BaseType0, class BaseType1,
+          class Tag0, class Tag1,
+          typename = std::enable_if_t<
+              units::mixed_base_types_v<BaseType0, BaseType1>>>
+UNITS_INLINE constexpr auto
+operator*(const Quantity<Units0, BaseType0, Tag0>& a,
+          const Quantity<Units1, BaseType1, Tag1>& b) {
+  using BaseType = units::promoted_base_t<BaseType0, BaseType1>;
+  return units::Impl::promote<BaseType>(a) * units::Impl::promote<BaseType>(b);
+}
+
+template <class Units0, class Units1, class BaseType0, class BaseType1,
+          class Tag0, class Tag1,
+          typename = std::enable_if_t<
+              units::mixed_base_types_v<BaseType0, BaseType1>>>
+UNITS_INLINE constexpr auto
+operator/(const Quantity<Units0, BaseType0, Tag0>& a,
+          const Quantity<Units1, BaseType1, Tag1>& b) {
+  using BaseType = units::promoted_base_t<BaseType0, BaseType1>;
+  return units::Impl::promote<BaseType>(a) / units::Impl::promote<BaseType>(b);
+}
+
+template <class Units0, class Units1, class BaseType0, class BaseType1,
+          class Tag0, class Tag1,
+          typename = std::enable_if_t<
+              units::mixed_base_types_v<BaseType0, BaseType1>>>
+UNITS_INLINE constexpr auto
+operator==(const Quantity<Units0, BaseType0, Tag0>& a,
+           const Quantity<Units1, BaseType1, Tag1>& b) {
+  using BaseType = units::promoted_base_t<BaseType0, BaseType1>;
+  return units::Impl::promote<BaseType>(a) == units::Impl::promote<BaseType>(b);
+}
+
+template <class Units0, class Units1, class BaseType0, class BaseType1,
+          class Tag0, class Tag1,
+          typename = std::enable_if_t<
+              units::mixed_base_types_v<BaseType0, BaseType1>>>
+UNITS_INLINE constexpr auto
+operator!=(const Quantity<Units0, BaseType0, Tag0>& a,
+           const Quantity<Units1, BaseType1, Tag1>& b) {
+  return !(a == b);
+}
+
+template <class Units0, class Units1, class BaseType0, class BaseType1,
+          class Tag0, class Tag1,
+          typename = std::enable_if_t<
+              units::mixed_base_types_v<BaseType0, BaseType1>>>
+UNITS_INLINE constexpr auto
+operator<(const Quantity<Units0, BaseType0, Tag0>& a,
+          const Quantity<Units1, BaseType1, Tag1>& b) {
+  using BaseType = units::promoted_base_t<BaseType0, BaseType1>;
+  return units::Impl::promote<BaseType>(a) < units::Impl::promote<BaseType>(b);
+}
+
+template <class Units0, class Units1, class BaseType0, class BaseType1,
+          class Tag0, class Tag1,
+          typename = std::enable_if_t<
+              units::mixed_base_types_v<BaseType0, BaseType1>>>
+UNITS_INLINE constexpr auto
+operator<=(const Quantity<Units0, BaseType0, Tag0>& a,
+           const Quantity<Units1, BaseType1, Tag1>& b) {
+  using BaseType = units::promoted_base_t<BaseType0, BaseType1>;
+  return units::Impl::promote<BaseType>(a) <= units::Impl::promote<BaseType>(b);
+}
+
+template <class Units0, class Units1, class BaseType0, class BaseType1,
+          class Tag0, class Tag1,
+          typename = std::enable_if_t<
+              units::mixed_base_types_v<BaseType0, BaseType1>>>
+UNITS_INLINE constexpr auto
+operator>(const Quantity<Units0, BaseType0, Tag0>& a,
+          const Quantity<Units1, BaseType1, Tag1>& b) {
+  return b < a;
+}
+
+template <class Units0, class Units1, class BaseType0, class BaseType1,
+          class Tag0, class Tag1,
+          typename = std::enable_if_t<
+              units::mixed_base_types_v<BaseType0, BaseType1>>>
+UNITS_INLINE constexpr auto
+operator>=(const Quantity<Units0, BaseType0, Tag0>& a,
+           const Quantity<Units1, BaseType1, Tag1>& b) {
+  return b <= a;
+}
+
 // ************************************************************************* /
 //    Multiply and Divide with with fundamental types                        /
 // ************************************************************************* /
 
 template <class Units, class BaseType, class Tag, class Div,
           typename = std::enable_if_t<std::is_arithmetic_v<Div>>>
-constexpr auto operator/(const Quantity<Units, BaseType, Tag>& a,
-                         const Div& b) {
+UNITS_INLINE constexpr auto
+operator/(const Quantity<Units, BaseType, Tag>& a, const Div& b) {
   return Quantity<Units, BaseType, Tag>{a.underlying_value() / b};
 }
 
 template <class Units, class BaseType, class Tag, class Div,
           typename = std::enable_if_t<std::is_integral_v<Div>>>
-constexpr auto operator/(const Div& b,
-                         const Quantity<Units, BaseType, Tag>& a) {
+UNITS_INLINE constexpr auto
+operator/(const Div& b, const Quantity<Units, BaseType, Tag>& a) {
   using InvUnits = decltype(invert(Units{}));
   return Quantity<InvUnits, BaseType, Tag>{b / a.underlying_value()};
 }
 
 template <class Units, class BaseType, class Tag, class Mult,
           typename = std::enable_if_t<std::is_arithmetic_v<Mult>>>
-constexpr auto operator*(const Quantity<Units, BaseType, Tag>& a,
-                         const Mult& b) {
+UNITS_INLINE constexpr auto
+operator*(const Quantity<Units, BaseType, Tag>& a, const Mult& b) {
   return Quantity<Units, BaseType, Tag>{a.underlying_value() * b};
 }
 
 template <class Units, class BaseType, class Tag, class Mult,
           typename = std::enable_if_t<std::is_arithmetic_v<Mult>>>
-constexpr auto operator*(const Mult& b,
-                         const Quantity<Units, BaseType, Tag>& a) {
+UNITS_INLINE constexpr auto
+operator*(const Mult& b, const Quantity<Units, BaseType, Tag>& a) {
   return Quantity<Units, BaseType, Tag>{a.underlying_value() * b};
 }
 
@@ -429,48 +668,48 @@ constexpr auto operator*(const Mult& b,
 template <class Units, class BaseType, class Tag, class Rhs,
           typename = std::enable_if_t<std::is_arithmetic_v<Rhs>>,
           typename = std::enable_if_t<is_dimensionless(Units{})>>
-constexpr bool operator>(const Quantity<Units, BaseType, Tag>& a,
-                         const Rhs& comp) {
+UNITS_INLINE constexpr bool
+operator>(const Quantity<Units, BaseType, Tag>& a, const Rhs& comp) {
   return a.underlying_value_no_prefix() > comp;
 }
 
 template <class Units, class BaseType, class Tag, class Rhs,
           typename = std::enable_if_t<std::is_arithmetic_v<Rhs>>,
           typename = std::enable_if_t<is_dimensionless(Units{})>>
-constexpr bool operator>=(const Quantity<Units, BaseType, Tag>& a,
-                          const Rhs& comp) {
+UNITS_INLINE constexpr bool
+operator>=(const Quantity<Units, BaseType, Tag>& a, const Rhs& comp) {
   return a.underlying_value_no_prefix() >= comp;
 }
 
 template <class Units, class BaseType, class Tag, class Rhs,
           typename = std::enable_if_t<std::is_arithmetic_v<Rhs>>,
           typename = std::enable_if_t<is_dimensionless(Units{})>>
-constexpr bool operator<(const Quantity<Units, BaseType, Tag>& a,
-                         const Rhs& comp) {
+UNITS_INLINE constexpr bool
+operator<(const Quantity<Units, BaseType, Tag>& a, const Rhs& comp) {
   return a.underlying_value_no_prefix() < comp;
 }
 
 template <class Units, class BaseType, class Tag, class Rhs,
           typename = std::enable_if_t<std::is_arithmetic_v<Rhs>>,
           typename = std::enable_if_t<is_dimensionless(Units{})>>
-constexpr bool operator<=(const Quantity<Units, BaseType, Tag>& a,
-                          const Rhs& comp) {
+UNITS_INLINE constexpr bool
+operator<=(const Quantity<Units, BaseType, Tag>& a, const Rhs& comp) {
   return a.underlying_value_no_prefix() <= comp;
 }
 
 template <class Units, class BaseType, class Tag, class Rhs,
           typename = std::enable_if_t<std::is_arithmetic_v<Rhs>>,
           typename = std::enable_if_t<is_dimensionless(Units{})>>
-constexpr bool operator==(const Quantity<Units, BaseType, Tag>& a,
-                          const Rhs& comp) {
+UNITS_INLINE constexpr bool
+operator==(const Quantity<Units, BaseType, Tag>& a, const Rhs& comp) {
   return a.underlying_value_no_prefix() == comp;
 }
 
 template <class Units, class BaseType, class Tag, class Rhs,
           typename = std::enable_if_t<std::is_arithmetic_v<Rhs>>,
           typename = std::enable_if_t<is_dimensionless(Units{})>>
-constexpr bool operator!=(const Quantity<Units, BaseType, Tag>& a,
-                          const Rhs& comp) {
+UNITS_INLINE constexpr bool
+operator!=(const Quantity<Units, BaseType, Tag>& a, const Rhs& comp) {
   return !(a == comp);
 }
 
@@ -481,47 +720,47 @@ constexpr bool operator!=(const Quantity<Units, BaseType, Tag>& a,
 template <class Units, class BaseType, class Tag, class Rhs,
           typename = std::enable_if_t<std::is_arithmetic_v<Rhs>>,
           typename = std::enable_if_t<is_dimensionless(Units{})>>
-constexpr bool operator>(const Rhs& comp,
-                         const Quantity<Units, BaseType, Tag>& a) {
+UNITS_INLINE constexpr bool
+operator>(const Rhs& comp, const Quantity<Units, BaseType, Tag>& a) {
   return comp > a.underlying_value_no_prefix();
 }
 
 template <class Units, class BaseType, class Tag, class Rhs,
           typename = std::enable_if_t<std::is_arithmetic_v<Rhs>>,
           typename = std::enable_if_t<is_dimensionless(Units{})>>
-constexpr bool operator>=(const Rhs& comp,
-                          const Quantity<Units, BaseType, Tag>& a) {
+UNITS_INLINE constexpr bool
+operator>=(const Rhs& comp, const Quantity<Units, BaseType, Tag>& a) {
   return comp >= a.underlying_value_no_prefix();
 }
 
 template <class Units, class BaseType, class Tag, class Rhs,
           typename = std::enable_if_t<std::is_arithmetic_v<Rhs>>,
           typename = std::enable_if_t<is_dimensionless(Units{})>>
-constexpr bool operator<(const Rhs& comp,
-                         const Quantity<Units, BaseType, Tag>& a) {
+UNITS_INLINE constexpr bool
+operator<(const Rhs& comp, const Quantity<Units, BaseType, Tag>& a) {
   return comp < a.underlying_value_no_prefix();
 }
 
 template <class Units, class BaseType, class Tag, class Rhs,
           typename = std::enable_if_t<std::is_arithmetic_v<Rhs>>,
           typename = std::enable_if_t<is_dimensionless(Units{})>>
-constexpr bool operator<=(const Rhs& comp,
-                          const Quantity<Units, BaseType, Tag>& a) {
+UNITS_INLINE constexpr bool
+operator<=(const Rhs& comp, const Quantity<Units, BaseType, Tag>& a) {
   return comp <= a.underlying_value_no_prefix();
 }
 
 template <class Units, class BaseType, class Tag, class Rhs,
           typename = std::enable_if_t<std::is_arithmetic_v<Rhs>>,
           typename = std::enable_if_t<is_dimensionless(Units{})>>
-constexpr bool operator==(const Rhs& comp,
-                          const Quantity<Units, BaseType, Tag>& a) {
+UNITS_INLINE constexpr bool
+operator==(const Rhs& comp, const Quantity<Units, BaseType, Tag>& a) {
   return comp == a.underlying_value_no_prefix();
 }
 
 template <class Units, class BaseType, class Tag, class Rhs,
           typename = std::enable_if_t<std::is_arithmetic_v<Rhs>>,
           typename = std::enable_if_t<is_dimensionless(Units{})>>
-constexpr bool operator!=(const Rhs& comp,
-                          const Quantity<Units, BaseType, Tag>& a) {
+UNITS_INLINE constexpr bool
+operator!=(const Rhs& comp, const Quantity<Units, BaseType, Tag>& a) {
   return !(comp == a);
 }
@@ -0,0 +1,136 @@
+#pragma once
+
+#include "conversion_factor.hpp"
+#include "quantity.hpp"
+
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <ratio>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+// ************************************************************************* /
+//    Explicit conversions between Quantities of the same dimensions, with   /
+//    a different prefix and/or BaseType. With an integral BaseType the      /
+//    prefix is a fixed point scale, e.g. Quantity<nanoseconds_t, int64_t>   /
+//    counts whole nanoseconds, and the conversion between two of them is an /
+//    exact integer multiply (to a finer prefix) or divide (to a coarser     /
+//    one) worked out at compile time.                                       /
+// ************************************************************************* /
+
+namespace units {
+  namespace Impl {
+    template <class Q>
+    struct quantity_traits;
+
+    template <class Units_, class BaseType_, class Tag_>
+    struct quantity_traits<Quantity<Units_, BaseType_, Tag_>> {
+      using Units = Units_;
+      using BaseType = BaseType_;
+      using Tag = Tag_;
+    };
+
+    template <class To, class Units, class Tag>
+    constexpr void check_cast() {
+      static_assert(is_quantity(To{}), "can only cast to a Quantity");
+      using ToUnits = typename quantity_traits<To>::Units;
+      use_dimension_names<same_dimension(Units{}, ToUnits{}),
+                          decltype(make_names_from_dimension(Units{})),
+                          decltype(make_names_from_dimension(ToUnits{}))>();
+      static_assert(std::is_same_v<Tag, typename To::Tag>);
+    }
+
+    /// True if v can be converted to T without overflowing.
+    template <class T, class V>
+    constexpr bool in_range(V v) noexcept {
+      if constexpr (std::is_integral_v<V> && std::is_integral_v<T>) {
+        return std::in_range<T>(v);
+      } else if constexpr (std::is_floating_point_v<V> &&
+                           std::is_integral_v<T>) {
+        // max() may round up to a power of two, which is then out of range,
+        // adding 1 makes the bound exact when it does not. Also false for NaN
+        using limits = std::numeric_limits<T>;
+        constexpr auto min = static_cast<V>(limits::lowest());
+        constexpr auto max = static_cast<V>(limits::max()) + 1;
+        return v >= min && v < max;
+      } else {
+        return std::isinf(v) ||
+               std::abs(v) <= static_cast<V>(std::numeric_limits<T>::max());
+      }
+    }
+
+    /// The factor converting a value in units of From to units of To.
+    template <class From, class To>
+    using cast_ratio =
+        prefix_divide_t<typename quantity_traits<From>::Units,
+                        typename quantity_traits<To>::Units>;
+  } // namespace Impl
+
+  /** As scale_by, but throws std::overflow_error rather than wrapping (for
+   * integral BaseTypes, if v * num does not fit in BaseType) or returning an
+   * infinity (for floating point ones). */
+  template <class Ratio, class BaseType>
+  constexpr BaseType checked_scale_by(const BaseType& v) {
+    if constexpr (std::is_floating_point_v<BaseType>) {
+      const auto result = scale_by<Ratio>(v);
+      if (std::isinf(result) && !std::isinf(v)) {
+        throw std::overflow_error("units::checked_scale_by: the result "
+                                  "overflows the BaseType");
+      }
+      return result;
+    } else {
+      using Wide = std::common_type_t<BaseType, std::intmax_t>;
+      constexpr auto num = static_cast<Wide>(Ratio::num);
+      constexpr auto max = std::numeric_limits<BaseType>::max() / num;
+      constexpr auto min = std::numeric_limits<BaseType>::lowest() / num;
+      if (static_cast<Wide>(v) > max || static_cast<Wide>(v) < min) {
+        throw std::overflow_error("units::checked_scale_by: the result "
+                                  "overflows the BaseType");
+      }
+      return scale_by<Ratio>(v);
+    }
+  }
+
+  /** Convert q to the Quantity To, which must have the same dimensions and
+   * tag, e.g.
+   *   quantity_cast<Quantity<nanoseconds_t, std::int64_t>>(seconds{1.5})
+   * The value is scaled in the wider of the two BaseTypes then converted to
+   * To's BaseType, so converting to a coarser integral prefix, or from a
+   * floating point to an integral BaseType, truncates towards zero. Overflow
+   * is not checked, see checked_quantity_cast. */
+  template <class To, class Units, class BaseType, class Tag>
+  constexpr To
+  quantity_cast(const Quantity<Units, BaseType, Tag>& q) noexcept {
+    Impl::check_cast<To, Units, Tag>();
+    using From = Quantity<Units, BaseType, Tag>;
+    using Common = std::common_type_t<BaseType, typename To::BaseType>;
+    using Ratio = Impl::cast_ratio<From, To>;
+    const auto v = static_cast<Common>(q.underlying_value());
+    return To{static_cast<typename To::BaseType>(scale_by<Ratio>(v))};
+  }
+
+  /** As quantity_cast, but throws std::overflow_error if the value does not
+   * fit in To's BaseType, either while scaling or when converting between
+   * BaseTypes. */
+  template <class To, class Units, class BaseType, class Tag>
+  constexpr To
+  checked_quantity_cast(const Quantity<Units, BaseType, Tag>& q) {
+    Impl::check_cast<To, Units, Tag>();
+    using From = Quantity<Units, BaseType, Tag>;
+    using ToBaseType = typename To::BaseType;
+    using Common = std::common_type_t<BaseType, ToBaseType>;
+    using Ratio = Impl::cast_ratio<From, To>;
+    const auto v =
+        checked_scale_by<Ratio>(static_cast<Common>(q.underlying_value()));
+    if constexpr (!std::is_same_v<Common, ToBaseType>) {
+      // only a narrowing conversion can overflow, e.g. double to int64_t
+      if (!Impl::in_range<ToBaseType>(v)) {
+        throw std::overflow_error("units::checked_quantity_cast: the value "
+                                  "does not fit in the BaseType");
+      }
+    }
+    return To{static_cast<ToBaseType>(v)};
+  }
+} // namespace units
@@ -0,0 +1,79 @@
+#include "common_quantities.hpp"
+#include "quantity_cast.hpp"
+#include <catch.hpp>
+
+#include <cstdint>
+#include <stdexcept>
+
+SCENARIO("Testing fixed point (integral) Quantities") {
+  using ns_i64 = Quantity<nanoseconds_t, std::int64_t>;
+  using s_i64 = Quantity<seconds_t, std::int64_t>;
+  using mm_i64 = Quantity<mm_t, std::int64_t>;
+  using m_i64 = Quantity<metres_t, std::int64_t>;
+  using km_i64 = Quantity<km_t, std::int64_t>;
+
+  GIVEN("integer timestamps in nanoseconds and seconds") {
+    THEN("they take half the space of a double and are not rescaled") {
+      static_assert(sizeof(Quantity<mm_t, std::int32_t>) == sizeof(float));
+      REQUIRE(ns_i64{1}.underlying_value() == 1);
+    }
+    THEN("mixed prefix addition is exact, in the finer prefix") {
+      auto t = s_i64{1} + ns_i64{1};
+      static_assert(std::is_same_v<decltype(t), ns_i64>);
+      REQUIRE(t.underlying_value() == 1'000'000'001);
+      REQUIRE(ns_i64{1} + s_i64{1} == ns_i64{1'000'000'001});
+      REQUIRE(s_i64{2} - ns_i64{1} == ns_i64{1'999'999'999});
+    }
+    THEN("mixed prefix comparisons are exact") {
+      REQUIRE(s_i64{1} != ns_i64{1'000'000'001});
+      REQUIRE(s_i64{1} < ns_i64{1'000'000'001});
+      REQUIRE(s_i64{1} == ns_i64{1'000'000'000});
+    }
+  }
+
+  GIVEN("integer positions in mm") {
+    THEN("adding metres and km uses their common prefix") {
+      REQUIRE((km_i64{1} + m_i64{1}).underlying_value() == 1001);
+      REQUIRE((km_i64{1} + mm_i64{1}).underlying_value() == 1'000'001);
+    }
+    THEN("multiplying keeps the product of the prefixes") {
+      auto area = mm_i64{2} * mm_i64{3};
+      static_assert(std::is_same_v<decltype(area)::Prefix, std::micro>);
+      REQUIRE(area.underlying_value() == 6);
+      auto speed = mm_i64{1'500} / s_i64{2};
+      static_assert(std::is_same_v<decltype(speed)::Prefix, std::milli>);
+      REQUIRE(speed.underlying_value() == 750);
+    }
+  }
+
+  GIVEN("casts between prefixes and BaseTypes") {
+    THEN("casting to a finer prefix is an exact multiply") {
+      REQUIRE(units::quantity_cast<ns_i64>(s_i64{3}) ==
+              ns_i64{3'000'000'000});
+      REQUIRE(units::quantity_cast<mm_i64>(metres{1.5}) == mm_i64{1'500});
+    }
+    THEN("casting to a coarser prefix truncates towards zero") {
+      REQUIRE(units::quantity_cast<s_i64>(ns_i64{1'999'999'999}) == s_i64{1});
+      REQUIRE(units::quantity_cast<s_i64>(ns_i64{-1'999'999'999}) ==
+              s_i64{-1});
+    }
+    THEN("casting to a floating point BaseType keeps the fraction") {
+      REQUIRE(units::quantity_cast<seconds>(ns_i64{1'500'000'000}) ==
+              seconds{1.5});
+    }
+    THEN("the checked cast throws rather than overflowing") {
+      using s_i32 = Quantity<seconds_t, std::int32_t>;
+      using ns_i32 = Quantity<nanoseconds_t, std::int32_t>;
+      REQUIRE(units::checked_quantity_cast<ns_i32>(s_i32{2}) ==
+              ns_i32{2'000'000'000});
+      REQUIRE_THROWS_AS(units::checked_quantity_cast<ns_i32>(s_i32{3}),
+                        std::overflow_error);
+      REQUIRE_THROWS_AS(units::checked_quantity_cast<ns_i32>(s_i32{-3}),
+                        std::overflow_error);
+      REQUIRE_THROWS_AS(units::checked_quantity_cast<ns_i64>(seconds{1e10}),
+                        std::overflow_error);
+      REQUIRE(units::checked_quantity_cast<ns_i64>(seconds{1e9}) ==
+              ns_i64{1'000'000'000'000'000'000});
+    }
+  }
+}
@@ -0,0 +1,248 @@
+#pragma once
+
+#include "quantity.hpp"
+
+#include <cassert>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+// ************************************************************************* /
+//    Expression templates for arrays of Quantities. An operator applied to  /
+//    a QuantityVector (or to an expression) returns a lightweight node      /
+//    describing the operation rather than a new array. The whole tree is    /
+//    evaluated element by element when it is assigned to a QuantityVector,  /
+//    so "0.5 * mass * v * v" is a single loop over memory with no           /
+//    intermediate arrays. Each element is computed with the scalar Quantity /
+//    operators, so the result units (derived_unity_t for * and /) and the   /
+//    dimension, tag and prefix checks are exactly those of the scalar code. /
+// ************************************************************************* /
+
+namespace units {
+  template <class Units, class BaseType, class Tag>
+  class QuantityVector;
+
+  template <class Op, class Lhs, class Rhs>
+  class BinaryExpression;
+
+  template <class Op, class Arg>
+  class UnaryExpression;
+
+  template <class Obj>
+  constexpr std::false_type is_quantity_expression(const Obj&) {
+    return std::false_type{};
+  }
+
+  template <class Units, class BaseType, class Tag>
+  constexpr std::true_type
+  is_quantity_expression(const QuantityVector<Units, BaseType, Tag>&) {
+    return std::true_type{};
+  }
+
+  template <class Op, class Lhs, class Rhs>
+  constexpr std::true_type
+  is_quantity_expression(const BinaryExpression<Op, Lhs, Rhs>&) {
+    return std::true_type{};
+  }
+
+  template <class Op, class Arg>
+  constexpr std::true_type
+  is_quantity_expression(const UnaryExpression<Op, Arg>&) {
+    return std::true_type{};
+  }
+
+  /// True for QuantityVectors and for the nodes built from them.
+  template <class Obj>
+  constexpr bool is_quantity_expression_v =
+      decltype(is_quantity_expression(std::declval<const Obj&>()))::value;
+
+  namespace Impl {
+    /// Operands that supply the same value to every element, e.g. the 0.5 in
+    /// 0.5 * mass, or a single Quantity.
+    template <class Obj>
+    constexpr bool is_broadcast_v =
+        std::is_arithmetic_v<Obj> ||
+        decltype(is_quantity(std::declval<Obj>()))::value;
+
+    /// At least one operand is an array, the other an array or a scalar.
+    template <class Lhs, class Rhs>
+    constexpr bool is_expression_operands_v =
+        (is_quantity_expression_v<Lhs> &&
+         (is_quantity_expression_v<Rhs> || is_broadcast_v<Rhs>)) ||
+        (is_broadcast_v<Lhs> && is_quantity_expression_v<Rhs>);
+
+    template <class Obj>
+    struct is_vector_operand : std::false_type {};
+
+    template <class Units, class BaseType, class Tag>
+    struct is_vector_operand<QuantityVector<Units, BaseType, Tag>>
+        : std::true_type {};
+
+    /** QuantityVectors are held by reference, nodes and scalars by value, so
+     * an expression must not outlive the vectors it refers to (store the
+     * result in a QuantityVector rather than keeping the expression). */
+    template <class Obj>
+    using operand_t =
+        std::conditional_t<is_vector_operand<Obj>::value, const Obj&, Obj>;
+
+    template <class Obj>
+    constexpr decltype(auto) element(const Obj& o,
+                                     [[maybe_unused]] std::size_t i) {
+      if constexpr (is_broadcast_v<Obj>) {
+        return o;
+      } else {
+        return o[i];
+      }
+    }
+
+    template <class Lhs, class Rhs>
+    constexpr std::size_t expression_size(const Lhs& lhs, const Rhs& rhs) {
+      if constexpr (is_broadcast_v<Lhs>) {
+        return rhs.size();
+      } else if constexpr (is_broadcast_v<Rhs>) {
+        return lhs.size();
+      } else {
+        assert(lhs.size() == rhs.size());
+        return lhs.size();
+      }
+    }
+
+    struct Plus {
+      template <class A, class B>
+      constexpr auto operator()(const A& a, const B& b) const {
+        return a + b;
+      }
+    };
+    struct Minus {
+      template <class A, class B>
+      constexpr auto operator()(const A& a, const B& b) const {
+        return a - b;
+      }
+    };
+    struct Multiplies {
+      template <class A, class B>
+      constexpr auto operator()(const A& a, const B& b) const {
+        return a * b;
+      }
+    };
+    struct Divides {
+      template <class A, class B>
+      constexpr auto operator()(const A& a, const B& b) const {
+        return a / b;
+      }
+    };
+    struct Negate {
+      template <class A>
+      constexpr auto operator()(const A& a) const {
+        return -a;
+      }
+    };
+
+    /** Convert an element of an expression to the units stored in the
+     * destination, the dimensions must match but the prefix may differ (e.g.
+     * a km * m / m expression assigned to a vector of km). */
+    template <class ToUnits, class Units, class BaseType, class Tag>
+    constexpr auto convert_element(const Quantity<Units, BaseType, Tag>& q) {
+      if constexpr (std::is_same_v<ToUnits, Units>) {
+        return q;
+      } else {
+        use_dimension_names<same_dimension(ToUnits{}, Units{}),
+                            decltype(make_names_from_dimension(ToUnits{})),
+                            decltype(make_names_from_dimension(Units{}))>();
+        using Ratio = prefix_divide_t<Units, ToUnits>;
+        return Quantity<ToUnits, BaseType, Tag>{
+            scale_by<Ratio>(q.underlying_value())};
+      }
+    }
+
+    /// out[i] = e[i], the single loop every expression is evaluated in.
+    template <class Units, class BaseType, class Tag, class Expr>
+    void evaluate(Quantity<Units, BaseType, Tag>* out, const Expr& e,
+                  std::size_t n) {
+      using Element = typename Expr::value_type;
+      static_assert(std::is_same_v<typename Element::Tag, Tag>);
+      static_assert(std::is_same_v<typename Element::BaseType, BaseType>);
+      for (std::size_t i = 0; i < n; ++i) {
+        out[i] = convert_element<Units>(e[i]);
+      }
+    }
+  } // namespace Impl
+
+  /// A lazily evaluated element-wise binary operation.
+  template <class Op, class Lhs, class Rhs>
+  class BinaryExpression {
+  public:
+    using value_type = std::decay_t<decltype(
+        Op{}(Impl::element(std::declval<const Lhs&>(), 0),
+             Impl::element(std::declval<const Rhs&>(), 0)))>;
+
+    constexpr BinaryExpression(const Lhs& lhs, const Rhs& rhs)
+        : _lhs(lhs), _rhs(rhs), _size(Impl::expression_size(lhs, rhs)) {}
+
+    constexpr value_type operator[](std::size_t i) const {
+      return Op{}(Impl::element(_lhs, i), Impl::element(_rhs, i));
+    }
+    constexpr std::size_t size() const noexcept { return _size; }
+
+  private:
+    Impl::operand_t<Lhs> _lhs;
+    Impl::operand_t<Rhs> _rhs;
+    std::size_t _size;
+  };
+
+  /// A lazily evaluated element-wise unary operation.
+  template <class Op, class Arg>
+  class UnaryExpression {
+  public:
+    using value_type = std::decay_t<decltype(
+        Op{}(Impl::element(std::declval<const Arg&>(), 0)))>;
+
+    constexpr explicit UnaryExpression(const Arg& arg) : _arg(arg) {}
+
+    constexpr value_type operator[](std::size_t i) const {
+      return Op{}(Impl::element(_arg, i));
+    }
+    constexpr std::size_t size() const noexcept { return _arg.size(); }
+
+  private:
+    Impl::operand_t<Arg> _arg;
+  };
+
+  // ************************************************************************* /
+  //    Element-wise operators, found by ADL for QuantityVectors and nodes    /
+  // ************************************************************************* /
+
+  template <
+      class Lhs, class Rhs,
+      typename = std::enable_if_t<Impl::is_expression_operands_v<Lhs, Rhs>>>
+  constexpr auto operator+(const Lhs& a, const Rhs& b) {
+    return BinaryExpression<Impl::Plus, Lhs, Rhs>{a, b};
+  }
+
+  template <
+      class Lhs, class Rhs,
+      typename = std::enable_if_t<Impl::is_expression_operands_v<Lhs, Rhs>>>
+  constexpr auto operator-(const Lhs& a, const Rhs& b) {
+    return BinaryExpression<Impl::Minus, Lhs, Rhs>{a, b};
+  }
+
+  template <
+      class Lhs, class Rhs,
+      typename = std::enable_if_t<Impl::is_expression_operands_v<Lhs, Rhs>>>
+  constexpr auto operator*(const Lhs& a, const Rhs& b) {
+    return BinaryExpression<Impl::Multiplies, Lhs, Rhs>{a, b};
+  }
+
+  template <
+      class Lhs, class Rhs,
+      typename = std::enable_if_t<Impl::is_expression_operands_v<Lhs, Rhs>>>
+  constexpr auto operator/(const Lhs& a, const Rhs& b) {
+    return BinaryExpression<Impl::Divides, Lhs, Rhs>{a, b};
+  }
+
+  template <class Arg,
+            typename = std::enable_if_t<is_quantity_expression_v<Arg>>>
+  constexpr auto operator-(const Arg& a) {
+    return UnaryExpression<Impl::Negate, Arg>{a};
+  }
+} // namespace units
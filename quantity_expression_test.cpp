@@ -0,0 +1,69 @@
+#include "common_quantities.hpp"
+#include "quantity_expression.hpp"
+#include "quantity_vector.hpp"
+#include <catch.hpp>
+
+SCENARIO("Testing expression templates over QuantityVectors") {
+  using units::QuantityVector;
+  GIVEN("vectors of masses and velocities") {
+    auto mass = QuantityVector<kg_t>{kg{1}, kg{2}, kg{4}};
+    auto v = QuantityVector<metres_per_sec_t>{
+        metres_per_sec{1}, metres_per_sec{3}, metres_per_sec{10}};
+    WHEN("writing the kinetic energy as an expression") {
+      auto expr = 0.5 * mass * v * v;
+      THEN("nothing has been evaluated, the expression is a node") {
+        static_assert(!decltype(units::is_quantity_vector(expr))::value);
+        static_assert(units::is_quantity_expression_v<decltype(expr)>);
+      }
+      THEN("the element type is worked out from the scalar operators") {
+        static_assert(
+            std::is_same_v<decltype(expr)::value_type,
+                           decltype(0.5 * kg{} * metres_per_sec{} *
+                                    metres_per_sec{})>);
+        static_assert(std::is_same_v<decltype(expr)::value_type, Joules>);
+      }
+      THEN("assigning it to a vector evaluates every element") {
+        QuantityVector<Joules_t> ke = expr;
+        REQUIRE(ke.size() == 3);
+        REQUIRE(ke[0] == Joules{0.5});
+        REQUIRE(ke[1] == Joules{9});
+        REQUIRE(ke[2] == Joules{200});
+      }
+    }
+    WHEN("using a single Quantity in the expression") {
+      QuantityVector<kg_metres_per_sec_t> p = kg{2} * v;
+      THEN("it is applied to every element") {
+        REQUIRE(p[0] == kg_metres_per_sec{2});
+        REQUIRE(p[2] == kg_metres_per_sec{20});
+      }
+    }
+  }
+  GIVEN("vectors with different prefixes") {
+    auto m = QuantityVector<metres_t>{metres{500}, metres{1500}};
+    auto k = QuantityVector<km_t>{km{1}, km{2}};
+    WHEN("assigning to a vector of a different prefix") {
+      QuantityVector<km_t> total = m + k - m / 2;
+      THEN("the result is converted to the destination prefix") {
+        REQUIRE(total[0] == km{1.25});
+        REQUIRE(total[1] == km{2.75});
+      }
+    }
+    WHEN("updating a vector in place") {
+      m = m * 2 + k;
+      k += -m;
+      THEN("each element only depends on the same element of the inputs") {
+        REQUIRE(m[0] == metres{2000});
+        REQUIRE(m[1] == metres{5000});
+        REQUIRE(k[0] == km{-1});
+        REQUIRE(k[1] == km{-3});
+      }
+    }
+    WHEN("comparing expressions") {
+      auto mask = m * 2 > k;
+      THEN("the comparison is element-wise") {
+        REQUIRE(mask[0] == 0);
+        REQUIRE(mask[1] == 1);
+      }
+    }
+  }
+}
@@ -0,0 +1,406 @@
+#pragma once
+
+#include "conversion_factor.hpp"
+#include "quantity.hpp"
+#include "unit_parser.hpp"
+#include "unit_registry.hpp"
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+#include <version>
+
+#if defined(__cpp_lib_format)
+#include <format>
+#include <string>
+#endif
+
+// ************************************************************************* /
+//    Formatting Quantities into caller provided buffers, without streams,   /
+//    locales or allocation. The unit suffix of each type is built at        /
+//    compile time by format_unit, so formatting a Quantity is one           /
+//    std::to_chars of the value and a copy of the suffix. from_chars reads  /
+//    them back, converting from any unit of the same dimensions. Also       /
+//    provides a std::formatter where the standard library has <format>.     /
+// ************************************************************************* /
+
+namespace units {
+  namespace Impl {
+    template <class Units, UnitStyle Style>
+    constexpr auto make_unit_suffix() {
+      constexpr auto s = format_unit_string(Units::code, Style);
+      auto a = std::array<char, s.size>{};
+      std::copy(s.data, s.data + s.size, a.begin());
+      return a;
+    }
+
+    template <class Units, UnitStyle Style>
+    inline constexpr auto unit_suffix = make_unit_suffix<Units, Style>();
+
+    template <class Units, UnitStyle Style>
+    constexpr std::string_view unit_suffix_view() {
+      return {unit_suffix<Units, Style>.data(),
+              unit_suffix<Units, Style>.size()};
+    }
+  } // namespace Impl
+
+  /** The unit of Units in the given style, e.g. "m s⁻²", as written after
+   * the value by to_chars. Empty if dimensionless. */
+  template <class Units>
+  constexpr std::string_view unit_string(UnitStyle style = UnitStyle::si) {
+    switch (style) {
+    case UnitStyle::ascii:
+      return Impl::unit_suffix_view<Units, UnitStyle::ascii>();
+    case UnitStyle::unicode:
+      return Impl::unit_suffix_view<Units, UnitStyle::unicode>();
+    default:
+      return Impl::unit_suffix_view<Units, UnitStyle::si>();
+    }
+  }
+
+  namespace Impl {
+    /// Append " " and the unit to the value written up to r.ptr
+    inline std::to_chars_result append_unit(std::to_chars_result r,
+                                            char* last,
+                                            std::string_view unit) {
+      if (r.ec != std::errc{} || unit.empty()) {
+        return r;
+      }
+      if (static_cast<std::size_t>(last - r.ptr) < unit.size() + 1) {
+        return {last, std::errc::value_too_large};
+      }
+      *r.ptr = ' ';
+      return {std::copy(unit.begin(), unit.end(), r.ptr + 1), std::errc{}};
+    }
+  } // namespace Impl
+
+  /** Write q into [first, last) as std::to_chars writes its value (the
+   * shortest representation that reads back exactly) followed by a space
+   * and its unit, e.g. "9.81 m s⁻²". Returns std::errc::value_too_large
+   * if it doesn't fit. Nothing is allocated and no locale is used. */
+  template <class Units, class BaseType, class Tag>
+  std::to_chars_result to_chars(char* first, char* last,
+                                const Quantity<Units, BaseType, Tag>& q,
+                                UnitStyle style = UnitStyle::si) {
+    return Impl::append_unit(std::to_chars(first, last, q.underlying_value()),
+                             last, unit_string<Units>(style));
+  }
+
+  /// As above, with the value written in the format fmt, e.g.
+  /// std::chars_format::fixed.
+  template <class Units, class BaseType, class Tag>
+  std::to_chars_result to_chars(char* first, char* last,
+                                const Quantity<Units, BaseType, Tag>& q,
+                                std::chars_format fmt,
+                                UnitStyle style = UnitStyle::si) {
+    static_assert(std::is_floating_point_v<BaseType>);
+    return Impl::append_unit(
+        std::to_chars(first, last, q.underlying_value(), fmt), last,
+        unit_string<Units>(style));
+  }
+
+  /// As above, with precision digits, as std::to_chars and printf.
+  template <class Units, class BaseType, class Tag>
+  std::to_chars_result to_chars(char* first, char* last,
+                                const Quantity<Units, BaseType, Tag>& q,
+                                std::chars_format fmt, int precision,
+                                UnitStyle style = UnitStyle::si) {
+    static_assert(std::is_floating_point_v<BaseType>);
+    return Impl::append_unit(
+        std::to_chars(first, last, q.underlying_value(), fmt, precision),
+        last, unit_string<Units>(style));
+  }
+
+  namespace Impl {
+    constexpr bool is_blank(char c) { return c == ' ' || c == '\t'; }
+
+    /// Bytes that can be part of a unit: those of parse_unit's grammar, '_'
+    /// of registered names like "us_gallon", and UTF-8.
+    constexpr bool is_unit_char(char c) {
+      return is_letter(c) || is_digit(c) || is_blank(c) || c == '^' ||
+             c == '/' || c == '*' || c == '(' || c == ')' || c == '-' ||
+             c == '+' || c == '.' || c == '_' ||
+             static_cast<unsigned char>(c) >= 0x80;
+    }
+
+    /// The factor converting values in a unit of scale from to Units, or 0
+    /// if it overflows or an integer BaseType would need rounding.
+    template <class Units, class BaseType>
+    constexpr BaseType factor_to(const PrefixValue& from) {
+      auto r = PrefixValue{};
+      if (!multiply_prefixes(from, reciprocal(Units::code.prefix), r) ||
+          r.exponent > max_prefix_exponent ||
+          r.exponent < -max_prefix_exponent) {
+        return 0;
+      }
+      if constexpr (std::is_floating_point_v<BaseType>) {
+        return rounded_prefix<BaseType>(r);
+      } else {
+        return r.is_ratio() && r.den == 1 && std::in_range<BaseType>(r.num)
+                   ? static_cast<BaseType>(r.num)
+                   : 0;
+      }
+    }
+
+    /// factors[i] converts registered_units[i] to Units, 0 if the
+    /// dimensions are different
+    template <class Units, class BaseType>
+    inline constexpr auto registry_factors_to = [] {
+      auto f = std::array<BaseType, registry_size>{};
+      for (const auto& u : registered_units) {
+        f[u.index] = u.code.same_dimension(Units::code)
+                         ? factor_to<Units, BaseType>(u.code.prefix)
+                         : 0;
+      }
+      return f;
+    }();
+
+    template <class BaseType>
+    struct UnitFactor {
+      bool is_unit = false;
+      BaseType factor = 0; ///< 0 if it can't be converted
+    };
+
+    /** The last few units read, and their factors, so a stream that
+     * repeats units parses each once. Fixed size, there's no allocation. */
+    template <class BaseType>
+    class UnitCache {
+    public:
+      const UnitFactor<BaseType>* find(std::string_view text) const {
+        for (const auto& e : _entries) {
+          if (e.length == text.size() &&
+              std::equal(text.begin(), text.end(), e.text)) {
+            return &e.unit;
+          }
+        }
+        return nullptr;
+      }
+
+      void insert(std::string_view text, UnitFactor<BaseType> unit) {
+        if (text.size() > max_length) {
+          return;
+        }
+        auto& e = _entries[_next];
+        _next = (_next + 1) % _entries.size();
+        std::copy(text.begin(), text.end(), e.text);
+        e.length = text.size();
+        e.unit = unit;
+      }
+
+    private:
+      static constexpr std::size_t max_length = 30;
+
+      struct Entry {
+        char text[max_length]{};
+        std::size_t length = max_length + 1;
+        UnitFactor<BaseType> unit;
+      };
+
+      std::array<Entry, 4> _entries{};
+      std::size_t _next = 0;
+    };
+
+    /** The factor converting values in the unit text to Units. The units
+     * of Units itself and the registered units are found without parsing,
+     * the factors of the latter are worked out at compile time, and others
+     * are parsed once per thread while they stay in its UnitCache. */
+    template <class Units, class BaseType>
+    UnitFactor<BaseType> unit_factor(std::string_view text) {
+      if (text == unit_string<Units>(UnitStyle::ascii) ||
+          text == unit_string<Units>(UnitStyle::si)) {
+        return {true, 1};
+      }
+      thread_local auto cache = UnitCache<BaseType>{};
+      if (const auto* unit = cache.find(text)) {
+        return *unit;
+      }
+      auto unit = UnitFactor<BaseType>{};
+      if (const auto* u = find_registered_unit(text)) {
+        unit = {true, registry_factors_to<Units, BaseType>[u->index]};
+      } else if (const auto r = parse_unit(text);
+                 r.ec != std::errc::invalid_argument) {
+        unit = {true, r.ec == std::errc{} && r.code.same_dimension(Units::code)
+                          ? factor_to<Units, BaseType>(r.code.prefix)
+                          : BaseType{0}};
+      }
+      cache.insert(text, unit);
+      return unit;
+    }
+
+    template <class BaseType>
+    bool scale(BaseType& v, BaseType factor) {
+      if (factor == 1) {
+        return true;
+      }
+      if constexpr (std::is_floating_point_v<BaseType>) {
+        v *= factor;
+        return std::isfinite(v);
+      } else {
+        return !__builtin_mul_overflow(v, factor, &v);
+      }
+    }
+  } // namespace Impl
+
+  /** Read a value and unit, e.g. "12.5 km", "3 MPa" or "400 us_gallon",
+   * from [first, last) into q, converting it to the units of q. As
+   * std::from_chars, there is no allocation, locale or leading whitespace,
+   * and ptr is the first character not read.
+   *
+   * The unit is anything parse_unit takes, or a registered name or symbol,
+   * and can be separated from the number by spaces or not at all. It runs
+   * up to a character that can't be in a unit, such as ',' or a new line,
+   * less any trailing words that aren't part of it, so "3 m/s 4 m/s" reads
+   * "3 m/s" but "3 m s" reads as metre seconds. Without a unit the value is
+   * dimensionless.
+   *
+   * Returns std::errc::invalid_argument, and leaves q alone, if there is no
+   * number or the unit isn't one of the dimensions of q (or an integer
+   * BaseType would have to be rounded), and std::errc::result_out_of_range
+   * if the value doesn't fit in BaseType once converted. */
+  template <class Units, class BaseType, class Tag>
+  std::from_chars_result from_chars(const char* first, const char* last,
+                                    Quantity<Units, BaseType, Tag>& q) {
+    auto v = BaseType{};
+    const auto number = std::from_chars(first, last, v);
+    if (number.ec == std::errc::invalid_argument) {
+      return number;
+    }
+    auto start = number.ptr;
+    while (start != last && Impl::is_blank(*start)) {
+      ++start;
+    }
+    auto end = start;
+    while (end != last && Impl::is_unit_char(*end)) {
+      ++end;
+    }
+    auto unit = Impl::UnitFactor<BaseType>{};
+    for (;;) {
+      while (end != start && Impl::is_blank(end[-1])) {
+        --end;
+      }
+      unit = Impl::unit_factor<Units, BaseType>(
+          {start, static_cast<std::size_t>(end - start)});
+      if (unit.is_unit || end == start) {
+        break;
+      }
+      // the last word may be the start of the next field
+      while (end != start && !Impl::is_blank(end[-1])) {
+        --end;
+      }
+    }
+    if (!unit.is_unit || unit.factor == 0) {
+      return {first, std::errc::invalid_argument};
+    }
+    const auto ptr = end == start ? number.ptr : end;
+    if (number.ec != std::errc{} || !Impl::scale(v, unit.factor)) {
+      return {ptr, std::errc::result_out_of_range};
+    }
+    q = Quantity<Units, BaseType, Tag>{v};
+    return {ptr, std::errc{}};
+  }
+} // namespace units
+
+#if defined(__cpp_lib_format)
+/** Format Quantities with std::format. The format spec is
+ *
+ *   [.precision][e | f | g | a][A | U | S]
+ *
+ * where e, f, g and a are the floating point formats of std::format, and
+ * A, U and S choose the ASCII, Unicode or SI (the default) unit style, e.g.
+ * std::format("{:.2fA}", a) gives "9.81 m s^-2". */
+namespace std {
+template <class Units, class BaseType, class Tag>
+struct formatter<Quantity<Units, BaseType, Tag>, char> {
+  int precision = -1;
+  std::chars_format fmt{};
+  bool has_fmt = false;
+  units::UnitStyle style = units::UnitStyle::si;
+
+  constexpr auto parse(std::format_parse_context& ctx) {
+    auto it = ctx.begin();
+    const auto end = ctx.end();
+    if (it != end && *it == '.') {
+      precision = 0;
+      for (++it; it != end && *it >= '0' && *it <= '9'; ++it) {
+        precision = precision * 10 + (*it - '0');
+      }
+    }
+    if (it != end) {
+      has_fmt = true;
+      switch (*it) {
+      case 'e':
+        fmt = std::chars_format::scientific;
+        break;
+      case 'f':
+        fmt = std::chars_format::fixed;
+        break;
+      case 'g':
+        fmt = std::chars_format::general;
+        break;
+      case 'a':
+        fmt = std::chars_format::hex;
+        break;
+      default:
+        has_fmt = false;
+      }
+      it += has_fmt ? 1 : 0;
+    }
+    if (it != end && (*it == 'A' || *it == 'U' || *it == 'S')) {
+      style = *it == 'A'   ? units::UnitStyle::ascii
+              : *it == 'U' ? units::UnitStyle::unicode
+                           : units::UnitStyle::si;
+      ++it;
+    }
+    if (it != end && *it != '}') {
+      throw std::format_error("invalid format for a Quantity");
+    }
+    return it;
+  }
+
+  template <class FormatContext>
+  auto format(const Quantity<Units, BaseType, Tag>& q,
+              FormatContext& ctx) const {
+    const auto v = q.underlying_value();
+    const auto write = [&](char* first, char* last) {
+      if constexpr (std::is_floating_point_v<BaseType>) {
+        const auto f = has_fmt ? fmt : std::chars_format::general;
+        return precision >= 0 ? std::to_chars(first, last, v, f, precision)
+               : has_fmt      ? std::to_chars(first, last, v, f)
+                              : std::to_chars(first, last, v);
+      } else {
+        return std::to_chars(first, last, v);
+      }
+    };
+    char buffer[128];
+    auto r = write(buffer, std::end(buffer));
+    auto out = ctx.out();
+    if (r.ec == std::errc{}) {
+      out = std::copy(buffer, r.ptr, out);
+    } else {
+      // fixed notation of a large value, or a large precision
+      auto big = std::string(1024, '\0');
+      while ((r = write(big.data(), big.data() + big.size())).ec !=
+             std::errc{}) {
+        big.resize(big.size() * 2);
+      }
+      out = std::copy(big.data(), r.ptr, out);
+    }
+    const auto unit = units::unit_string<Units>(style);
+    if (!unit.empty()) {
+      *out++ = ' ';
+      out = std::copy(unit.begin(), unit.end(), out);
+    }
+    return out;
+  }
+};
+} // namespace std
+#endif
@@ -0,0 +1,241 @@
+#include "common_quantities.hpp"
+#include "quantity_format.hpp"
+#include <catch.hpp>
+
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
+#include <version>
+
+namespace {
+  template <class Q, class... Args>
+  std::string format(const Q& q, Args... args) {
+    char buffer[64];
+    const auto r = units::to_chars(buffer, buffer + sizeof(buffer), q, args...);
+    REQUIRE(r.ec == std::errc{});
+    return {buffer, r.ptr};
+  }
+
+  template <class Q>
+  std::pair<Q, std::from_chars_result> parse(std::string_view s) {
+    auto q = Q{};
+    const auto r = units::from_chars(s.data(), s.data() + s.size(), q);
+    return {q, r};
+  }
+
+  /** Reads "2 <symbol>" for each registered unit of the dimension of Units,
+   * which from_chars looks up in the registry, and checks it against the
+   * factor of what parse_unit makes of the symbol. The number checked. */
+  template <class Units>
+  std::size_t check_registered_symbols() {
+    auto checked = std::size_t{};
+    for (const auto& u : units::registered_units()) {
+      if (!u.code.same_dimension(Units::code)) {
+        continue;
+      }
+      INFO(u.symbol);
+      const auto text = "2 " + std::string{u.symbol};
+      const auto [q, r] = parse<Quantity<Units>>(text);
+      REQUIRE(r.ec == std::errc{});
+      REQUIRE(r.ptr == text.data() + text.size());
+      const auto code = units::parse_unit(u.symbol).code;
+      REQUIRE(q.underlying_value() ==
+              2 * units::Impl::factor_to<Units, double>(code.prefix));
+      ++checked;
+    }
+    return checked;
+  }
+} // namespace
+
+SCENARIO("Formatting Quantities into buffers") {
+  using namespace units;
+  GIVEN("Quantities of different units") {
+    THEN("the value is followed by the unit") {
+      REQUIRE(format(metres_per_sec2{9.81}) == "9.81 m s⁻²");
+      REQUIRE(format(km{1.5}) == "1.5 km");
+      REQUIRE(format(Joules{-2}) == "-2 J");
+      REQUIRE(format(hectare{3}) == "3 ha");
+      REQUIRE(format(dimensionless{0.5}) == "0.5");
+      REQUIRE(format(Quantity<nanoseconds_t, std::int64_t>{42}) == "42 ns");
+    }
+    THEN("the style changes how powers are written") {
+      const auto a = metres_per_sec2{9.81};
+      REQUIRE(format(a, UnitStyle::ascii) == "9.81 m s^-2");
+      REQUIRE(format(a, UnitStyle::unicode) == "9.81 m·s⁻²");
+      REQUIRE(format(MPam05{2}, UnitStyle::si) == "2 1e6 m^(-1/2) kg s⁻²");
+      REQUIRE(format(metres05{2}, UnitStyle::si) == "2 √m");
+    }
+    THEN("the value can have a format and precision") {
+      const auto a = metres_per_sec2{9.80665};
+      REQUIRE(format(a, std::chars_format::fixed, 2) == "9.81 m s⁻²");
+      REQUIRE(format(a, std::chars_format::scientific, 1,
+                     UnitStyle::ascii) == "9.8e+00 m s^-2");
+      REQUIRE(format(a, std::chars_format::fixed) == "9.80665 m s⁻²");
+    }
+    THEN("the unit string is known at compile time") {
+      static_assert(unit_string<Pascals_t>() == "Pa");
+      static_assert(unit_string<metres3_t>(UnitStyle::ascii) == "m^3");
+    }
+  }
+  GIVEN("a buffer that is too small") {
+    THEN("value_too_large is returned") {
+      char buffer[6];
+      auto r = to_chars(buffer, buffer + sizeof(buffer), km{1.5});
+      REQUIRE(r.ec == std::errc{});
+      REQUIRE(std::string_view{buffer, r.ptr} == "1.5 km");
+      r = to_chars(buffer, buffer + 5, km{1.5});
+      REQUIRE(r.ec == std::errc::value_too_large);
+      r = to_chars(buffer, buffer + 2, km{1.5});
+      REQUIRE(r.ec == std::errc::value_too_large);
+    }
+  }
+#if defined(__cpp_lib_format)
+  GIVEN("std::format") {
+    THEN("the spec sets the precision, format and style") {
+      const auto a = metres_per_sec2{9.80665};
+      REQUIRE(std::format("{}", a) == "9.80665 m s⁻²");
+      REQUIRE(std::format("{:.2f}", a) == "9.81 m s⁻²");
+      REQUIRE(std::format("{:.2fA}", a) == "9.81 m s^-2");
+      REQUIRE(std::format("{:U}", a) == "9.80665 m·s⁻²");
+      REQUIRE(std::format("{:e}", km{1.5}) == "1.5e+00 km");
+    }
+  }
+#endif
+}
+
+SCENARIO("Reading Quantities from characters") {
+  using namespace units;
+  GIVEN("values with units") {
+    THEN("they are converted to the units of the Quantity") {
+      REQUIRE(parse<km>("12.5 km").first == km{12.5});
+      REQUIRE(parse<metres>("12.5 km").first == metres{12'500});
+      REQUIRE(parse<Pascals>("3 MPa").first == Pascals{3e6});
+      REQUIRE(parse<metres>("5mm").first == metres{0.005});
+      REQUIRE(parse<metres_per_sec>("-36 km/h").first == metres_per_sec{-10});
+      REQUIRE(parse<metres_per_sec2>("9.81 m s⁻²").first ==
+              metres_per_sec2{9.81});
+      REQUIRE(parse<dimensionless>("0.5").first == dimensionless{0.5});
+    }
+    THEN("registered names and symbols are read too") {
+      REQUIRE(parse<us_gallon>("400 us_gallon").first == us_gallon{400});
+      REQUIRE(parse<metres2>("2 ha").first == metres2{20'000});
+      REQUIRE(parse<litres>("1 US gal").first.underlying_value() ==
+              Approx(3.785411784));
+      REQUIRE(parse<per_second>("1 1/min").first == per_second{1.0 / 60});
+      REQUIRE(parse<metres2>("1 ac").first == metres2{4046.8564224});
+    }
+    THEN("every registered symbol reads as parse_unit reads it") {
+      const auto checked =
+          check_registered_symbols<kg_t>() +
+          check_registered_symbols<metres_t>() +
+          check_registered_symbols<metres2_t>() +
+          check_registered_symbols<metres3_t>() +
+          check_registered_symbols<metres05_t>() +
+          check_registered_symbols<seconds_t>() +
+          check_registered_symbols<per_second_t>() +
+          check_registered_symbols<seconds2_t>() +
+          check_registered_symbols<metres_per_sec_t>() +
+          check_registered_symbols<metres_per_sec2_t>() +
+          check_registered_symbols<metres2_per_sec2_t>() +
+          check_registered_symbols<Joules_t>() +
+          check_registered_symbols<Watts_t>() +
+          check_registered_symbols<kg_metres_per_sec_t>() +
+          check_registered_symbols<Newtons_t>() +
+          check_registered_symbols<Pascals_t>() +
+          check_registered_symbols<MPam05_t>();
+      REQUIRE(checked == units::registered_units().size());
+    }
+    THEN("ptr is after the unit") {
+      const auto s = std::string_view{"3 m/s, 4 m/s 5 m/s\n"};
+      auto [v, r] = parse<metres_per_sec>(s);
+      REQUIRE(r.ptr == s.data() + 5);
+      r = from_chars(s.data() + 7, s.data() + s.size(), v);
+      REQUIRE(v == metres_per_sec{4});
+      REQUIRE(r.ptr == s.data() + 12);
+      r = from_chars(r.ptr + 1, s.data() + s.size(), v);
+      REQUIRE(v == metres_per_sec{5});
+      REQUIRE(*r.ptr == '\n');
+    }
+    THEN("integers are scaled exactly") {
+      using ns = Quantity<nanoseconds_t, std::int64_t>;
+      REQUIRE(parse<ns>("3 s").first == ns{3'000'000'000});
+      REQUIRE(parse<ns>("2 min").first == ns{120'000'000'000});
+    }
+  }
+  GIVEN("bad values") {
+    THEN("invalid_argument is returned and the Quantity is unchanged") {
+      for (const auto* s : {"12.5 s", "km", "12.5", "3 m s", "7 bogus"}) {
+        auto q = km{1};
+        const auto r = from_chars(s, s + std::string_view{s}.size(), q);
+        REQUIRE(r.ec == std::errc::invalid_argument);
+        REQUIRE(r.ptr == s);
+        REQUIRE(q == km{1});
+      }
+      using s_int = Quantity<seconds_t, int>;
+      REQUIRE(parse<s_int>("1 ms").second.ec == std::errc::invalid_argument);
+    }
+    THEN("values too large for BaseType are out of range") {
+      REQUIRE(parse<metres>("1e300 Gm").second.ec ==
+              std::errc::result_out_of_range);
+      REQUIRE(parse<Quantity<seconds_t, int>>("3000000 h").second.ec ==
+              std::errc::result_out_of_range);
+      REQUIRE(parse<metres>("1e999 m").second.ec ==
+              std::errc::result_out_of_range);
+    }
+  }
+  GIVEN("what to_chars writes") {
+    THEN("it reads back exactly in every style") {
+      for (auto style : {UnitStyle::ascii, UnitStyle::unicode, UnitStyle::si}) {
+        for (auto x : {1.0 / 3, -1e-300, 6.02e23}) {
+          const auto a = MPam05{x};
+          REQUIRE(parse<MPam05>(format(a, style)).first == a);
+          REQUIRE(parse<hectare>(format(hectare{x}, style)).first ==
+                  hectare{x});
+        }
+      }
+    }
+  }
+}
+
+SCENARIO("Profiling to_chars", "[Profile]") {
+  GIVEN("a telemetry stream") {
+    char buffer[64];
+    auto total = std::size_t{};
+    BENCHMARK("format 1'000'000 Quantities") {
+      for (auto i = 0; i < 1'000'000; ++i) {
+        const auto a = metres_per_sec2{i * 0.01};
+        total += units::to_chars(buffer, buffer + 64, a).ptr - buffer;
+      }
+    }
+    std::cout << total << "\n";
+  }
+}
+
+SCENARIO("Profiling from_chars", "[Profile]") {
+  GIVEN("an event stream with several Quantities per record") {
+    auto text = std::string{};
+    for (auto i = 0; i < 100'000; ++i) {
+      text += std::to_string(i * 0.25) + " km, " + std::to_string(i) +
+              " MPa, " + std::to_string(i % 1000) + " us_gallon\n";
+    }
+    auto xs = std::vector<metres>(100'000);
+    auto ps = std::vector<Pascals>(100'000);
+    auto vs = std::vector<litres>(100'000);
+    BENCHMARK("parse " + std::to_string(text.size()) + " bytes") {
+      const auto* p = text.data();
+      const auto* end = p + text.size();
+      for (auto i = 0; p != end; ++i) {
+        p = units::from_chars(p, end, xs[i]).ptr + 2;
+        p = units::from_chars(p, end, ps[i]).ptr + 2;
+        p = units::from_chars(p, end, vs[i]).ptr + 1;
+      }
+    }
+    std::cout << xs.back() << " " << ps.back() << " " << vs.back() << "\n";
+  }
+}
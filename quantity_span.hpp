@@ -0,0 +1,91 @@
+#pragma once
+
+#include "quantity.hpp"
+
+#include <cstddef>
+#include <new>
+#include <span>
+#include <type_traits>
+
+// ************************************************************************* /
+//    Zero copy views between arrays of Quantities and arrays of their       /
+//    BaseType, to hand Quantity data to BLAS, FFTs or C code and back. A    /
+//    Quantity is a single BaseType member, which is checked at compile time /
+//    for every type viewed, so the views are a pointer cast.                /
+// ************************************************************************* /
+
+namespace units {
+  /** True if an array of Q has the layout of an array of its BaseType, so
+   * it can be viewed as one: Q is standard layout with a single BaseType
+   * member (and so pointer-interconvertible with it), trivially copyable,
+   * and has the size and alignment of BaseType. */
+  template <class Q>
+  inline constexpr bool has_underlying_layout =
+      std::is_standard_layout_v<Q> && std::is_trivially_copyable_v<Q> &&
+      sizeof(Q) == sizeof(typename Q::BaseType) &&
+      alignof(Q) == alignof(typename Q::BaseType);
+
+  namespace Impl {
+    template <class Q>
+    constexpr void check_underlying_layout() {
+      static_assert(has_underlying_layout<Q>,
+                    "Quantity must have the layout of its BaseType");
+    }
+
+    /** Pointer to the underlying values of a contiguous range of Quantities.
+     * A Quantity is a single BaseType member, so the range can be walked as
+     * BaseTypes. */
+    template <class Units, class BaseType, class Tag>
+    const BaseType*
+    underlying_data(const Quantity<Units, BaseType, Tag>* q) noexcept {
+      check_underlying_layout<Quantity<Units, BaseType, Tag>>();
+      return reinterpret_cast<const BaseType*>(q);
+    }
+
+    template <class Units, class BaseType, class Tag>
+    BaseType* underlying_data(Quantity<Units, BaseType, Tag>* q) noexcept {
+      check_underlying_layout<Quantity<Units, BaseType, Tag>>();
+      return reinterpret_cast<BaseType*>(q);
+    }
+  } // namespace Impl
+
+  /** The underlying values of qs, over the same memory, e.g. to pass an
+   * array of Quantities to a linear algebra library:
+   *
+   *   auto values = units::as_underlying(std::span{pressures});
+   *   cblas_dscal(values.size(), 2.0, values.data(), 1);
+   *
+   * The values are in the units of the Quantities, prefix included. */
+  template <class Units, class BaseType, class Tag, std::size_t Extent>
+  std::span<BaseType, Extent>
+  as_underlying(std::span<Quantity<Units, BaseType, Tag>, Extent> qs) noexcept {
+    return std::span<BaseType, Extent>{Impl::underlying_data(qs.data()),
+                                       qs.size()};
+  }
+
+  template <class Units, class BaseType, class Tag, std::size_t Extent>
+  std::span<const BaseType, Extent> as_underlying(
+      std::span<const Quantity<Units, BaseType, Tag>, Extent> qs) noexcept {
+    return std::span<const BaseType, Extent>{
+        Impl::underlying_data(qs.data()), qs.size()};
+  }
+
+  /** data, an array of values in Units, viewed as Quantities over the same
+   * memory, const if T is:
+   *
+   *   auto pressures = units::as_quantities<Pascals_t>(std::span{solution});
+   *
+   * The memory must not be accessed through data while it's in use as
+   * Quantities. */
+  template <class Units, class Tag = std::false_type, class T,
+            std::size_t Extent>
+  auto as_quantities(std::span<T, Extent> data) noexcept {
+    using BaseType = std::remove_const_t<T>;
+    using Q = std::conditional_t<std::is_const_v<T>,
+                                 const Quantity<Units, BaseType, Tag>,
+                                 Quantity<Units, BaseType, Tag>>;
+    Impl::check_underlying_layout<std::remove_const_t<Q>>();
+    return std::span<Q, Extent>{std::launder(reinterpret_cast<Q*>(data.data())),
+                                data.size()};
+  }
+} // namespace units
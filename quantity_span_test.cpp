@@ -0,0 +1,78 @@
+#include "common_quantities.hpp"
+#include "quantity_span.hpp"
+#include <catch.hpp>
+
+#include <cstdint>
+#include <numeric>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace {
+  struct Tagged {};
+
+  // a stand in for a C library, e.g. BLAS
+  void scale(double* x, std::size_t n, double factor) {
+    for (auto i = std::size_t{}; i < n; ++i) {
+      x[i] *= factor;
+    }
+  }
+} // namespace
+
+SCENARIO("Viewing Quantities as their underlying values and back") {
+  using namespace units;
+  GIVEN("the common Quantities") {
+    THEN("they all have the layout of their BaseType") {
+      static_assert(has_underlying_layout<metres>);
+      static_assert(has_underlying_layout<MPam05>);
+      static_assert(has_underlying_layout<Quantity<km_t, float, Tagged>>);
+      static_assert(has_underlying_layout<Quantity<seconds_t, std::int16_t>>);
+    }
+  }
+  GIVEN("an array of Quantities") {
+    auto ps = std::vector<Pascals>{Pascals{1}, Pascals{2}, Pascals{3}};
+    THEN("the values can be changed in place through a view") {
+      auto values = as_underlying(std::span{ps});
+      static_assert(std::is_same_v<decltype(values), std::span<double>>);
+      REQUIRE(values.data() == &ps[0].underlying_value());
+      scale(values.data(), values.size(), 2.0);
+      REQUIRE(ps == std::vector<Pascals>{Pascals{2}, Pascals{4}, Pascals{6}});
+    }
+    THEN("const Quantities give const values") {
+      const auto values = as_underlying(std::span{std::as_const(ps)});
+      static_assert(
+          std::is_same_v<decltype(values), const std::span<const double>>);
+      REQUIRE(std::accumulate(values.begin(), values.end(), 0.0) == 6);
+    }
+    THEN("fixed extents are kept") {
+      auto qs = std::array<km, 2>{km{1}, km{2}};
+      auto values = as_underlying(std::span{qs});
+      static_assert(decltype(values)::extent == 2);
+      REQUIRE(values[1] == 2);
+    }
+  }
+  GIVEN("an array of doubles") {
+    auto solution = std::vector<double>{1.5, 2.5};
+    THEN("it can be viewed as Quantities of any units") {
+      auto lengths = as_quantities<km_t>(std::span{solution});
+      static_assert(std::is_same_v<decltype(lengths), std::span<km>>);
+      REQUIRE(lengths[1] == km{2.5});
+      lengths[0] = km{4};
+      REQUIRE(solution[0] == 4);
+      const auto tagged =
+          as_quantities<metres_t, Tagged>(std::span{std::as_const(solution)});
+      static_assert(
+          std::is_same_v<decltype(tagged),
+                         const std::span<const Quantity<metres_t, double,
+                                                        Tagged>>>);
+      REQUIRE(tagged[1].underlying_value() == 2.5);
+    }
+    THEN("viewing back gives the same memory") {
+      auto times = as_quantities<seconds_t>(std::span{solution});
+      auto values = as_underlying(times);
+      REQUIRE(values.data() == solution.data());
+      REQUIRE(values.size() == 2);
+    }
+  }
+}
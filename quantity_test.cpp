@@ -1,7 +1,9 @@
 #include "common_quantities.hpp"
 #include "quantity.hpp"
 #include <catch.hpp>
+#include <cstdint>
 #include <iostream>
+#include <type_traits>
 
 SCENARIO("Testing tags") {
   GIVEN("Some simple tags") {
@@ -155,4 +157,68 @@ SCENARIO("Create some quantities of physical units") {
       }
     }
   }
-}
\ No newline at end of file
+}
+
+SCENARIO("Combining Quantities with different BaseTypes") {
+  using units::promoted_base_t;
+  using fmetres = Quantity<metres_t, float>;
+  using fkm = Quantity<km_t, float>;
+  GIVEN("float and double Quantities") {
+    const auto a = fmetres{1.5f};
+    const auto b = metres{2};
+    THEN("they are promoted to double") {
+      static_assert(std::is_same_v<promoted_base_t<float, double>, double>);
+      static_assert(std::is_same_v<decltype(a + b), metres>);
+      REQUIRE(a + b == metres{3.5});
+      REQUIRE(b - a == metres{0.5});
+      REQUIRE(fkm{1} - b == metres{998});
+      REQUIRE((a * Newtons{2}).underlying_value() == 3);
+      static_assert(std::is_same_v<decltype(a * Newtons{2}), Joules>);
+      REQUIRE(b / a == 4.0 / 3);
+      REQUIRE(a < b);
+      REQUIRE(b >= a);
+      REQUIRE(fkm{2} == metres{2000});
+      REQUIRE(a != b);
+    }
+    THEN("float samples can be accumulated in double") {
+      auto sum = metres{0};
+      for (auto i = 0; i < 10; ++i) {
+        sum += Quantity<mm_t, float>{0.1f};
+      }
+      REQUIRE(sum.underlying_value() ==
+              Approx(10 * static_cast<double>(0.1f) / 1000));
+      sum -= fkm{1};
+      REQUIRE(sum.underlying_value() == Approx(-999.999));
+    }
+  }
+  GIVEN("integral and floating point Quantities") {
+    using mm_int = Quantity<mm_t, std::int64_t>;
+    THEN("the integer is promoted to floating point") {
+      static_assert(std::is_same_v<decltype(mm_int{1} + metres{1}), metres>);
+      REQUIRE(mm_int{1500} + metres{1} == metres{2.5});
+      REQUIRE(Quantity<mm_t, std::int32_t>{2} + mm_int{3} == mm_int{5});
+    }
+    THEN("integer division scales the coarser numerator first") {
+      using km_int = Quantity<km_t, int>;
+      using m_int = Quantity<metres_t, int>;
+      using s_int = Quantity<seconds_t, std::int64_t>;
+      using ns_int = Quantity<nanoseconds_t, std::int64_t>;
+      const auto r = km_int{5} / m_int{2000};
+      static_assert(std::is_same_v<decltype(r)::Prefix, std::ratio<1>>);
+      REQUIRE(r.underlying_value() == 2);
+      REQUIRE((s_int{3} / ns_int{2}).underlying_value() == 1'500'000'000);
+      const auto q = m_int{2000} / km_int{5};
+      static_assert(std::is_same_v<decltype(q)::Prefix, std::milli>);
+      REQUIRE(q.underlying_value() == 400);
+    }
+    THEN("signed and unsigned don't mix, and nothing narrows implicitly") {
+      static_assert(!units::mixed_base_types_v<std::int32_t, std::uint32_t>);
+      static_assert(units::widens_to_v<double, float>);
+      static_assert(!units::widens_to_v<float, double>);
+      static_assert(units::widens_to_v<double, std::int32_t>);
+      static_assert(!units::widens_to_v<double, std::int64_t>);
+      static_assert(!units::widens_to_v<float, std::int32_t>);
+      static_assert(units::widens_to_v<float, std::int16_t>);
+    }
+  }
+}
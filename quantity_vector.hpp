@@ -0,0 +1,295 @@
+#pragma once
+
+#include "quantity.hpp"
+#include "quantity_expression.hpp"
+#include "quantity_span.hpp"
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace units {
+
+  /** Allocator that places every allocation on a cache line boundary, so the
+   * first element of a QuantityVector can always be loaded with aligned SIMD
+   * loads. */
+  template <class T, std::size_t Alignment = 64>
+  struct AlignedAllocator {
+    static_assert(Alignment >= alignof(T));
+    static_assert((Alignment & (Alignment - 1)) == 0,
+                  "Alignment must be a power of two");
+    using value_type = T;
+    static constexpr auto alignment = Alignment;
+
+    template <class U>
+    struct rebind {
+      using other = AlignedAllocator<U, Alignment>;
+    };
+
+    constexpr AlignedAllocator() noexcept = default;
+    template <class U>
+    constexpr AlignedAllocator(
+        const AlignedAllocator<U, Alignment>&) noexcept {}
+
+    T* allocate(std::size_t n) {
+      return static_cast<T*>(
+          ::operator new(n * sizeof(T), std::align_val_t{Alignment}));
+    }
+    void deallocate(T* p, std::size_t) noexcept {
+      ::operator delete(p, std::align_val_t{Alignment});
+    }
+
+    /// Default initialise rather than value initialise, so result buffers
+    /// that are about to be overwritten are not zeroed first.
+    template <class U>
+    void construct(U* p) noexcept(std::is_nothrow_default_constructible_v<U>) {
+      ::new (static_cast<void*>(p)) U;
+    }
+    template <class U, class... Args>
+    void construct(U* p, Args&&... args) {
+      ::new (static_cast<void*>(p)) U(std::forward<Args>(args)...);
+    }
+
+    template <class U>
+    constexpr bool
+    operator==(const AlignedAllocator<U, Alignment>&) const noexcept {
+      return true;
+    }
+    template <class U>
+    constexpr bool
+    operator!=(const AlignedAllocator<U, Alignment>&) const noexcept {
+      return false;
+    }
+  };
+
+  /// Result of the element-wise comparisons, one byte (0 or 1) per element so
+  /// that the comparison loops vectorize, which std::vector<bool> prevents.
+  using QuantityMask =
+      std::vector<std::uint8_t, AlignedAllocator<std::uint8_t>>;
+
+  namespace Impl {
+    /// Tag to create a QuantityVector without initialising its values.
+    struct uninitialised_t {};
+    inline constexpr auto uninitialised = uninitialised_t{};
+  } // namespace Impl
+
+  /*!
+   * \brief A contiguous, cache line aligned array of Quantities.
+   *
+   * \tparam Units A derived_t class that provides the units for every element.
+   * \tparam BaseType The underlying type, defaults to double.
+   * \tparam Tag A proxy to allow Quantities with the same dimensions to be
+   * distinguished.
+   *
+   * The element-wise operators (see quantity_expression.hpp) apply the same
+   * compile time dimension, tag and prefix rules as the scalar Quantity
+   * operators. They are evaluated lazily, the whole expression is computed in
+   * one branch free loop when it is assigned to a QuantityVector, with the
+   * prefixes folded into compile time constants. The compiler is then free to
+   * vectorize the loop for whatever instruction set the build targets (e.g.
+   * AVX2/AVX-512 with -march=native) and emits scalar code otherwise.
+   */
+  template <class Units, class BaseType_ = double,
+            class Tag_ = std::false_type>
+  class QuantityVector {
+  public:
+    using BaseType = BaseType_;
+    using Tag = Tag_;
+    using Prefix = typename Units::prefix;
+    using value_type = Quantity<Units, BaseType, Tag>;
+    using allocator_type = AlignedAllocator<value_type>;
+    using container_type = std::vector<value_type, allocator_type>;
+    using size_type = typename container_type::size_type;
+    using reference = typename container_type::reference;
+    using const_reference = typename container_type::const_reference;
+    using iterator = typename container_type::iterator;
+    using const_iterator = typename container_type::const_iterator;
+
+    QuantityVector() = default;
+    explicit QuantityVector(size_type n)
+        : _vals(n, value_type{BaseType{}}) {}
+    /// The values are left uninitialised, for buffers that a kernel is about
+    /// to write every element of.
+    QuantityVector(size_type n, Impl::uninitialised_t) : _vals(n) {}
+    QuantityVector(size_type n, const value_type& v) : _vals(n, v) {}
+    QuantityVector(std::initializer_list<value_type> l) : _vals(l) {}
+    template <class InputIt>
+    QuantityVector(InputIt first, InputIt last) : _vals(first, last) {}
+
+    /// Evaluate an expression, e.g. QuantityVector<Joules_t> e = m * v * v;
+    template <class Expr,
+              typename = std::enable_if_t<is_quantity_expression_v<Expr>>>
+    QuantityVector(const Expr& e) : _vals(e.size()) {
+      Impl::evaluate(data(), e, size());
+    }
+
+    template <class Expr,
+              typename = std::enable_if_t<is_quantity_expression_v<Expr>>>
+    QuantityVector& operator=(const Expr& e) {
+      _vals.resize(e.size());
+      Impl::evaluate(data(), e, size());
+      return *this;
+    }
+
+    size_type size() const noexcept { return _vals.size(); }
+    bool empty() const noexcept { return _vals.empty(); }
+    void resize(size_type n) { _vals.resize(n); }
+    void reserve(size_type n) { _vals.reserve(n); }
+    void clear() noexcept { _vals.clear(); }
+    void push_back(const value_type& v) { _vals.push_back(v); }
+
+    reference operator[](size_type i) noexcept { return _vals[i]; }
+    const_reference operator[](size_type i) const noexcept { return _vals[i]; }
+
+    iterator begin() noexcept { return _vals.begin(); }
+    iterator end() noexcept { return _vals.end(); }
+    const_iterator begin() const noexcept { return _vals.begin(); }
+    const_iterator end() const noexcept { return _vals.end(); }
+
+    value_type* data() noexcept { return _vals.data(); }
+    const value_type* data() const noexcept { return _vals.data(); }
+
+    /// The underlying values, in the units of this vector (not converted to a
+    /// prefix of unity).
+    BaseType* underlying_data() noexcept {
+      return Impl::underlying_data(_vals.data());
+    }
+    const BaseType* underlying_data() const noexcept {
+      return Impl::underlying_data(_vals.data());
+    }
+
+    template <class Expr,
+              typename = std::enable_if_t<is_quantity_expression_v<Expr>>>
+    QuantityVector& operator+=(const Expr& e) {
+      using Element = typename Expr::value_type;
+      static_assert(std::is_same_v<typename Element::Tag, Tag>);
+      static_assert(std::is_same_v<typename Element::BaseType, BaseType>);
+      assert(size() == e.size());
+      auto* out = underlying_data();
+      for (size_type i = 0; i < size(); ++i) {
+        out[i] += Impl::convert_element<Units>(e[i]).underlying_value();
+      }
+      return *this;
+    }
+
+    template <class Expr,
+              typename = std::enable_if_t<is_quantity_expression_v<Expr>>>
+    QuantityVector& operator-=(const Expr& e) {
+      using Element = typename Expr::value_type;
+      static_assert(std::is_same_v<typename Element::Tag, Tag>);
+      static_assert(std::is_same_v<typename Element::BaseType, BaseType>);
+      assert(size() == e.size());
+      auto* out = underlying_data();
+      for (size_type i = 0; i < size(); ++i) {
+        out[i] -= Impl::convert_element<Units>(e[i]).underlying_value();
+      }
+      return *this;
+    }
+
+    template <class Mult,
+              typename = std::enable_if_t<std::is_arithmetic_v<Mult>>>
+    QuantityVector& operator*=(const Mult& s) noexcept {
+      auto* out = underlying_data();
+      for (size_type i = 0; i < size(); ++i) {
+        out[i] *= s;
+      }
+      return *this;
+    }
+
+    template <class Div,
+              typename = std::enable_if_t<std::is_arithmetic_v<Div>>>
+    QuantityVector& operator/=(const Div& s) noexcept {
+      auto* out = underlying_data();
+      for (size_type i = 0; i < size(); ++i) {
+        out[i] /= s;
+      }
+      return *this;
+    }
+
+  private:
+    container_type _vals;
+
+    static_assert(units::is_dimensions(Units{}));
+  };
+
+  template <class Obj>
+  constexpr auto is_quantity_vector(Obj) {
+    return std::false_type{};
+  }
+
+  template <class Units, class BaseType, class Tag>
+  constexpr auto is_quantity_vector(QuantityVector<Units, BaseType, Tag>) {
+    return std::true_type{};
+  }
+
+  namespace Impl {
+    template <class Lhs, class Rhs, class Op>
+    QuantityMask comparison_operator(const Lhs& a, const Rhs& b, Op op) {
+      auto n = expression_size(a, b);
+      auto res = QuantityMask(n);
+      for (std::size_t i = 0; i < n; ++i) {
+        res[i] = op(element(a, i), element(b, i));
+      }
+      return res;
+    }
+  } // namespace Impl
+
+  // ************************************************************************* /
+  //    Element-wise comparisons of QuantityVectors or expressions, evaluated /
+  //    immediately into a mask of 0s and 1s                                  /
+  // ************************************************************************* /
+
+  template <
+      class Lhs, class Rhs,
+      typename = std::enable_if_t<Impl::is_expression_operands_v<Lhs, Rhs>>>
+  QuantityMask operator==(const Lhs& a, const Rhs& b) {
+    return Impl::comparison_operator(
+        a, b, [](const auto& x, const auto& y) { return x == y; });
+  }
+
+  template <
+      class Lhs, class Rhs,
+      typename = std::enable_if_t<Impl::is_expression_operands_v<Lhs, Rhs>>>
+  QuantityMask operator!=(const Lhs& a, const Rhs& b) {
+    return Impl::comparison_operator(
+        a, b, [](const auto& x, const auto& y) { return x != y; });
+  }
+
+  template <
+      class Lhs, class Rhs,
+      typename = std::enable_if_t<Impl::is_expression_operands_v<Lhs, Rhs>>>
+  QuantityMask operator<(const Lhs& a, const Rhs& b) {
+    return Impl::comparison_operator(
+        a, b, [](const auto& x, const auto& y) { return x < y; });
+  }
+
+  template <
+      class Lhs, class Rhs,
+      typename = std::enable_if_t<Impl::is_expression_operands_v<Lhs, Rhs>>>
+  QuantityMask operator<=(const Lhs& a, const Rhs& b) {
+    return Impl::comparison_operator(
+        a, b, [](const auto& x, const auto& y) { return x <= y; });
+  }
+
+  template <
+      class Lhs, class Rhs,
+      typename = std::enable_if_t<Impl::is_expression_operands_v<Lhs, Rhs>>>
+  QuantityMask operator>(const Lhs& a, const Rhs& b) {
+    return Impl::comparison_operator(
+        a, b, [](const auto& x, const auto& y) { return x > y; });
+  }
+
+  template <
+      class Lhs, class Rhs,
+      typename = std::enable_if_t<Impl::is_expression_operands_v<Lhs, Rhs>>>
+  QuantityMask operator>=(const Lhs& a, const Rhs& b) {
+    return Impl::comparison_operator(
+        a, b, [](const auto& x, const auto& y) { return x >= y; });
+  }
+
+} // namespace units
@@ -0,0 +1,85 @@
+#include "common_quantities.hpp"
+#include "quantity_vector.hpp"
+#include <catch.hpp>
+#include <cstdint>
+
+SCENARIO("Testing QuantityVector") {
+  using units::QuantityVector;
+  GIVEN("a vector of metres and a vector of km") {
+    auto m = QuantityVector<metres_t>{metres{1}, metres{2}, metres{3}};
+    auto k = QuantityVector<km_t>{km{1}, km{2}, km{3}};
+    THEN("the storage is cache line aligned") {
+      REQUIRE(reinterpret_cast<std::uintptr_t>(m.data()) % 64 == 0);
+      REQUIRE(reinterpret_cast<std::uintptr_t>(k.data()) % 64 == 0);
+    }
+    THEN("a QuantityVector is a QuantityVector") {
+      static_assert(decltype(units::is_quantity_vector(m))::value);
+      static_assert(!units::is_quantity_vector(metres{1}));
+    }
+    WHEN("adding and subtracting") {
+      auto sum = m + k;
+      auto diff = k - m;
+      THEN("the types match the scalar operators") {
+        static_assert(std::is_same_v<decltype(sum)::value_type,
+                                     decltype(metres{1} + km{1})>);
+        static_assert(std::is_same_v<decltype(diff)::value_type,
+                                     decltype(km{1} - metres{1})>);
+      }
+      THEN("the prefixes are accounted for") {
+        REQUIRE(sum.size() == 3);
+        REQUIRE(sum[0] == metres{1001});
+        REQUIRE(sum[2] == metres{3003});
+        REQUIRE(diff[1] == metres{1998});
+      }
+    }
+    WHEN("using += and -=") {
+      m += k;
+      THEN("the values are converted to the lhs prefix") {
+        REQUIRE(m[0] == metres{1001});
+        REQUIRE(m[1] == metres{2002});
+      }
+      m -= k;
+      THEN("and back again") { REQUIRE(m[2] == metres{3}); }
+    }
+    WHEN("multiplying and dividing") {
+      auto area = m * k;
+      auto ratio = k / m;
+      THEN("the types match the scalar operators") {
+        static_assert(std::is_same_v<decltype(area)::value_type, metres2>);
+        static_assert(std::is_same_v<decltype(ratio)::value_type,
+                                     decltype(km{1} / metres{1})>);
+      }
+      THEN("the prefixes are folded into the result") {
+        REQUIRE(area[1] == metres2{4000});
+        REQUIRE(ratio[2] == 1000.);
+      }
+    }
+    WHEN("scaling by a number") {
+      QuantityVector<metres_t> doubled = 2 * m;
+      QuantityVector<metres_t> halved = m / 2.;
+      m *= 3;
+      THEN("every element is scaled") {
+        REQUIRE(doubled[2] == metres{6});
+        REQUIRE(halved[0] == metres{0.5});
+        REQUIRE(m[1] == metres{6});
+        REQUIRE((-k)[0] == km{-1});
+      }
+    }
+    WHEN("comparing") {
+      auto small = QuantityVector<metres_t>{metres{999}, metres{2000},
+                                            metres{3001}};
+      THEN("the comparisons account for the prefix") {
+        auto lt = small < k;
+        auto eq = small == k;
+        auto ge = k >= small;
+        REQUIRE(lt[0] == 1);
+        REQUIRE(lt[1] == 0);
+        REQUIRE(lt[2] == 0);
+        REQUIRE(eq[1] == 1);
+        REQUIRE(eq[0] == 0);
+        REQUIRE(ge[0] == 1);
+        REQUIRE(ge[2] == 0);
+      }
+    }
+  }
+}
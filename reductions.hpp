@@ -0,0 +1,182 @@
+#pragma once
+
+#include "numeric_functions.hpp"
+#include "quantity.hpp"
+#include "quantity_cast.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <ranges>
+#include <span>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// ************************************************************************* /
+//    Sums, dot products and norms of ranges of Quantities, split across     /
+//    threads. The sums are of the underlying values, with the prefixes      /
+//    applied once to the result rather than to every element, and are       /
+//    optionally bitwise reproducible whatever the number of threads.        /
+// ************************************************************************* /
+
+namespace units {
+  struct ReduceOptions {
+    /// Threads to reduce on, 1 reduces on the calling thread
+    unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+    /// Sum in blocks of block_size, in an order that doesn't depend on the
+    /// number of threads, so the result is bitwise the same for any
+    bool reproducible = false;
+    /// Elements per block when reproducible, the result depends on it
+    std::size_t block_size = std::size_t{1} << 14;
+  };
+
+  namespace Impl {
+    /// Independent partial sums per thread, enough to keep the adders busy
+    /// and let the loop be vectorised without reassociating it
+    inline constexpr std::size_t reduce_lanes = 8;
+
+    /// Fewer elements than this per thread aren't worth starting one for
+    inline constexpr std::size_t reduce_min_per_thread = std::size_t{1} << 15;
+
+    /// The sum of f(i) over [first, last), in a fixed order
+    template <class T, class F>
+    T lane_sum(std::size_t first, std::size_t last, const F& f) {
+      T lanes[reduce_lanes]{};
+      auto i = first;
+      for (; i + reduce_lanes <= last; i += reduce_lanes) {
+#pragma GCC unroll 8
+        for (auto j = std::size_t{}; j < reduce_lanes; ++j) {
+          lanes[j] += f(i + j);
+        }
+      }
+      for (auto j = std::size_t{}; i < last; ++i, ++j) {
+        lanes[j] += f(i);
+      }
+      for (auto width = reduce_lanes / 2; width > 0; width /= 2) {
+        for (auto j = std::size_t{}; j < width; ++j) {
+          lanes[j] += lanes[j + width];
+        }
+      }
+      return lanes[0];
+    }
+
+    /// The sum of v pairwise, in an order that only depends on its size
+    template <class T>
+    T pairwise_sum(std::vector<T>& v) {
+      for (auto width = std::size_t{1}; width < v.size(); width *= 2) {
+        for (auto i = std::size_t{}; i + width < v.size(); i += 2 * width) {
+          v[i] += v[i + width];
+        }
+      }
+      return v.empty() ? T{} : v[0];
+    }
+
+    /// Call f(piece, first, last) for each of pieces contiguous parts of
+    /// [0, n), the first on the calling thread and the others on their own.
+    /// Nothing if there are no pieces, as for an empty reproducible sum.
+    template <class F>
+    void for_each_piece(std::size_t n, std::size_t pieces, const F& f) {
+      if (pieces == 0) {
+        return;
+      }
+      auto workers = std::vector<std::jthread>{};
+      workers.reserve(pieces - 1);
+      for (auto p = std::size_t{1}; p < pieces; ++p) {
+        workers.emplace_back([&f, n, pieces, p] {
+          f(p, n * p / pieces, n * (p + 1) / pieces);
+        });
+      }
+      f(0, 0, n / pieces);
+    }
+
+    /// The sum of f(i) over [0, n), split across threads
+    template <class T, class F>
+    T parallel_sum(std::size_t n, const ReduceOptions& options, const F& f) {
+      const auto threads = std::clamp<std::size_t>(
+          n / reduce_min_per_thread, 1, std::max(1u, options.threads));
+      if (options.reproducible) {
+        const auto block = std::max<std::size_t>(1, options.block_size);
+        auto partials = std::vector<T>((n + block - 1) / block);
+        for_each_piece(partials.size(), std::min(threads, partials.size()),
+                       [&](std::size_t, std::size_t first, std::size_t last) {
+                         for (auto b = first; b < last; ++b) {
+                           partials[b] = lane_sum<T>(
+                               b * block, std::min(n, (b + 1) * block), f);
+                         }
+                       });
+        return pairwise_sum(partials);
+      }
+      if (threads == 1) {
+        return lane_sum<T>(0, n, f);
+      }
+      auto partials = std::vector<T>(threads);
+      for_each_piece(n, threads, [&](std::size_t piece, std::size_t first,
+                                     std::size_t last) {
+        partials[piece] = lane_sum<T>(first, last, f);
+      });
+      return pairwise_sum(partials);
+    }
+
+    template <class R>
+    concept quantity_range =
+        std::ranges::contiguous_range<R> && std::ranges::sized_range<R> &&
+        decltype(is_quantity(std::ranges::range_value_t<R>{}))::value;
+
+    template <class R>
+    using range_traits = quantity_traits<std::ranges::range_value_t<R>>;
+  } // namespace Impl
+
+  /** The sum of the Quantities in xs, a contiguous range such as a
+   * std::vector or std::span, split across options.threads. For example
+   *
+   *   auto total = units::reduce(energies, {.reproducible = true});
+   *
+   * The sum is in lanes, and the lanes and the threads' sums added
+   * pairwise, so it's usually more accurate than std::accumulate too. */
+  template <Impl::quantity_range R>
+  auto reduce(const R& xs, const ReduceOptions& options = {}) {
+    using Q = std::ranges::range_value_t<R>;
+    using BaseType = typename Impl::range_traits<R>::BaseType;
+    const auto* data = std::ranges::data(xs);
+    return Q{Impl::parallel_sum<BaseType>(
+        std::ranges::size(xs), options,
+        [data](std::size_t i) { return data[i].underlying_value(); })};
+  }
+
+  /** The sum of the products of xs and ys, in the units of their product,
+   * e.g. metres and Newtons give Joules. The prefixes are applied to the
+   * sum, not to each product. Throws std::invalid_argument if they are
+   * different sizes. */
+  template <Impl::quantity_range R0, Impl::quantity_range R1>
+  auto dot(const R0& xs, const R1& ys, const ReduceOptions& options = {}) {
+    using Q0 = std::ranges::range_value_t<R0>;
+    using Q1 = std::ranges::range_value_t<R1>;
+    using Result = decltype(Q0{} * Q1{});
+    using BaseType = typename Impl::range_traits<R0>::BaseType;
+    if (std::ranges::size(xs) != std::ranges::size(ys)) {
+      throw std::invalid_argument("dot of ranges of different sizes");
+    }
+    const auto* x = std::ranges::data(xs);
+    const auto* y = std::ranges::data(ys);
+    const auto sum = Impl::parallel_sum<BaseType>(
+        std::ranges::size(xs), options, [x, y](std::size_t i) {
+          return x[i].underlying_value() * y[i].underlying_value();
+        });
+    if constexpr (std::is_integral_v<BaseType>) {
+      // integral products keep the prefixes in their type
+      return Result{sum};
+    } else {
+      return Result{scale_by<typename Q1::Prefix>(
+          scale_by<typename Q0::Prefix>(sum))};
+    }
+  }
+
+  /// The Euclidean norm of xs, in the units of the Quantities without a
+  /// prefix, e.g. metres for km.
+  template <Impl::quantity_range R>
+  auto norm(const R& xs, const ReduceOptions& options = {}) {
+    return std::sqrt(dot(xs, xs, options));
+  }
+} // namespace units
@@ -0,0 +1,117 @@
+#include "common_quantities.hpp"
+#include "reductions.hpp"
+#include <catch.hpp>
+
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <numeric>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+namespace {
+  bool bitwise_equal(double a, double b) {
+    return std::memcmp(&a, &b, sizeof(double)) == 0;
+  }
+} // namespace
+
+SCENARIO("Reducing ranges of Quantities") {
+  using namespace units;
+  GIVEN("lengths and forces") {
+    auto xs = std::vector<metres>{};
+    auto fs = std::vector<Newtons>{};
+    for (auto i = 0; i < 100'000; ++i) {
+      xs.push_back(metres{(i % 7) * 0.5});
+      fs.push_back(Newtons{(i % 3) * 2.0});
+    }
+    THEN("the sum is a length") {
+      const auto total = reduce(xs, {.threads = 1});
+      static_assert(std::is_same_v<decltype(total), const metres>);
+      REQUIRE(total.underlying_value() ==
+              Approx(std::accumulate(xs.begin(), xs.end(), metres{0})
+                         .underlying_value()));
+    }
+    THEN("the dot product is energy") {
+      const auto work = dot(xs, fs, {.threads = 4});
+      static_assert(std::is_same_v<decltype(work), const Joules>);
+      auto expected = 0.0;
+      for (auto i = std::size_t{}; i < xs.size(); ++i) {
+        expected += xs[i].underlying_value() * fs[i].underlying_value();
+      }
+      REQUIRE(work.underlying_value() == Approx(expected));
+    }
+    THEN("the norm is a length") {
+      const auto ys = std::vector<metres>{metres{3}, metres{4}};
+      REQUIRE(norm(ys) == metres{5});
+      REQUIRE(norm(std::span{xs}.first(0)) == metres{0});
+    }
+    THEN("empty ranges sum to zero, reproducibly or not") {
+      const auto none = std::vector<metres>{};
+      for (auto reproducible : {false, true}) {
+        const auto options = ReduceOptions{.reproducible = reproducible};
+        REQUIRE(reduce(none, options) == metres{0});
+        REQUIRE(dot(none, none, options) == metres2{0});
+        REQUIRE(norm(none, options) == metres{0});
+      }
+    }
+    THEN("ranges of different sizes throw") {
+      fs.pop_back();
+      REQUIRE_THROWS_AS(dot(xs, fs), std::invalid_argument);
+    }
+  }
+
+  GIVEN("Quantities with prefixes") {
+    const auto ds = std::vector<km>{km{1}, km{2}, km{3}};
+    THEN("the prefix is applied to the result") {
+      REQUIRE(reduce(ds) == km{6});
+      REQUIRE(dot(ds, ds) == metres2{14e6});
+      REQUIRE(norm(ds).underlying_value() == Approx(std::sqrt(14e6)));
+      using mm_int = Quantity<mm_t, std::int64_t>;
+      const auto ns = std::vector<mm_int>{mm_int{2}, mm_int{3}};
+      REQUIRE(reduce(ns) == mm_int{5});
+      REQUIRE(dot(ns, ns).underlying_value() == 13);
+    }
+  }
+
+  GIVEN("values that don't sum exactly") {
+    auto es = std::vector<Joules>{};
+    for (auto i = 0; i < 1'000'003; ++i) {
+      es.push_back(Joules{1.0 / (i + 1) * (i % 2 == 0 ? 1 : -1.000001)});
+    }
+    THEN("reproducible sums are bitwise the same for any number of threads") {
+      const auto one = reduce(es, {.threads = 1, .reproducible = true});
+      const auto d1 = dot(es, es, {.threads = 1, .reproducible = true});
+      for (auto threads = 2u; threads <= 31; ++threads) {
+        INFO(threads);
+        const auto many =
+            reduce(es, {.threads = threads, .reproducible = true});
+        REQUIRE(bitwise_equal(one.underlying_value(),
+                              many.underlying_value()));
+        const auto d = dot(es, es, {.threads = threads, .reproducible = true});
+        REQUIRE(bitwise_equal(d1.underlying_value(), d.underlying_value()));
+      }
+    }
+    THEN("other sums differ by rounding at most") {
+      const auto one = reduce(es, {.threads = 1});
+      const auto many = reduce(es, {.threads = 7});
+      REQUIRE(many.underlying_value() == Approx(one.underlying_value()));
+    }
+  }
+}
+
+SCENARIO("Profiling reductions", "[Profile]") {
+  GIVEN("a large mesh") {
+    auto es = std::vector<Joules>(10'000'000, Joules{0.5});
+    auto total = Joules{0};
+    BENCHMARK("std::accumulate") {
+      total += std::accumulate(es.begin(), es.end(), Joules{0});
+    }
+    BENCHMARK("reduce") { total += units::reduce(es); }
+    BENCHMARK("reduce reproducible") {
+      total += units::reduce(es, {.reproducible = true});
+    }
+    std::cout << total << "\n";
+  }
+}
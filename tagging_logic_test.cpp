@@ -3,7 +3,9 @@
 #include "common_units.hpp"
 #include <catch.hpp>
 
+#if __has_include(<boost/hana.hpp>)
 #include <boost/hana.hpp>
+#endif
 
 /*
 SCENARIO("Testing conversions of petrol between kg, litres, m^3 and kj") {
@@ -0,0 +1,887 @@
+#pragma once
+
+#include "derived_dimensions_impl.hpp"
+#include "prefixes.hpp"
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+
+// ************************************************************************* /
+//    Parsing unit strings at runtime, e.g. "kg m^2 s^-2", "MPa m^0.5" or    /
+//    "km/h", into a DimensionCode: the seven rational exponents and the     /
+//    exact scale (prefix) of the unit relative to SI. The parser is         /
+//    constexpr and doesn't allocate. format_unit goes the other way.        /
+// ************************************************************************* /
+
+namespace units {
+  /** The result of parse_unit. On failure ec is set and position is the
+   * offset in the string where parsing stopped. */
+  struct UnitParseResult {
+    DimensionCode code{};
+    std::errc ec{};
+    std::size_t position = 0;
+  };
+
+  namespace Impl {
+    struct UnitSymbol {
+      std::string_view symbol;
+      DimensionCode code;
+    };
+
+    /// The base units, with the symbols derived_dimensions_printing.hpp
+    /// prints, and some common derived ones. Mass is in grams so that kg, mg
+    /// etc are a prefix and a symbol like any other. The non-SI ones are
+    /// the symbols of the aliases in common_units.hpp.
+    inline constexpr UnitSymbol unit_symbols[] = {
+        {"m", {.length = 1}},
+        {"g", {.mass = 1, .prefix = {1, 1000}}},
+        {"s", {.time = 1}},
+        {"A", {.current = 1}},
+        {"K", {.temperature = 1}},
+        {"mol", {.amount = 1}},
+        {"cd", {.luminosity = 1}},
+        {"min", {.time = 1, .prefix = 60}},
+        {"h", {.time = 1, .prefix = 3600}},
+        {"d", {.time = 1, .prefix = 86'400}},
+        {"Hz", {.time = -1}},
+        {"N", {.length = 1, .mass = 1, .time = -2}},
+        {"Pa", {.length = -1, .mass = 1, .time = -2}},
+        {"J", {.length = 2, .mass = 1, .time = -2}},
+        {"W", {.length = 2, .mass = 1, .time = -3}},
+        {"C", {.time = 1, .current = 1}},
+        {"V", {.length = 2, .mass = 1, .time = -3, .current = -1}},
+        {"L", {.length = 3, .prefix = {1, 1000}}},
+        {"ha", {.length = 2, .prefix = 10'000}},
+        {"ac", {.length = 2, .prefix = {40'468'564'224, 10'000'000}}},
+        {"US gal", {.length = 3, .prefix = {37'854'118, 10'000'000'000}}},
+        {"imp gal", {.length = 3, .prefix = {454'609, 100'000'000}}},
+    };
+
+    struct PrefixSymbol {
+      std::string_view symbol;
+      Rational scale;
+    };
+
+    /// The prefixes in prefixes.hpp, micro as both u and the micro sign.
+    inline constexpr PrefixSymbol prefix_symbols[] = {
+        {"n", {nano::num, nano::den}},   {"u", {micro::num, micro::den}},
+        {"µ", {micro::num, micro::den}},
+        {"m", {milli::num, milli::den}}, {"c", {centi::num, centi::den}},
+        {"k", {kilo::num, kilo::den}},   {"M", {mega::num, mega::den}},
+        {"G", {giga::num, giga::den}},
+    };
+
+    constexpr std::string_view superscript_digits[] = {
+        "⁰", "¹", "²", "³", "⁴",
+        "⁵", "⁶", "⁷", "⁸", "⁹"};
+    constexpr std::string_view superscript_minus = "⁻";
+    constexpr std::string_view roots[] = {"√", "∛", "∜"};
+    constexpr std::string_view utf8_separators[] = {"·", "⋅"};
+    constexpr Rational root_powers[] = {{1, 2}, {1, 3}, {1, 4}};
+
+    constexpr auto intmax_max = std::numeric_limits<std::intmax_t>::max();
+
+    constexpr auto intmax_min = std::numeric_limits<std::intmax_t>::min();
+
+    // Overflow checked arithmetic, the operators on Rational assume the
+    // result fits, which is known at compile time but not for parsed input.
+    // INTMAX_MIN counts as an overflow so that every result can be negated.
+    constexpr bool checked_multiply(std::intmax_t a, std::intmax_t b,
+                                    std::intmax_t& out) {
+#if defined(__GNUC__)
+      return !__builtin_mul_overflow(a, b, &out) && out != intmax_min;
+#else
+      const auto abs_a = a < 0 ? -a : a;
+      const auto abs_b = b < 0 ? -b : b;
+      if (abs_a != 0 && abs_b > intmax_max / abs_a) {
+        return false;
+      }
+      out = a * b;
+      return true;
+#endif
+    }
+
+    constexpr bool checked_add(std::intmax_t a, std::intmax_t b,
+                               std::intmax_t& out) {
+#if defined(__GNUC__)
+      return !__builtin_add_overflow(a, b, &out) && out != intmax_min;
+#else
+      if ((b > 0 && a > intmax_max - b) || (b < 0 && a < -intmax_max - b)) {
+        return false;
+      }
+      out = a + b;
+      return true;
+#endif
+    }
+
+    constexpr bool checked_multiply_fractions(const Rational& a,
+                                              const Rational& b,
+                                              Rational& out) {
+      const auto g0 = std::gcd(a.num, b.den);
+      const auto g1 = std::gcd(b.num, a.den);
+      auto num = std::intmax_t{};
+      auto den = std::intmax_t{};
+      if (!checked_multiply(a.num / g0, b.num / g1, num) ||
+          !checked_multiply(a.den / g1, b.den / g0, den)) {
+        return false;
+      }
+      out = Rational{num, den};
+      return true;
+    }
+
+    constexpr bool checked_add_fractions(const Rational& a, const Rational& b,
+                                         Rational& out) {
+      const auto g = std::gcd(a.den, b.den);
+      auto den = std::intmax_t{};
+      auto num0 = std::intmax_t{};
+      auto num1 = std::intmax_t{};
+      auto num = std::intmax_t{};
+      if (!checked_multiply(a.den / g, b.den, den) ||
+          !checked_multiply(a.num, b.den / g, num0) ||
+          !checked_multiply(b.num, a.den / g, num1) ||
+          !checked_add(num0, num1, num)) {
+        return false;
+      }
+      out = Rational{num, den};
+      return true;
+    }
+
+    // The common cases, zero or integer exponents and integer prefixes, skip
+    // the gcds and divisions of normalising a Rational.
+    constexpr bool checked_multiply(const Rational& a, const Rational& b,
+                                    Rational& out) {
+      if (a.num == 0 || b.num == 0) {
+        out = Rational{};
+        return true;
+      }
+      if (a.den == 1 && b.den == 1) {
+        out.den = 1;
+        return checked_multiply(a.num, b.num, out.num);
+      }
+      return checked_multiply_fractions(a, b, out);
+    }
+
+    constexpr bool checked_add(const Rational& a, const Rational& b,
+                               Rational& out) {
+      if (b.num == 0) {
+        out = a;
+        return true;
+      }
+      if (a.den == 1 && b.den == 1) {
+        out.den = 1;
+        return checked_add(a.num, b.num, out.num);
+      }
+      return checked_add_fractions(a, b, out);
+    }
+
+    /// v^n for n >= 0, by squaring, so a huge n fails or ends quickly.
+    constexpr bool checked_power(std::intmax_t v, std::intmax_t n,
+                                 std::intmax_t& out) {
+      auto result = std::intmax_t{1};
+      auto base = v;
+      while (n > 0) {
+        if (n % 2 == 1 && !checked_multiply(result, base, result)) {
+          return false;
+        }
+        n /= 2;
+        // base^2 is a factor of the result while any of n is left
+        if (n > 0 && !checked_multiply(base, base, base)) {
+          return false;
+        }
+      }
+      out = result;
+      return true;
+    }
+
+    /// The exact n'th root of v >= 0, if v is a perfect power. Only 0 and 1
+    /// have roots of degree 64 and above, as 2^63 overflows intmax_t.
+    constexpr bool exact_root(std::intmax_t v, std::intmax_t n,
+                              std::intmax_t& out) {
+      if (v == 0 || v == 1) {
+        out = v;
+        return true;
+      }
+      if (n > std::numeric_limits<std::intmax_t>::digits) {
+        return false;
+      }
+      auto lo = std::intmax_t{1};
+      auto hi = v;
+      while (lo <= hi) {
+        const auto mid = lo + (hi - lo) / 2;
+        auto p = std::intmax_t{};
+        if (!checked_power(mid, n, p) || p > v) {
+          hi = mid - 1;
+        } else if (p < v) {
+          lo = mid + 1;
+        } else {
+          out = mid;
+          return true;
+        }
+      }
+      return false;
+    }
+
+    /// scale^power, which is only exact (and so allowed) if the roots of
+    /// a fractional power are integers, e.g. (10^6)^(1/2).
+    constexpr bool checked_power(const Rational& scale, const Rational& power,
+                                 Rational& out) {
+      if (scale.num == scale.den) {
+        out = scale;
+        return true;
+      }
+      auto num = scale.num;
+      auto den = scale.den;
+      if (power.den != 1 && (!exact_root(num, power.den, num) ||
+                             !exact_root(den, power.den, den))) {
+        return false;
+      }
+      const auto n = power.num < 0 ? -power.num : power.num;
+      if (!checked_power(num, n, num) || !checked_power(den, n, den)) {
+        return false;
+      }
+      out = power.num < 0 ? Rational{den, num} : Rational{num, den};
+      return true;
+    }
+
+    // Prefixes keep powers of ten in their exponent, so e.g. "Gm^9" or
+    // "1e30 m" are exact, and only fail if the mantissa overflows or the
+    // exponent is beyond any BaseType.
+    constexpr bool checked_multiply(const PrefixValue& a, const PrefixValue& b,
+                                    PrefixValue& out) {
+      if (a.is_ratio() && b.is_ratio() && a.den == 1 && b.den == 1) {
+        auto num = std::intmax_t{};
+        if (checked_multiply(a.num, b.num, num)) {
+          out = PrefixValue{num};
+          return true;
+        }
+      }
+      return multiply_prefixes(a, b, out) &&
+             out.exponent <= max_prefix_exponent &&
+             out.exponent >= -max_prefix_exponent;
+    }
+
+    /// scale^power, as for a Rational scale. A root also takes the root of
+    /// the power of ten, so it must divide the exponent.
+    constexpr bool checked_power(const PrefixValue& scale,
+                                 const Rational& power, PrefixValue& out) {
+      if (scale == PrefixValue{1}) {
+        out = scale;
+        return true;
+      }
+      auto base = scale;
+      if (power.den != 1) {
+        auto r = Rational{};
+        if (scale.exponent % power.den != 0 ||
+            !checked_power(Rational{scale.num, scale.den},
+                           Rational{1, power.den}, r) ||
+            !checked_multiply(
+                r,
+                PrefixValue{1, 1,
+                            static_cast<int>(scale.exponent / power.den)},
+                base)) {
+          return false;
+        }
+      }
+      // by squaring, as for intmax_t
+      auto p = PrefixValue{1};
+      for (auto n = power.num < 0 ? -power.num : power.num; n > 0;) {
+        if (n % 2 == 1 && !checked_multiply(p, base, p)) {
+          return false;
+        }
+        n /= 2;
+        if (n > 0 && !checked_multiply(base, base, base)) {
+          return false;
+        }
+      }
+      if (power.num < 0) {
+        return multiply_prefixes(PrefixValue{1}, reciprocal(p), out);
+      }
+      out = p;
+      return true;
+    }
+
+    constexpr bool checked_multiply(const DimensionCode& a,
+                                    const DimensionCode& b,
+                                    DimensionCode& out) {
+      return checked_add(a.length, b.length, out.length) &&
+             checked_add(a.mass, b.mass, out.mass) &&
+             checked_add(a.time, b.time, out.time) &&
+             checked_add(a.current, b.current, out.current) &&
+             checked_add(a.temperature, b.temperature, out.temperature) &&
+             checked_add(a.amount, b.amount, out.amount) &&
+             checked_add(a.luminosity, b.luminosity, out.luminosity) &&
+             checked_multiply(a.prefix, b.prefix, out.prefix);
+    }
+
+    constexpr bool checked_power(const DimensionCode& code,
+                                 const Rational& power, DimensionCode& out) {
+      return checked_multiply(code.length, power, out.length) &&
+             checked_multiply(code.mass, power, out.mass) &&
+             checked_multiply(code.time, power, out.time) &&
+             checked_multiply(code.current, power, out.current) &&
+             checked_multiply(code.temperature, power, out.temperature) &&
+             checked_multiply(code.amount, power, out.amount) &&
+             checked_multiply(code.luminosity, power, out.luminosity) &&
+             checked_power(code.prefix, power, out.prefix);
+    }
+
+    constexpr bool is_digit(char c) { return c >= '0' && c <= '9'; }
+
+    /// The first byte of a multi-byte UTF-8 character, all of the
+    /// superscripts, roots and the micro sign start with one.
+    constexpr bool is_utf8_lead(char c) {
+      return static_cast<unsigned char>(c) >= 0xC0;
+    }
+
+    constexpr bool is_letter(char c) {
+      return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+    }
+
+    // Comparing the first byte before calling memcmp makes the symbol
+    // lookups several times faster.
+    constexpr bool starts_with(std::string_view s, std::string_view prefix) {
+      return s.size() >= prefix.size() && !s.empty() && s[0] == prefix[0] &&
+             s.substr(0, prefix.size()) == prefix;
+    }
+
+    constexpr const UnitSymbol* find_symbol(std::string_view word) {
+      for (const auto& u : unit_symbols) {
+        if (word.size() == u.symbol.size() && starts_with(word, u.symbol)) {
+          return &u;
+        }
+      }
+      return nullptr;
+    }
+
+    /** Recursive descent parser for the grammar in the doc of parse_unit.
+     * Stops at the first error, recording it and the position. */
+    class UnitParser {
+    public:
+      constexpr explicit UnitParser(std::string_view text) : _text{text} {}
+
+      constexpr UnitParseResult parse() {
+        auto code = DimensionCode{};
+        skip_separators();
+        if (_pos < _text.size() && (is_digit(_text[_pos]) ||
+                                    _text[_pos] == '.')) {
+          number(code.prefix);
+          if (ok() && _pos + 1 < _text.size() && _text[_pos] == '/' &&
+              is_digit(_text[_pos + 1])) {
+            // a fraction, e.g. "5/18 m/s"
+            ++_pos;
+            const auto den = integer();
+            if (ok() && den == 0) {
+              fail(std::errc::invalid_argument);
+            }
+            if (ok()) {
+              checked(checked_multiply(code.prefix, PrefixValue{1, den},
+                                       code.prefix));
+            }
+          }
+          if (ok() && code.prefix.num == 0) {
+            fail(std::errc::invalid_argument);
+          }
+        }
+        auto units = product(0);
+        if (ok()) {
+          checked(checked_multiply(code, units, code));
+        }
+        if (ok() && _pos != _text.size()) {
+          fail(std::errc::invalid_argument);
+        }
+        return {ok() ? code : DimensionCode{}, _ec, _pos};
+      }
+
+    private:
+      static constexpr int max_depth = 16;
+
+      std::string_view _text;
+      std::size_t _pos = 0;
+      std::errc _ec{};
+
+      constexpr bool ok() const { return _ec == std::errc{}; }
+
+      constexpr void fail(std::errc ec) {
+        if (ok()) {
+          _ec = ec;
+        }
+      }
+
+      /// Record an overflow if a checked operation failed
+      constexpr void checked(bool success) {
+        if (!success) {
+          fail(std::errc::result_out_of_range);
+        }
+      }
+
+      constexpr bool consume(char c) {
+        if (_pos < _text.size() && _text[_pos] == c) {
+          ++_pos;
+          return true;
+        }
+        return false;
+      }
+
+      constexpr bool consume(std::string_view s) {
+        if (_text.substr(_pos, s.size()) == s) {
+          _pos += s.size();
+          return true;
+        }
+        return false;
+      }
+
+      constexpr void skip_separators() {
+        while (_pos < _text.size()) {
+          const auto c = _text[_pos];
+          if (c == ' ' || c == '\t' || c == '*') {
+            ++_pos;
+          } else if (!is_utf8_lead(c) || !(consume(utf8_separators[0]) ||
+                                           consume(utf8_separators[1]))) {
+            return;
+          }
+        }
+      }
+
+      constexpr std::intmax_t integer() {
+        if (_pos == _text.size() || !is_digit(_text[_pos])) {
+          fail(std::errc::invalid_argument);
+          return 0;
+        }
+        auto v = std::intmax_t{0};
+        for (; _pos < _text.size() && is_digit(_text[_pos]); ++_pos) {
+          checked(checked_multiply(v, 10, v) &&
+                  checked_add(v, _text[_pos] - '0', v));
+        }
+        return v;
+      }
+
+      /// An exact decimal, e.g. 1000, 0.5, 1e-3 or 1e30
+      constexpr void number(PrefixValue& out) {
+        auto num = std::intmax_t{0};
+        auto den = std::intmax_t{1};
+        auto digits = false;
+        for (; _pos < _text.size() && is_digit(_text[_pos]); ++_pos) {
+          digits = true;
+          checked(checked_multiply(num, 10, num) &&
+                  checked_add(num, _text[_pos] - '0', num));
+        }
+        if (consume('.')) {
+          for (; _pos < _text.size() && is_digit(_text[_pos]); ++_pos) {
+            digits = true;
+            checked(checked_multiply(num, 10, num) &&
+                    checked_add(num, _text[_pos] - '0', num) &&
+                    checked_multiply(den, 10, den));
+          }
+        }
+        if (!digits) {
+          fail(std::errc::invalid_argument);
+          return;
+        }
+        auto exponent = std::intmax_t{};
+        if (consume('e') || consume('E')) {
+          const auto negative = consume('-');
+          if (!negative) {
+            consume('+');
+          }
+          exponent = integer();
+          checked(exponent <= max_prefix_exponent);
+          exponent = negative ? -exponent : exponent;
+        }
+        if (ok()) {
+          const auto g = std::gcd(num, den);
+          checked(normalise_prefix(magnitude(num / g), magnitude(den / g),
+                                   static_cast<int>(exponent), false, out));
+        }
+      }
+
+      /// As above for a power, which must fit in a Rational.
+      constexpr void number(Rational& out) {
+        auto p = PrefixValue{};
+        number(p);
+        checked(p.is_ratio());
+        if (ok()) {
+          out = Rational{p.num, p.den};
+        }
+      }
+
+      /// A signed number or a bracketed fraction, after a '^'
+      constexpr Rational power() {
+        auto p = Rational{};
+        if (consume('(')) {
+          const auto negative = consume('-');
+          const auto num = integer();
+          if (!consume('/')) {
+            fail(std::errc::invalid_argument);
+          }
+          const auto den = integer();
+          if (!consume(')') || den == 0) {
+            fail(std::errc::invalid_argument);
+          }
+          if (ok()) {
+            p = Rational{negative ? -num : num, den};
+          }
+        } else {
+          const auto negative = consume('-');
+          if (!negative) {
+            consume('+');
+          }
+          number(p);
+          p = negative ? -p : p;
+        }
+        return p;
+      }
+
+      constexpr bool superscript_digit(std::intmax_t& v) {
+        for (auto d = 0; d < 10; ++d) {
+          if (consume(superscript_digits[d])) {
+            checked(checked_multiply(v, 10, v) && checked_add(v, d, v));
+            return true;
+          }
+        }
+        return false;
+      }
+
+      constexpr bool superscript(Rational& p) {
+        if (_pos == _text.size() || !is_utf8_lead(_text[_pos])) {
+          return false;
+        }
+        const auto negative = consume(superscript_minus);
+        auto v = std::intmax_t{0};
+        auto digits = false;
+        while (superscript_digit(v)) {
+          digits = true;
+        }
+        if (negative && !digits) {
+          fail(std::errc::invalid_argument);
+        }
+        p = Rational{negative ? -v : v};
+        return digits;
+      }
+
+      /// A unit symbol with an optional prefix, e.g. "km", "mol" or "MPa".
+      /// Whole symbols are matched before prefixed ones, so "min" is minutes
+      /// and "mm" is millimetres.
+      constexpr DimensionCode symbol() {
+        const auto start = _pos;
+        if (_pos < _text.size() && is_utf8_lead(_text[_pos])) {
+          // the micro sign is two bytes of UTF-8, not a letter
+          consume("µ");
+        }
+        while (_pos < _text.size() && is_letter(_text[_pos])) {
+          ++_pos;
+        }
+        const auto word = _text.substr(start, _pos - start);
+        if (const auto* u = find_symbol(word)) {
+          return u->code;
+        }
+        // the two word symbols, e.g. "US gal"
+        const auto rest = _text.substr(start);
+        for (const auto& u : unit_symbols) {
+          const auto n = u.symbol.size();
+          if (n > word.size() && u.symbol[word.size()] == ' ' &&
+              starts_with(rest, u.symbol) &&
+              (rest.size() == n || !is_letter(rest[n]))) {
+            _pos = start + n;
+            return u.code;
+          }
+        }
+        for (const auto& p : prefix_symbols) {
+          if (!starts_with(word, p.symbol)) {
+            continue;
+          }
+          if (const auto* u = find_symbol(word.substr(p.symbol.size()))) {
+            auto code = u->code;
+            checked(checked_multiply(code.prefix, p.scale, code.prefix));
+            return code;
+          }
+        }
+        _pos = start;
+        fail(std::errc::invalid_argument);
+        return {};
+      }
+
+      constexpr DimensionCode factor(int depth) {
+        auto code = DimensionCode{};
+        auto p = Rational{1};
+        if (consume('(')) {
+          code = product(depth + 1);
+          if (!consume(')')) {
+            fail(std::errc::invalid_argument);
+          }
+        } else {
+          if (_pos < _text.size() && is_utf8_lead(_text[_pos])) {
+            for (auto i = 0; i < 3; ++i) {
+              p = consume(roots[i]) ? root_powers[i] : p;
+            }
+          }
+          code = symbol();
+        }
+        auto sp = Rational{};
+        if (consume('^')) {
+          const auto e = power();
+          checked(checked_multiply(p, e, p));
+        } else if (superscript(sp)) {
+          checked(checked_multiply(p, sp, p));
+        }
+        if (ok() && !(p.num == 1 && p.den == 1)) {
+          checked(checked_power(code, p, code));
+        }
+        return code;
+      }
+
+      constexpr DimensionCode product(int depth) {
+        auto code = DimensionCode{};
+        if (depth > max_depth) {
+          fail(std::errc::invalid_argument);
+          return code;
+        }
+        skip_separators();
+        while (ok() && _pos < _text.size() && _text[_pos] != ')') {
+          const auto divide = consume('/');
+          skip_separators();
+          auto f = factor(depth);
+          if (divide && ok()) {
+            checked(checked_power(f, Rational{-1}, f));
+          }
+          if (ok()) {
+            checked(checked_multiply(code, f, code));
+          }
+          skip_separators();
+        }
+        return code;
+      }
+    };
+  } // namespace Impl
+
+  /** Parse a unit string such as "kg m^2 s^-2", "MPa m^0.5", "km/h" or
+   * "1e-3 m" into the exponents of the seven base dimensions and the exact
+   * scale relative to SI, e.g. km/h gives length 1, time -1 and a prefix of
+   * 5/18. The grammar is
+   *
+   *   unit     := [number ["/" integer]] product
+   *   product  := { ["*" | "/" | " " | "·" | "⋅"] factor }
+   *   factor   := ("(" product ")" | ["√" | "∛" | "∜"] symbol) [exponent]
+   *   exponent := "^" (number | "(" integer "/" integer ")")
+   *             | superscript digits, e.g. "s⁻¹"
+   *
+   * where a "/" divides by the factor after it only, so "W/m K" is W K m^-1
+   * and W/(m K) needs the brackets. An empty string is dimensionless.
+   *
+   * Returns std::errc::invalid_argument for unknown symbols or bad syntax,
+   * and std::errc::result_out_of_range if the scale or an exponent
+   * overflows, or the scale would be irrational (e.g. km^0.5). */
+  constexpr UnitParseResult parse_unit(std::string_view text) noexcept {
+    return Impl::UnitParser{text}.parse();
+  }
+
+  /// True if text parses to exactly the dimensions and prefix of Units.
+  template <class Units>
+  constexpr bool unit_matches(std::string_view text) noexcept {
+    const auto result = parse_unit(text);
+    return result.ec == std::errc{} && result.code == Units::code;
+  }
+
+  /// How format_unit writes powers and separates the units
+  enum class UnitStyle {
+    ascii,   ///< "kg m^2 s^-2"
+    unicode, ///< "kg·m²·s⁻²"
+    si,      ///< "kg m² s⁻²", as the SI brochure writes them
+  };
+
+  namespace Impl {
+    /// A fixed capacity string, so unit strings can be built at compile time
+    struct UnitString {
+      static constexpr std::size_t capacity = 384;
+      char data[capacity] = {};
+      std::size_t size = 0;
+
+      constexpr void append(std::string_view s) {
+        assert(size + s.size() <= capacity);
+        for (auto c : s) {
+          data[size++] = c;
+        }
+      }
+
+      constexpr void append(std::intmax_t v) {
+        if (v < 0) {
+          append("-");
+        }
+        char digits[20] = {};
+        auto n = 0;
+        // negate each digit rather than v, which may be INTMAX_MIN
+        for (; n == 0 || v != 0; v /= 10) {
+          const auto d = v % 10;
+          digits[n++] = static_cast<char>('0' + (d < 0 ? -d : d));
+        }
+        for (; n > 0; --n) {
+          append(std::string_view{&digits[n - 1], 1});
+        }
+      }
+
+      constexpr std::string_view view() const { return {data, size}; }
+    };
+
+    /** The scale as a number that parses back exactly: an integer or
+     * decimal, e.g. "60", "1e6" or "1e-3", if there is one that fits, and
+     * otherwise the fraction, e.g. "5/18". */
+    constexpr void append_scale(UnitString& s, const PrefixValue& scale) {
+      auto num = scale.num;
+      auto den = scale.den;
+      auto exponent = std::intmax_t{scale.exponent};
+      for (; den != 1; --exponent) {
+        const auto factor = den % 10 == 0 ? 1
+                            : den % 2 == 0  ? 5
+                            : den % 5 == 0  ? 2
+                                            : 0;
+        if (factor == 0 || !checked_multiply(num, factor, num)) {
+          s.append(scale.num);
+          if (scale.exponent != 0) {
+            s.append("e");
+            s.append(std::intmax_t{scale.exponent});
+          }
+          s.append("/");
+          s.append(scale.den);
+          return;
+        }
+        den /= 10 / factor;
+      }
+      auto zeros = 0;
+      for (auto n = num; n % 10 == 0; n /= 10) {
+        ++zeros;
+      }
+      if (exponent < 0 || zeros >= 3) {
+        for (; zeros > 0; --zeros) {
+          num /= 10;
+          ++exponent;
+        }
+      }
+      s.append(num);
+      if (exponent != 0) {
+        s.append("e");
+        s.append(exponent);
+      }
+    }
+
+    constexpr void append_power(UnitString& s, std::string_view symbol,
+                                const Rational& e, UnitStyle style) {
+      const auto root = style != UnitStyle::ascii && e.num == 1 &&
+                        e.den >= 2 && e.den <= 4;
+      if (root) {
+        s.append(roots[e.den - 2]);
+      }
+      s.append(symbol);
+      if (root || e == Rational{1}) {
+        return;
+      }
+      if (e.den != 1) {
+        s.append("^(");
+        s.append(e.num);
+        s.append("/");
+        s.append(e.den);
+        s.append(")");
+      } else if (style == UnitStyle::ascii) {
+        s.append("^");
+        s.append(e.num);
+      } else {
+        if (e.num < 0) {
+          s.append(superscript_minus);
+        }
+        auto digits = UnitString{};
+        digits.append(e.num < 0 ? -e.num : e.num);
+        for (auto c : digits.view()) {
+          s.append(superscript_digits[c - '0']);
+        }
+      }
+    }
+
+    /// A single symbol, e.g. "Pa" or "min", or a prefixed one, e.g. "km",
+    /// if one parses back to code.
+    constexpr bool append_symbol(UnitString& s, const DimensionCode& code,
+                                 UnitStyle style) {
+      for (const auto& u : unit_symbols) {
+        if (!u.code.same_dimension(code)) {
+          continue;
+        }
+        if (u.code == code) {
+          s.append(u.symbol);
+          return true;
+        }
+        if (code.prefix == Rational{1}) {
+          // the base units, e.g. m^3 rather than kL
+          continue;
+        }
+        for (const auto& p : prefix_symbols) {
+          // µ, rather than u, unless it has to be ASCII
+          if (p.symbol == (style == UnitStyle::ascii ? "µ" : "u") ||
+              u.code.prefix * p.scale != code.prefix) {
+            continue;
+          }
+          auto candidate = UnitString{};
+          candidate.append(p.symbol);
+          candidate.append(u.symbol);
+          if (parse_unit(candidate.view()).code == code) {
+            s.append(candidate.view());
+            return true;
+          }
+        }
+      }
+      return false;
+    }
+
+    constexpr UnitString format_unit_string(const DimensionCode& code,
+                                            UnitStyle style) {
+      auto s = UnitString{};
+      if (append_symbol(s, code, style)) {
+        return s;
+      }
+      if (code.prefix != Rational{1}) {
+        append_scale(s, code.prefix);
+      }
+      const std::pair<std::string_view, Rational> bases[] = {
+          {"m", code.length},   {"kg", code.mass},
+          {"s", code.time},     {"A", code.current},
+          {"K", code.temperature}, {"mol", code.amount},
+          {"cd", code.luminosity}};
+      auto first = true;
+      for (const auto& [symbol, exponent] : bases) {
+        if (exponent.num == 0) {
+          continue;
+        }
+        if (s.size != 0) {
+          s.append(first || style != UnitStyle::unicode ? " " : "·");
+        }
+        first = false;
+        append_power(s, symbol, exponent, style);
+      }
+      return s;
+    }
+  } // namespace Impl
+
+  /** The inverse of parse_unit, a unit string that parses back to exactly
+   * code. A single symbol if one matches, e.g. "km", "Pa" or "min",
+   * otherwise the base units after the scale, e.g. "kg m^2 s^-2",
+   * "1e-3 m^(1/2)" or "5/18 m s^-1" in the ASCII style. */
+  inline std::string format_unit(const DimensionCode& code,
+                                 UnitStyle style = UnitStyle::ascii) {
+    return std::string{Impl::format_unit_string(code, style).view()};
+  }
+
+  static_assert(parse_unit("km/h").code ==
+                DimensionCode{.length = 1, .time = -1, .prefix = {5, 18}});
+  static_assert(parse_unit("kg m^2 s^-2").code ==
+                DimensionCode{.length = 2, .mass = 1, .time = -2});
+  static_assert(parse_unit("MPa m^0.5").code ==
+                DimensionCode{.length = {-1, 2},
+                              .mass = 1,
+                              .time = -2,
+                              .prefix = 1'000'000});
+  static_assert(parse_unit("m s⁻¹").code ==
+                DimensionCode{.length = 1, .time = -1});
+  static_assert(parse_unit("bogus").ec == std::errc::invalid_argument);
+} // namespace units
@@ -0,0 +1,202 @@
+#include "common_quantities.hpp"
+#include "unit_parser.hpp"
+#include <catch.hpp>
+
+#include <iostream>
+#include <string>
+#include <system_error>
+#include <vector>
+
+SCENARIO("Parsing unit strings at runtime") {
+  using namespace units;
+  GIVEN("the units of the common quantities") {
+    THEN("they parse to the same DimensionCode as the compile time types") {
+      REQUIRE(unit_matches<metres_t>("m"));
+      REQUIRE(unit_matches<km_t>("km"));
+      REQUIRE(unit_matches<mm_t>("mm"));
+      REQUIRE(unit_matches<kg_t>("kg"));
+      REQUIRE(unit_matches<seconds_t>("s"));
+      REQUIRE(unit_matches<nanoseconds_t>("ns"));
+      REQUIRE(unit_matches<hours_t>("h"));
+      REQUIRE(unit_matches<metres_per_sec_t>("m/s"));
+      REQUIRE(unit_matches<metres_per_sec2_t>("m s^-2"));
+      REQUIRE(unit_matches<Joules_t>("kg m^2 s^-2"));
+      REQUIRE(unit_matches<Joules_t>("J"));
+      REQUIRE(unit_matches<Watts_t>("J/s"));
+      REQUIRE(unit_matches<Newtons_t>("kg*m/s^2"));
+      REQUIRE(unit_matches<Pascals_t>("N/m^2"));
+      REQUIRE(unit_matches<MPam05_t>("MPa m^0.5"));
+      REQUIRE(unit_matches<MPam05_t>("MPa m^(1/2)"));
+      REQUIRE(unit_matches<MPam05_t>("MPa √m"));
+      REQUIRE(unit_matches<litres_t>("L"));
+    }
+    THEN("they don't match other units") {
+      REQUIRE(!unit_matches<km_t>("m"));
+      REQUIRE(!unit_matches<Joules_t>("kg m^2 s^-3"));
+    }
+  }
+
+  GIVEN("units with a scale that isn't a prefix") {
+    THEN("the scale is exact") {
+      auto r = parse_unit("km/h");
+      REQUIRE(r.ec == std::errc{});
+      REQUIRE(r.code.length == Rational{1});
+      REQUIRE(r.code.time == Rational{-1});
+      REQUIRE(r.code.prefix == Rational{5, 18});
+      REQUIRE(parse_unit("min").code.prefix == Rational{60});
+      REQUIRE(parse_unit("km^2").code.prefix == Rational{1'000'000});
+      REQUIRE(parse_unit("√Mm").code.prefix == Rational{1000});
+    }
+    THEN("a leading number multiplies the scale") {
+      REQUIRE(parse_unit("1000 m").code == parse_unit("km").code);
+      REQUIRE(parse_unit("1e-3 m").code == parse_unit("mm").code);
+      REQUIRE(parse_unit("0.5 s").code.prefix == Rational{1, 2});
+      REQUIRE(parse_unit("2.5e2 s").code.prefix == Rational{250});
+    }
+  }
+
+  GIVEN("the different ways of writing products and powers") {
+    const auto joules = parse_unit("kg m^2 s^-2").code;
+    THEN("they all give the same result") {
+      for (auto s : {"kg*m^2*s^-2", "kg·m²·s⁻²", "kg⋅m^2/s^2",
+                     "  kg  m^+2 s^-2 ", "kg (m/s)^2", "N m", "W s",
+                     "kg m^2 / s / s", "(kg^-1 m^-2 s^2)^-1"}) {
+        auto r = parse_unit(s);
+        INFO(s);
+        REQUIRE(r.ec == std::errc{});
+        REQUIRE(r.code == joules);
+      }
+    }
+    THEN("a / only divides by the factor after it") {
+      REQUIRE(parse_unit("W/m K").code == parse_unit("W K m^-1").code);
+      REQUIRE(parse_unit("W/(m K)").code == parse_unit("W K^-1 m^-1").code);
+    }
+    THEN("whole symbols are matched before prefixed ones") {
+      REQUIRE(parse_unit("min").code.time == Rational{1});
+      REQUIRE(parse_unit("mol").code.amount == Rational{1});
+      REQUIRE(parse_unit("mmol").code.prefix == Rational{1, 1000});
+      REQUIRE(parse_unit("cd").code.luminosity == Rational{1});
+      REQUIRE(parse_unit("µm").code == parse_unit("um").code);
+    }
+    THEN("an empty string is dimensionless") {
+      REQUIRE(parse_unit("").ec == std::errc{});
+      REQUIRE(parse_unit("").code == DimensionCode{});
+      REQUIRE(parse_unit("m/m").code == DimensionCode{});
+    }
+  }
+
+  GIVEN("strings that aren't units") {
+    THEN("invalid_argument is returned with the position of the error") {
+      auto r = parse_unit("kg furlong");
+      REQUIRE(r.ec == std::errc::invalid_argument);
+      REQUIRE(r.position == 3);
+      REQUIRE(r.code == DimensionCode{});
+      for (auto s : {"m^", "m^x", "(m", "m)", "m//s", "m^(1/0)", "0 m",
+                     "m⁻", "e3 m", "m 2"}) {
+        INFO(s);
+        REQUIRE(parse_unit(s).ec == std::errc::invalid_argument);
+      }
+    }
+    THEN("result_out_of_range is returned if the scale overflows or is "
+         "irrational") {
+      REQUIRE(parse_unit("Gm^99").ec == std::errc::result_out_of_range);
+      REQUIRE(parse_unit("km^0.5").ec == std::errc::result_out_of_range);
+      REQUIRE(parse_unit("99999999999999999999 m").ec ==
+              std::errc::result_out_of_range);
+      REQUIRE(parse_unit("m^99999999999999999999").ec ==
+              std::errc::result_out_of_range);
+    }
+    THEN("huge powers and roots fail at once rather than hang") {
+      static_assert(parse_unit("mm^(1/99999999999)").ec ==
+                    std::errc::result_out_of_range);
+      REQUIRE(parse_unit("mm^(1/64)").ec == std::errc::result_out_of_range);
+      REQUIRE(parse_unit("mm^99999999999").ec ==
+              std::errc::result_out_of_range);
+      REQUIRE(parse_unit("m^(1/99999999999)").code.length ==
+              Rational{1, 99'999'999'999});
+      REQUIRE(parse_unit("Mm^(1/2)").code.prefix == PrefixValue{1000});
+    }
+  }
+}
+
+SCENARIO("Formatting units as strings that parse back") {
+  using namespace units;
+  GIVEN("units with a symbol") {
+    THEN("the symbol is used") {
+      REQUIRE(format_unit(km_t::code) == "km");
+      REQUIRE(format_unit(kg_t::code) == "kg");
+      REQUIRE(format_unit(nanoseconds_t::code) == "ns");
+      REQUIRE(format_unit(minutes_t::code) == "min");
+      REQUIRE(format_unit(Pascals_t::code) == "Pa");
+      REQUIRE(format_unit(litres_t::code) == "L");
+      REQUIRE(format_unit(days_t::code) == "d");
+      REQUIRE(format_unit(us_gallon_t::code) == "US gal");
+      REQUIRE(format_unit(DimensionCode{}) == "");
+    }
+  }
+  GIVEN("units without one") {
+    THEN("the base units are written out after the scale") {
+      REQUIRE(format_unit(metres_per_sec2_t::code) == "m s^-2");
+      REQUIRE(format_unit(MPam05_t::code) == "1e6 m^(-1/2) kg s^-2");
+      REQUIRE(format_unit(parse_unit("2 US gal").code) ==
+              "75708236e-10 m^3");
+      REQUIRE(format_unit(parse_unit("2 d").code) == "172800 s");
+    }
+    THEN("they parse back to the same code") {
+      for (auto s : {"km/s^2", "mm^2", "ms^-1", "cd/m^2", "Gm^(1/3) K^-2",
+                     "2.5 mol", "kg m^2 s^-2"}) {
+        const auto code = parse_unit(s).code;
+        INFO(s << " " << format_unit(code));
+        REQUIRE(parse_unit(format_unit(code)).code == code);
+      }
+    }
+    THEN("scales without an exact decimal are written as fractions") {
+      REQUIRE(format_unit(parse_unit("km/h").code) == "5/18 m s^-1");
+      REQUIRE(parse_unit("5/18 m/s").code == parse_unit("km/h").code);
+      REQUIRE(parse_unit("5/0 m").ec == std::errc::invalid_argument);
+    }
+  }
+  GIVEN("the other styles") {
+    THEN("powers are superscripts") {
+      REQUIRE(format_unit(Joules_t::code, UnitStyle::si) == "J");
+      REQUIRE(format_unit(metres_per_sec2_t::code, UnitStyle::si) ==
+              "m s⁻²");
+      REQUIRE(format_unit(metres_per_sec2_t::code, UnitStyle::unicode) ==
+              "m·s⁻²");
+      REQUIRE(format_unit(MPam05_t::code, UnitStyle::unicode) ==
+              "1e6 m^(-1/2)·kg·s⁻²");
+      REQUIRE(format_unit(metres05_t::code, UnitStyle::si) == "√m");
+      REQUIRE(format_unit(parse_unit("um").code, UnitStyle::si) == "µm");
+      REQUIRE(format_unit(parse_unit("um").code) == "um");
+    }
+    THEN("they parse back too") {
+      for (auto s : {"km/s^2", "Gm^(1/3) K^-2", "m^12 s^-10", "√kg/s"}) {
+        const auto code = parse_unit(s).code;
+        for (auto style : {UnitStyle::unicode, UnitStyle::si}) {
+          INFO(s << " " << format_unit(code, style));
+          REQUIRE(parse_unit(format_unit(code, style)).code == code);
+        }
+      }
+      static_assert(
+          Impl::format_unit_string(km_t::code, UnitStyle::si).view() == "km");
+    }
+  }
+}
+
+SCENARIO("Profiling parse_unit", "[Profile]") {
+  GIVEN("a file's worth of column headers") {
+    auto headers = std::vector<std::string>{};
+    for (auto i = 0; i < 100'000; ++i) {
+      headers.push_back(i % 3 == 0   ? "kg m^2 s^-2"
+                        : i % 3 == 1 ? "MPa m^0.5"
+                                     : "km/h");
+    }
+    auto total = units::Rational{};
+    BENCHMARK("parse_unit") {
+      for (const auto& h : headers) {
+        total = total + units::parse_unit(h).code.length;
+      }
+    }
+    std::cout << total.num << "\n";
+  }
+}
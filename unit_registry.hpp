@@ -0,0 +1,227 @@
+#pragma once
+
+#include "common_units.hpp"
+#include "conversion_factor.hpp"
+#include "derived_dimensions_impl.hpp"
+#include "dispatch.hpp"
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <optional>
+#include <span>
+#include <string_view>
+
+// ************************************************************************* /
+//    A registry of the units in common_units.hpp, looked up by name (the    /
+//    alias without _t, e.g. "hectare") or symbol ("ha") at runtime. It is   /
+//    all constexpr, so there is no heap allocation and nothing to run at    /
+//    startup, and lookups are a perfect hash: one hash, one table read and  /
+//    one string compare.                                                    /
+// ************************************************************************* /
+
+namespace units {
+  /** A registered unit. code.prefix is the exact factor to SI, and index is
+   * the position in registered_units(). */
+  struct UnitInfo {
+    std::string_view name;
+    std::string_view symbol;
+    DimensionCode code;
+    std::size_t index;
+  };
+
+  namespace Impl {
+    constexpr std::uint64_t fnv1a(std::string_view s) {
+      auto h = std::uint64_t{0xCBF29CE484222325};
+      for (auto c : s) {
+        h = (h ^ static_cast<unsigned char>(c)) * 0x100000001B3;
+      }
+      return h;
+    }
+
+#define UNITS_REGISTRY_ENTRY(NAME, SYMBOL)                                     \
+  UnitInfo{#NAME, SYMBOL, NAME##_t::code, 0},
+
+    inline constexpr auto registered_units = [] {
+      const UnitInfo entries[] = {UNITS_COMMON_UNITS(UNITS_REGISTRY_ENTRY)};
+      auto a = std::array<UnitInfo, std::size(entries)>{};
+      for (auto i = std::size_t{}; i < a.size(); ++i) {
+        a[i] = entries[i];
+        a[i].index = i;
+      }
+      return a;
+    }();
+
+#undef UNITS_REGISTRY_ENTRY
+
+    inline constexpr auto registry_size = std::size(registered_units);
+
+    /// A name or symbol, and the index of its unit
+    struct RegistryKey {
+      std::string_view key;
+      std::size_t index;
+    };
+
+    // every name, and every symbol that isn't also the unit's name
+    inline constexpr auto registry_key_count = [] {
+      auto n = registry_size;
+      for (const auto& u : registered_units) {
+        n += u.symbol != u.name ? 1 : 0;
+      }
+      return n;
+    }();
+
+    inline constexpr auto registry_keys = [] {
+      auto keys = std::array<RegistryKey, registry_key_count>{};
+      auto n = std::size_t{};
+      for (const auto& u : registered_units) {
+        keys[n++] = {u.name, u.index};
+        if (u.symbol != u.name) {
+          keys[n++] = {u.symbol, u.index};
+        }
+      }
+      return keys;
+    }();
+
+    /** A perfect hash by hash and displace: a key's bucket is the low bits
+     * of its hash, and each bucket has a seed, found at compile time, that
+     * mixes the hashes of its keys into otherwise empty slots. */
+    struct PerfectHash {
+      static constexpr std::size_t slot_count =
+          std::bit_ceil(2 * registry_key_count);
+      static constexpr std::size_t bucket_count = slot_count / 4;
+      static constexpr auto empty = std::numeric_limits<std::uint16_t>::max();
+
+      // index into registry_keys, or empty
+      std::array<std::uint16_t, slot_count> slots{};
+      std::array<std::uint16_t, bucket_count> seeds{};
+      // false if a bucket had no seed that fit
+      bool complete = true;
+
+      static constexpr std::size_t bucket(std::uint64_t h) {
+        return h & (bucket_count - 1);
+      }
+
+      static constexpr std::size_t slot(std::uint64_t h, std::uint16_t seed) {
+        return mix(h + seed) & (slot_count - 1);
+      }
+    };
+
+    inline constexpr auto registry_hash = [] {
+      auto ph = PerfectHash{};
+      for (auto& s : ph.slots) {
+        s = PerfectHash::empty;
+      }
+      // fill the fullest buckets first, while there are the most free slots
+      auto order = std::array<std::size_t, PerfectHash::bucket_count>{};
+      auto sizes = std::array<std::size_t, PerfectHash::bucket_count>{};
+      for (const auto& k : registry_keys) {
+        ++sizes[PerfectHash::bucket(fnv1a(k.key))];
+      }
+      for (auto b = std::size_t{}; b < order.size(); ++b) {
+        auto i = b;
+        for (; i > 0 && sizes[order[i - 1]] < sizes[b]; --i) {
+          order[i] = order[i - 1];
+        }
+        order[i] = b;
+      }
+      for (auto b : order) {
+        for (auto seed = std::uint16_t{};; ++seed) {
+          if (seed == PerfectHash::empty) {
+            ph.complete = false;
+            break;
+          }
+          auto slots = ph.slots;
+          auto ok = true;
+          for (auto k = std::size_t{}; ok && k < registry_key_count; ++k) {
+            const auto h = fnv1a(registry_keys[k].key);
+            if (PerfectHash::bucket(h) != b) {
+              continue;
+            }
+            auto& slot = slots[PerfectHash::slot(h, seed)];
+            ok = slot == PerfectHash::empty;
+            slot = static_cast<std::uint16_t>(k);
+          }
+          if (ok) {
+            ph.slots = slots;
+            ph.seeds[b] = seed;
+            break;
+          }
+        }
+      }
+      return ph;
+    }();
+
+    static_assert(registry_hash.complete);
+
+    constexpr bool registry_keys_unique() {
+      for (auto i = std::size_t{}; i < registry_key_count; ++i) {
+        for (auto j = std::size_t{}; j < i; ++j) {
+          if (registry_keys[i].key == registry_keys[j].key) {
+            return false;
+          }
+        }
+      }
+      return true;
+    }
+    static_assert(registry_keys_unique(),
+                  "each name and symbol can only be registered once");
+
+    // factors[from][to] converts a value in from to to, NaN if the
+    // dimensions are different
+    inline constexpr auto registry_factors = [] {
+      auto f = std::array<std::array<double, registry_size>, registry_size>{};
+      for (const auto& from : registered_units) {
+        for (const auto& to : registered_units) {
+          const auto r = from.code.prefix / to.code.prefix;
+          f[from.index][to.index] =
+              from.code.same_dimension(to.code)
+                  ? rounded_prefix<double>(r)
+                  : std::numeric_limits<double>::quiet_NaN();
+        }
+      }
+      return f;
+    }();
+  } // namespace Impl
+
+  /// All the registered units, in the order of UNITS_COMMON_UNITS
+  constexpr std::span<const UnitInfo> registered_units() {
+    return {Impl::registered_units};
+  }
+
+  /// The unit with the name or symbol s, or nullptr if there isn't one
+  constexpr const UnitInfo* find_registered_unit(std::string_view s) {
+    using Impl::registry_hash;
+    const auto h = Impl::fnv1a(s);
+    const auto seed = registry_hash.seeds[Impl::PerfectHash::bucket(h)];
+    const auto k = registry_hash.slots[Impl::PerfectHash::slot(h, seed)];
+    if (k == Impl::PerfectHash::empty || Impl::registry_keys[k].key != s) {
+      return nullptr;
+    }
+    return &Impl::registered_units[Impl::registry_keys[k].index];
+  }
+
+  /** The factor converting a value in from to a value in to, rounded once
+   * from the exact ratio, or nullopt if they have different dimensions. */
+  constexpr std::optional<double> unit_conversion_factor(const UnitInfo& from,
+                                                         const UnitInfo& to) {
+    if (!from.code.same_dimension(to.code)) {
+      return std::nullopt;
+    }
+    return Impl::registry_factors[from.index][to.index];
+  }
+
+  /// As above, by name or symbol. nullopt if either isn't registered.
+  constexpr std::optional<double> unit_conversion_factor(std::string_view from,
+                                                         std::string_view to) {
+    const auto f = find_registered_unit(from);
+    const auto t = find_registered_unit(to);
+    if (f == nullptr || t == nullptr) {
+      return std::nullopt;
+    }
+    return unit_conversion_factor(*f, *t);
+  }
+} // namespace units
@@ -0,0 +1,91 @@
+#include "common_quantities.hpp"
+#include "quantity_cast.hpp"
+#include "unit_parser.hpp"
+#include "unit_registry.hpp"
+#include <catch.hpp>
+
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <vector>
+
+SCENARIO("Looking up the common units by name at runtime") {
+  using namespace units;
+  GIVEN("the names and symbols of the common units") {
+    THEN("they are found with the code of their alias") {
+      REQUIRE(find_registered_unit("hectare")->code == hectare_t::code);
+      REQUIRE(find_registered_unit("ha")->code == hectare_t::code);
+      REQUIRE(find_registered_unit("us_gallon")->code == us_gallon_t::code);
+      REQUIRE(find_registered_unit("MPam05")->code == MPam05_t::code);
+      REQUIRE(find_registered_unit("MPa m^0.5")->name == "MPam05");
+      REQUIRE(find_registered_unit("kg")->symbol == "kg");
+      static_assert(find_registered_unit("km")->code == km_t::code);
+    }
+    THEN("every name and symbol finds its own unit") {
+      for (const auto& u : registered_units()) {
+        INFO(u.name);
+        REQUIRE(find_registered_unit(u.name) == &u);
+        REQUIRE(find_registered_unit(u.symbol) == &u);
+      }
+    }
+    THEN("the symbols parse to the same code, prefix included") {
+      for (const auto& u : registered_units()) {
+        INFO(u.name);
+        const auto r = parse_unit(u.symbol);
+        REQUIRE(r.ec == std::errc{});
+        REQUIRE(r.code == u.code);
+      }
+    }
+    THEN("the rates are the reciprocals of the times") {
+      REQUIRE(unit_conversion_factor("1/min", "1/s") == 1.0 / 60);
+      REQUIRE(unit_conversion_factor("1/s", "1/h") == 3600);
+      REQUIRE(unit_conversion_factor("1/d", "1/h") == 1.0 / 24);
+      REQUIRE(unit_conversion_factor("ac", "m^2") == 4046.8564224);
+    }
+    THEN("other strings are not found") {
+      REQUIRE(find_registered_unit("") == nullptr);
+      REQUIRE(find_registered_unit("furlong") == nullptr);
+      REQUIRE(find_registered_unit("hectares") == nullptr);
+      REQUIRE(find_registered_unit("Kg") == nullptr);
+    }
+  }
+
+  GIVEN("two registered units") {
+    THEN("the conversion factor is the ratio of their prefixes") {
+      REQUIRE(unit_conversion_factor("hectare", "metres2") == 10'000);
+      REQUIRE(unit_conversion_factor("km", "mm") == 1e6);
+      REQUIRE(unit_conversion_factor("mm", "km") == 1e-6);
+      REQUIRE(unit_conversion_factor("h", "min") == 60);
+      REQUIRE(unit_conversion_factor("US gal", "L") == 3.7854118);
+      REQUIRE(unit_conversion_factor("J", "J") == 1);
+      REQUIRE(unit_conversion_factor("N", "kg_metres_per_sec2") == 1);
+      static_assert(unit_conversion_factor("days", "hours") == 24);
+    }
+    THEN("it converts values as the static Quantities do") {
+      const auto f = *unit_conversion_factor("imp_gallon", "litres");
+      REQUIRE(quantity_cast<litres>(imp_gallon{3}).underlying_value() ==
+              3 * f);
+    }
+    THEN("there is no factor between different dimensions") {
+      REQUIRE(!unit_conversion_factor("km", "s"));
+      REQUIRE(!unit_conversion_factor("km", "furlong"));
+    }
+  }
+}
+
+SCENARIO("Profiling find_registered_unit", "[Profile]") {
+  GIVEN("a config file's worth of unit names") {
+    auto names = std::vector<std::string>{};
+    for (auto i = 0; i < 10'000; ++i) {
+      const auto& u = units::registered_units()[i % 33];
+      names.emplace_back(i % 2 == 0 ? u.name : u.symbol);
+    }
+    auto total = std::size_t{};
+    BENCHMARK("find_registered_unit") {
+      for (const auto& n : names) {
+        total += units::find_registered_unit(n)->index;
+      }
+    }
+    std::cout << total << "\n";
+  }
+}
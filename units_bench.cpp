@@ -0,0 +1,266 @@
+// Runtime benchmarks of the Quantity operators and numeric functions against
+// the same calculation written with doubles. Each is run on a single value
+// (latency of one operation, inputs hidden from the optimiser) and on arrays
+// that fit in L1 and that only fit in memory.
+//
+//   units_bench [filter]   runs the benchmarks whose name contains filter
+
+#include "benchmark.hpp"
+#include "common_quantities.hpp"
+#include "numeric_functions.hpp"
+
+#include <cmath>
+#include <cstddef>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+namespace {
+  using namespace units::bench;
+
+  constexpr std::size_t array_sizes[] = {1'000, 1'000'000};
+
+  template <class T>
+  double raw(const T& v) {
+    if constexpr (std::is_arithmetic_v<T>) {
+      return static_cast<double>(v);
+    } else {
+      return v.underlying_value();
+    }
+  }
+
+  /// Comparisons return bool, which can't be stored in a std::vector<bool>
+  /// without bit packing
+  template <class T>
+  using storage_t = std::conditional_t<std::is_same_v<T, bool>, char, T>;
+
+  template <class T>
+  std::vector<T> make_inputs(std::size_t n, const T& v) {
+    auto out = std::vector<T>{};
+    out.reserve(n);
+    for (std::size_t i = 0; i < n; ++i) {
+      out.push_back(v * static_cast<int>(1 + i % 7));
+    }
+    return out;
+  }
+
+  template <class Op, class... Args>
+  Result time_scalar(const std::string& name, Op op, Args... args) {
+    return run(name, 1, 0, [&] {
+      auto inputs = std::tuple{args...};
+      std::apply([](auto&... x) { (do_not_optimise(x), ...); }, inputs);
+      auto z = std::apply(op, inputs);
+      do_not_optimise(z);
+    });
+  }
+
+  template <class Op, class... Args>
+  Result time_array(const std::string& name, std::size_t n, Op op,
+                    Args... args) {
+    using R = storage_t<decltype(op(args...))>;
+    const auto inputs = std::tuple{make_inputs(n, args)...};
+    auto out = std::vector<R>(n);
+    const auto bytes = n * ((sizeof(Args) + ...) + sizeof(R));
+    return run(name, n, bytes, [&] {
+      std::apply(
+          [&](const auto&... in) {
+            auto* pr = out.data();
+            auto ptrs = std::tuple{in.data()...};
+            std::apply([](auto&... p) { (do_not_optimise(p), ...); }, ptrs);
+            std::apply(
+                [&](auto... p) {
+                  for (std::size_t i = 0; i < n; ++i) {
+                    pr[i] = static_cast<R>(op(p[i]...));
+                  }
+                },
+                ptrs);
+            do_not_optimise(pr);
+          },
+          inputs);
+    });
+  }
+
+  /** Benchmark qop(args...) against dop(raw(args)...) where dop is the same
+   * calculation written by hand with doubles. */
+  template <class QOp, class DOp, class... Args>
+  void compare(Reporter& reporter, const std::string& name, QOp qop, DOp dop,
+               Args... args) {
+    if (!reporter.enabled(name)) {
+      return;
+    }
+    reporter.compare(time_scalar(name + " [scalar]", qop, args...),
+                     time_scalar(name + " [scalar]", dop, raw(args)...));
+    for (auto n : array_sizes) {
+      const auto label = name + " [" + std::to_string(n) + "]";
+      reporter.compare(time_array(label, n, qop, args...),
+                       time_array(label, n, dop, raw(args)...));
+    }
+  }
+
+  template <class A, class B, class QOp, class DOp>
+  void binary(Reporter& reporter, const std::string& name, A a, B b, QOp qop,
+              DOp dop) {
+    compare(reporter, name, qop, dop, a, b);
+  }
+
+  template <class A, class QOp, class DOp>
+  void unary(Reporter& reporter, const std::string& name, A a, QOp qop,
+             DOp dop) {
+    compare(reporter, name, qop, dop, a);
+  }
+} // namespace
+
+int main(int argc, char* argv[]) {
+  auto reporter = Reporter{argc > 1 ? argv[1] : ""};
+  reporter.header();
+
+  using dimensionless_ratio = decltype(metres{} / metres{});
+  constexpr auto k = 1000.;
+  const auto m = metres{1.5};
+  const auto m2 = metres{2.5};
+  const auto kilometres = km{0.5};
+
+  // Addition and subtraction
+  binary(
+      reporter, "a + b", m, m2, [](auto a, auto b) { return a + b; },
+      [](double a, double b) { return a + b; });
+  binary(
+      reporter, "a + b (km + m)", kilometres, m,
+      [](auto a, auto b) { return a + b; },
+      [=](double a, double b) { return a * k + b; });
+  binary(
+      reporter, "a - b", m, m2, [](auto a, auto b) { return a - b; },
+      [](double a, double b) { return a - b; });
+  binary(
+      reporter, "a - b (km - m)", kilometres, m,
+      [](auto a, auto b) { return a - b; },
+      [=](double a, double b) { return a * k - b; });
+  binary(
+      reporter, "a += b", m, m2,
+      [](auto a, auto b) {
+        a += b;
+        return a;
+      },
+      [](double a, double b) { return a += b; });
+  binary(
+      reporter, "a += b (m += km)", m, kilometres,
+      [](auto a, auto b) {
+        a += b;
+        return a;
+      },
+      [=](double a, double b) { return a += b * k; });
+  binary(
+      reporter, "a -= b", m, m2,
+      [](auto a, auto b) {
+        a -= b;
+        return a;
+      },
+      [](double a, double b) { return a -= b; });
+  unary(
+      reporter, "-a", m, [](auto a) { return -a; },
+      [](double a) { return -a; });
+
+  // Multiplication and division
+  binary(
+      reporter, "a * b", m, m2, [](auto a, auto b) { return a * b; },
+      [](double a, double b) { return a * b; });
+  binary(
+      reporter, "a * b (km * m)", kilometres, m,
+      [](auto a, auto b) { return a * b; },
+      [=](double a, double b) { return a * k * b; });
+  binary(
+      reporter, "a / b", m, seconds{2}, [](auto a, auto b) { return a / b; },
+      [](double a, double b) { return a / b; });
+  binary(
+      reporter, "a / b (km / s)", kilometres, seconds{2},
+      [](auto a, auto b) { return a / b; },
+      [=](double a, double b) { return a * k / b; });
+  binary(
+      reporter, "a * double", m, 3.0, [](auto a, auto b) { return a * b; },
+      [](double a, double b) { return a * b; });
+  binary(
+      reporter, "a / double", m, 3.0, [](auto a, auto b) { return a / b; },
+      [](double a, double b) { return a / b; });
+  unary(
+      reporter, "int / a", m, [](auto a) { return 1 / a; },
+      [](double a) { return 1 / a; });
+  binary(
+      reporter, "a *= double", m, 3.0,
+      [](auto a, auto b) {
+        a *= b;
+        return a;
+      },
+      [](double a, double b) { return a *= b; });
+  binary(
+      reporter, "a /= double", m, 3.0,
+      [](auto a, auto b) {
+        a /= b;
+        return a;
+      },
+      [](double a, double b) { return a /= b; });
+  binary(
+      reporter, "a *= dimensionless", m, dimensionless_ratio{3.0},
+      [](auto a, auto b) {
+        a *= b;
+        return a;
+      },
+      [](double a, double b) { return a *= b; });
+
+  // Comparisons
+  binary(
+      reporter, "a == b", m, m2, [](auto a, auto b) { return a == b; },
+      [](double a, double b) { return a == b; });
+  binary(
+      reporter, "a == b (km == m)", kilometres, m,
+      [](auto a, auto b) { return a == b; },
+      [=](double a, double b) { return a * k == b; });
+  binary(
+      reporter, "a != b", m, m2, [](auto a, auto b) { return a != b; },
+      [](double a, double b) { return a != b; });
+  binary(
+      reporter, "a < b", m, m2, [](auto a, auto b) { return a < b; },
+      [](double a, double b) { return a < b; });
+  binary(
+      reporter, "a < b (km < m)", kilometres, m,
+      [](auto a, auto b) { return a < b; },
+      [=](double a, double b) { return a * k < b; });
+  binary(
+      reporter, "a <= b", m, m2, [](auto a, auto b) { return a <= b; },
+      [](double a, double b) { return a <= b; });
+  binary(
+      reporter, "a > b", m, m2, [](auto a, auto b) { return a > b; },
+      [](double a, double b) { return a > b; });
+  binary(
+      reporter, "a >= b", m, m2, [](auto a, auto b) { return a >= b; },
+      [](double a, double b) { return a >= b; });
+  binary(
+      reporter, "dimensionless > double", dimensionless_ratio{1.5}, 2.0,
+      [](auto a, auto b) { return a > b; },
+      [](double a, double b) { return a > b; });
+  binary(
+      reporter, "within(a, b, tol)", m, m2,
+      [](auto a, auto b) { return within(a, b, metres{0.5}); },
+      [](double a, double b) { return std::abs(a - b) <= 0.5; });
+
+  // Numeric functions
+  unary(
+      reporter, "pow<2>(a)", m, [](auto a) { return pow<2>(a); },
+      [](double a) { return a * a; });
+  unary(
+      reporter, "pow<3>(a)", m, [](auto a) { return pow<3>(a); },
+      [](double a) { return a * a * a; });
+  unary(
+      reporter, "pow<-1>(a)", m, [](auto a) { return pow<-1>(a); },
+      [](double a) { return 1 / a; });
+  unary(
+      reporter, "sqrt(a)", metres2{2.0}, [](auto a) { return std::sqrt(a); },
+      [](double a) { return std::sqrt(a); });
+  unary(
+      reporter, "abs(a)", -m, [](auto a) { return std::abs(a); },
+      [](double a) { return std::abs(a); });
+  unary(
+      reporter, "fabs(a)", -m, [](auto a) { return std::fabs(a); },
+      [](double a) { return std::fabs(a); });
+  return 0;
+}